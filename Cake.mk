@@ -5,3 +5,31 @@ AUTHOR  = Zakhary Kaplan <https://zakhary.dev>
 
 # Build
 CONFIG ?= BASIC
+
+# Flags
+LDFLAGS += -pthread
+
+# Install
+NOINSTALL = bin/mace-bench bin/mace-perf
+
+# Performance
+PERFDIR    = $(ROOT)/perf
+RUNS      ?= 5
+THRESHOLD ?= 20 # percent
+
+# Train profile-guided builds on the benchmark corpus
+TRAIN = for script in $(PERFDIR)/*.mace; do $(BIN)/mace $$script > $(DEVNULL); done
+
+# Compare corpus against baseline, in a release build
+.PHONY: perf
+perf: export CONFIG = RELEASE
+perf:
+	@$(MAKE) bin
+	@$(BIN)/mace-perf -r $(RUNS) -t $(THRESHOLD) $(PERFDIR)/baseline.tsv $(PERFDIR)/*.mace
+
+# Record a new baseline
+.PHONY: perf-baseline
+perf-baseline: export CONFIG = RELEASE
+perf-baseline:
+	@$(MAKE) bin
+	@$(BIN)/mace-perf -r $(RUNS) -u $(PERFDIR)/baseline.tsv $(PERFDIR)/*.mace
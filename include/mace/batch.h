@@ -0,0 +1,37 @@
+// File:        batch.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "matrix.h"
+
+#define NULL_BATCH \
+    (Batch) {      \
+        0, 0, 0, 0 \
+    }
+
+// Declare batch structure (structure of arrays)
+//
+// Element (i, j) of matrix k is stored at data[(i * n + j) * count + k], so
+// that kernels stream contiguously across the batch dimension.
+typedef struct batch {
+    int count, m, n;
+    double *data;
+} Batch;
+
+// Function prototypes
+Batch emptyBatch(int, int, int);
+void deleteBatch(Batch *);
+int isNullBatch(Batch);
+// Conversions
+Batch matToBatch(Matrix, int);
+Matrix batchToMat(Batch);
+// Batched Operations
+Batch mulMatBatched(Batch, Batch);
+Batch inverseBatched(Batch);
+Batch detBatched(Batch);
+
+#endif
@@ -0,0 +1,75 @@
+// File:        cache.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "checkpoint.h"
+#include "matrix.h"
+#include "reduce.h"
+#include "share.h"
+#include "structure.h"
+
+// Memoized quantities
+#define CACHE_DET (1 << 0)
+#define CACHE_TRC (1 << 1)
+#define CACHE_LU (1 << 2)
+#define CACHE_INV (1 << 3)
+#define CACHE_TRNSP (1 << 4)
+#define CACHE_RCOND (1 << 5)
+#define CACHE_NORMS (1 << 6)
+#define CACHE_STRUCT (1 << 7)
+
+// Declare cache structure
+typedef struct cache {
+    unsigned version; // version of matrix when cache was populated
+    unsigned valid;   // bitmask of memoized quantities
+    double det, trc, rcond;
+    double norms[NORMS];
+    Structure structure;
+    Matrix lu;       // combined LU factors
+    int *perm, sign; // row permutation of LU factors
+    Matrix inv, trnsp;
+} Cache;
+
+// Declare workspace entry structure
+typedef struct entry {
+    Matrix mat;
+    Mapping map;      // shared segment or checkpoint backing the matrix
+    Packed packed;    // restored matrix, unpacked on first use
+    unsigned version; // incremented on every mutation
+    Cache cache;
+} Entry;
+
+// Declare memory footprint structure
+typedef struct footprint {
+    size_t matrix, cache; // bytes allocated
+    size_t mapped;        // bytes of shared segment or checkpoint
+    size_t packed;        // bytes of compressed matrix
+    int shared;           // matrix is shared with another entry
+} Footprint;
+
+// Function prototypes
+Entry newEntry(Matrix);
+void deleteEntry(Entry *);
+Entry borrowEntry(Entry *);
+void mergeEntry(Entry *, Entry *);
+int ownEntry(Entry *);
+void updateEntry(Entry *, const double[], const double[]);
+void touchEntry(Entry *);
+void clearCache(Cache *);
+Footprint entryFootprint(const Entry *);
+// Memoized Operations
+Matrix cachedLU(Entry *, int **, int *);
+Matrix cachedInverse(Entry *);
+Matrix cachedTranspose(Entry *);
+double cachedDeterminant(Entry *);
+double cachedTrace(Entry *);
+double cachedRcond(Entry *);
+double cachedNorm(Entry *, Norm);
+Structure cachedStructure(Entry *);
+void setStructure(Entry *, Structure);
+
+#endif
@@ -0,0 +1,43 @@
+// File:        checkpoint.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+
+#include "matrix.h"
+#include "share.h"
+
+#define CHECKPOINT_ANS -1 // slot of ans within a checkpoint
+
+// Declare packed matrix structure
+//
+// Packed matrices hold compressed blocks in a reference counted
+// allocation, so borrowed entries share them until decoded.
+typedef struct packed {
+    int m, n;
+    unsigned char *data;
+    size_t size;
+} Packed;
+
+// Declare restored matrix structure
+//
+// Uncompressed matrices are mapped from the checkpoint copy-on-write, so
+// pages are only read on first access. Compressed matrices stay packed.
+typedef struct restored {
+    int slot;
+    Matrix mat; // null while packed
+    Mapping map;
+    Packed packed;
+} Restored;
+
+// Function prototypes
+int saveCheckpoint(const char *, const Matrix[], const int[], int, int);
+int loadCheckpoint(const char *, Restored[], int);
+Matrix unpackMat(const Packed *);
+void deletePacked(Packed *);
+
+#endif
@@ -0,0 +1,16 @@
+// File:        compress.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stddef.h>
+
+// Function prototypes
+size_t packBound(size_t);
+size_t packDoubles(const double *, size_t, unsigned char *, size_t);
+int unpackDoubles(const unsigned char *, size_t, double *, size_t);
+
+#endif
@@ -0,0 +1,44 @@
+// File:        iterative.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef ITERATIVE_H
+#define ITERATIVE_H
+
+#include "matrix.h"
+#include "structure.h"
+
+// Declare iterative methods
+typedef enum method {
+    METHOD_CG,    // conjugate gradient, for symmetric positive definite matrices
+    METHOD_GMRES, // restarted generalized minimal residual
+} Method;
+
+// Declare preconditioners
+typedef enum preconditioner {
+    PRECONDITIONER_NONE,
+    PRECONDITIONER_JACOBI, // inverse of the diagonal
+    PRECONDITIONER_ILU,    // incomplete LU factors, on the nonzeros of the matrix
+} Preconditioner;
+
+// Declare iteration structure
+//
+// Each column of the right-hand side is solved until its residual,
+// relative to that column, falls below the tolerance, or the iteration
+// limit is reached. GMRES restarts after every restart iterations. Once
+// solved, the iterations taken by the slowest column, the largest relative
+// residual, and the time taken are recorded.
+typedef struct iteration {
+    double tolerance;
+    int limit, restart;
+    Preconditioner preconditioner;
+    int iterations;
+    double residual;
+    double seconds;
+} Iteration;
+
+// Function prototypes
+Matrix iterativeSolve(Method, Matrix, Structure, Matrix, Iteration *);
+
+#endif
@@ -6,34 +6,130 @@
 #ifndef MACE_H
 #define MACE_H
 
+#include "cache.h"
+#include "iterative.h"
+#include "map.h"
 #include "matrix.h"
+#include "pool.h"
+#include "reduce.h"
+#include "runtime.h"
+#include "share.h"
+#include "structure.h"
+#include "topology.h"
 
-#define MAX 100
 #define WORKSPACE_SIZE 64
 #define ANS -99
 
+// Declare status codes
+typedef enum status {
+    MACE_OK,        // success
+    MACE_EARG,      // invalid argument
+    MACE_EDIM,      // incompatible dimensions
+    MACE_ESQUARE,   // non-square matrix
+    MACE_ESINGULAR, // non-invertible matrix
+    MACE_EFULL,     // workspace is full
+    MACE_EEMPTY,    // operand not recognized
+    MACE_ENOANS,    // ans used before any operation
+    MACE_ESHARED,   // shared matrix unavailable
+    MACE_ECANCELED, // operation cancelled
+    MACE_EILLCOND,  // matrix singular to working precision
+    MACE_EIO,       // file unreadable or unwritable
+    MACE_ENOMEM,    // memory budget exceeded
+} Status;
+
+// Declare batch operations
+typedef enum batchOp {
+    BATCH_MUL,
+    BATCH_INV,
+    BATCH_DET,
+} BatchOp;
+
+// Declare context structure
+//
+// A context owns a workspace of matrices, and the allocator and thread pool
+// used by every operation on it. Results of operations replace ans. Matrices
+// allocated within a context must not outlive it.
+//
+// A fork is a context holding a snapshot of another's workspace, sharing
+// its matrices without copying them. A fork may be used on another thread
+// while its parent continues, and must be deleted before its parent.
+// Adopting a fork moves the entries it added, and its ans if replaced, into
+// the parent, along with the quantities it derived from matrices both still
+// hold, such as factors. Adopting its caches takes those quantities alone.
+// Entries updated in place are copied first if shared, so
+// updates are never seen by forks.
+// Cancelling a context makes its running and future operations fail.
+// The precision and placement of a context apply to its operations, and are
+// inherited by its forks. So is its profile, which records counters for the
+// kernels run by its operations once enabled, and its memory budget, which
+// defaults to physical memory. Operations whose results would exceed the
+// budget fail without replacing ans.
+typedef struct context Context;
+
 // Function prototypes
-void mace(void);
-// Secondary functions
-int validateInput(char *[]);
-void printEntry(int, Matrix[], int);
-void printAns(Matrix);
-void addToWorkspace(int *, Matrix[], Matrix);
-int tagExists(int *, char *[], char[]);
-// Commands
-void help(char[]);
-void print(char[], int, Matrix[], Matrix);
-void clr(int *, Matrix[], Matrix *);
-Matrix mat(char[], Matrix);
-Matrix ident(char input[]);
-Matrix zeros(char[]);
-Matrix add(char[], Matrix[], Matrix);
-Matrix sub(char[], Matrix[], Matrix);
-Matrix mul(char[], Matrix[], Matrix);
-Matrix scl(char[], Matrix[], Matrix);
-Matrix trnsp(char[], Matrix[], Matrix);
-Matrix inv(char[], Matrix[], Matrix);
-Matrix det(char[], Matrix[], Matrix);
-Matrix trc(char[], Matrix[], Matrix);
+Context *newContext(const Allocator *, Pool *);
+void deleteContext(Context *);
+const char *maceStrerror(Status);
+void *maceUserData(Context *);
+void maceSetUserData(Context *, void *);
+Precision macePrecision(Context *);
+void maceSetPrecision(Context *, Precision);
+Placement macePlacement(Context *);
+void maceSetPlacement(Context *, Placement);
+Profile *maceProfile(Context *);
+Status maceSetProfiling(Context *, int);
+void maceSetBudget(Context *, size_t);
+void maceMemory(Context *, size_t *, size_t *, size_t *);
+// Concurrency
+Context *maceFork(Context *);
+Status maceAdopt(Context *, Context *);
+void maceAdoptCaches(Context *, Context *);
+Status maceBorrowAns(Context *, Context *);
+void maceCancel(Context *);
+// Workspace
+int maceSize(Context *);
+Status maceGet(Context *, int, Matrix *);
+Status maceStructure(Context *, int, Structure *);
+Status maceFootprint(Context *, int, Footprint *);
+Status maceStore(Context *, Matrix, int *);
+Status maceCopy(Context *, int, int *);
+void maceClear(Context *);
+// Sharing
+Status maceShare(Context *, int, const char *);
+Status maceAttach(Context *, const char *, int *);
+Status maceUnshare(Context *, const char *);
+// Checkpoints
+Status maceCheckpoint(Context *, const char *, int);
+Status maceRestore(Context *, const char *);
+// Constructors
+Status maceIdent(Context *, int, int *);
+Status maceZeros(Context *, int, int, int *);
+Status maceParse(Context *, const char *, size_t, int *);
+Status maceLoad(Context *, const char *, int *);
+// Updates
+Status maceSet(Context *, int, int, int, double);
+Status maceSetRow(Context *, int, int, int);
+Status maceSetCol(Context *, int, int, int);
+Status maceUpdate(Context *, int, int, int);
+// Operations
+Status maceAdd(Context *, int, int);
+Status maceSub(Context *, int, int);
+Status maceMap(Context *, const Map *, const int[]);
+Status maceMul(Context *, int, int);
+Status maceKron(Context *, int, int);
+Status maceKronMul(Context *, int, int, int);
+Status maceHadamard(Context *, int, int);
+Status maceOuter(Context *, int, int);
+Status maceScl(Context *, double, int);
+Status maceTrnsp(Context *, int);
+Status maceInv(Context *, int);
+Status maceSolve(Context *, int, int);
+Status maceIterate(Context *, Method, int, int, Iteration *);
+Status maceDet(Context *, int);
+Status maceTrc(Context *, int);
+Status maceCond(Context *, int);
+Status maceReduce(Context *, unsigned, Axis, int);
+Status maceNorm(Context *, unsigned, Axis, int);
+Status maceBatch(Context *, BatchOp, int, int);
 
 #endif
@@ -0,0 +1,63 @@
+// File:        map.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef MAP_H
+#define MAP_H
+
+#include "matrix.h"
+
+#define MAP_LENGTH 64  // instructions per map
+#define MAP_DEPTH 8    // values held at once
+#define MAP_OPERANDS 16
+
+// Declare elementwise operations
+typedef enum op {
+    // Values
+    OP_LOAD,  // push an operand
+    OP_CONST, // push a constant
+    // Unary
+    OP_NEG,
+    OP_ABS,
+    OP_EXP,
+    OP_LOG,
+    OP_SQRT,
+    // Binary
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MIN,
+    OP_MAX,
+    OP_LT, // comparisons are 1 where true, and 0 elsewhere
+    OP_GT,
+    OP_EQ,
+} Op;
+
+// Declare instruction structure
+typedef struct instr {
+    Op op;
+    int operand;  // OP_LOAD
+    double value; // OP_CONST
+} Instr;
+
+// Declare map structure
+//
+// A map is a program of elementwise operations on a stack of values, in
+// postfix order, evaluated in a single pass over its operands. Operands
+// are broadcast to the shape of the result: those with a single row are
+// repeated down every row, those with a single column across every column.
+typedef struct map {
+    int length, operands;
+    Instr code[MAP_LENGTH];
+} Map;
+
+// Function prototypes
+int mapLoad(Map *, int);
+int mapConst(Map *, double);
+int mapOp(Map *, Op);
+int mapShape(const Map *, const Matrix[], int *, int *);
+Matrix evalMap(const Map *, const Matrix[]);
+
+#endif
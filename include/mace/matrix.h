@@ -6,6 +6,12 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <float.h>
+#include <stddef.h>
+
+// Reciprocal condition below which matrices are singular to working precision
+#define RCOND_MIN DBL_EPSILON
+
 #define NULL_MATRIX \
     (Matrix) {      \
         0, 0, 0     \
@@ -20,16 +26,26 @@ typedef struct matrix {
 // Function prototypes
 Matrix identityMat(int);
 Matrix emptyMat(int, int);
+size_t sizeMat(int, int);
 Matrix doubleToMat(double);
 Matrix copyMat(Matrix);
+Matrix retainMat(Matrix);
 void deleteMat(Matrix *);
-void printMat(Matrix);
 int isNull(Matrix);
 int isSquare(Matrix);
 // Unary Operations
 Matrix transpose(Matrix);
+// Null when singular to working precision (reciprocal condition below RCOND_MIN)
 Matrix inverse(Matrix);
 Matrix minor(Matrix, int, int);
+// Factorizations
+Matrix luDecomp(Matrix, int[], int *);
+Matrix luInverse(Matrix, int[]);
+double luDeterminant(Matrix, int);
+double luRcond(Matrix, int[], double);
+// Updates
+int luUpdate(Matrix, const int[], const double[], const double[]);
+int inverseUpdate(Matrix, const double[], const double[], double *);
 // Binary Operations
 Matrix coeffMat(double, Matrix);
 Matrix addMat(Matrix, Matrix);
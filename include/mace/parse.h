@@ -0,0 +1,17 @@
+// File:        parse.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef PARSE_H
+#define PARSE_H
+
+#include <stddef.h>
+
+#include "matrix.h"
+
+// Function prototypes
+Matrix parseMat(const char *, size_t);
+int loadMat(const char *, Matrix *);
+
+#endif
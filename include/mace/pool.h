@@ -0,0 +1,21 @@
+// File:        pool.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef POOL_H
+#define POOL_H
+
+// Declare thread pool structure
+typedef struct pool Pool;
+
+// Function prototypes
+Pool *newPool(int);
+void deletePool(Pool *);
+Pool *defaultPool(void);
+int poolSize(Pool *);
+// Scheduling
+void poolSubmit(Pool *, void (*)(void *), void *);
+void parallelFor(Pool *, int, int, void (*)(void *, int, int), void *);
+
+#endif
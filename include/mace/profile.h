@@ -0,0 +1,68 @@
+// File:        profile.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+// Declare profiled kernels
+typedef enum kernel {
+    KERNEL_TRNSP,
+    KERNEL_ADD,
+    KERNEL_SCL,
+    KERNEL_MUL,
+    KERNEL_LU,
+    KERNEL_LUINV,
+    KERNEL_TRC,
+    KERNEL_REDUCE,
+    KERNEL_MAP,
+    KERNEL_UPDATE,
+    KERNEL_SOLVE,
+    KERNEL_KRON,
+    KERNEL_HADAMARD,
+    KERNEL_ITERATE,
+    KERNEL_COUNT,
+} Kernel;
+
+// Declare counter totals
+typedef struct counters {
+    uint64_t calls;
+    uint64_t nanoseconds;
+    uint64_t cycles; // hardware counters, zero where unavailable
+    uint64_t instructions;
+    uint64_t cacheMisses; // last level cache
+    uint64_t cacheRefs;
+    uint64_t flops; // floating-point operations, by operation count
+} Counters;
+
+// Declare profile structure
+//
+// A profile accumulates counters for kernels run under a runtime that
+// refers to it, on any thread, while enabled. Hardware counters measure
+// user space on the calling thread. Kernels which call others are counted
+// inclusively.
+typedef struct profile Profile;
+
+// Declare probe structure, taken on entry to a kernel
+typedef struct probe {
+    Profile *profile; // null when not profiling
+    uint64_t start[5]; // time, then hardware counters
+} Probe;
+
+// Function prototypes
+Profile *newProfile(void);
+void deleteProfile(Profile *);
+void enableProfile(Profile *, int);
+int isProfiling(Profile *);
+void resetProfile(Profile *);
+void readProfile(Profile *, Counters[KERNEL_COUNT]);
+int hasCounters(void);
+const char *kernelName(Kernel);
+// Instrumentation
+Probe beginProbe(void);
+void endProbe(Probe *, Kernel, uint64_t);
+
+#endif
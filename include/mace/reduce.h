@@ -0,0 +1,48 @@
+// File:        reduce.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef REDUCE_H
+#define REDUCE_H
+
+#include "matrix.h"
+
+// Declare reduction axes
+typedef enum axis {
+    AXIS_ALL,  // reduce every entry, to a scalar
+    AXIS_ROWS, // reduce each row, to a column
+    AXIS_COLS, // reduce each column, to a row
+} Axis;
+
+// Declare reductions
+typedef enum reduction {
+    REDUCE_SUM,
+    REDUCE_MEAN,
+    REDUCE_MIN,
+    REDUCE_MAX,
+    REDUCTIONS,
+} Reduction;
+
+// Declare norms
+//
+// Along an axis, each row or column is normed as a vector, for which the
+// infinity and max norms coincide.
+typedef enum norm {
+    NORM_ONE, // largest absolute column sum
+    NORM_INF, // largest absolute row sum
+    NORM_FRO, // square root of sum of squares
+    NORM_MAX, // largest absolute entry
+    NORMS,
+} Norm;
+
+// Function prototypes
+//
+// Every output requested by a bitmask is computed in a single pass over the
+// matrix. Results hold one output per column, in order of declaration, or
+// per row when reducing columns.
+Matrix reduceMat(Matrix, Axis, unsigned);
+Matrix normsMat(Matrix, Axis, unsigned);
+double normMat(Matrix, Norm);
+
+#endif
@@ -0,0 +1,74 @@
+// File:        runtime.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "pool.h"
+#include "profile.h"
+#include "topology.h"
+
+// Declare allocator structure
+typedef struct allocator {
+    void *(*alloc)(void *, size_t);       // must return zeroed memory
+    void (*free)(void *, void *, size_t); // receives the allocated size
+    void *user;
+} Allocator;
+
+// Declare memory budget structure
+//
+// Every block allocated under a runtime is counted against its budget
+// until freed, on whichever thread. Matrices are refused once they would
+// exceed the limit; smaller blocks, such as vectors, are only counted.
+typedef struct budget {
+    size_t limit; // bytes, or zero for no limit
+    atomic_size_t used, peak;
+} Budget;
+
+// Declare precision modes
+typedef enum precision {
+    PRECISION_FAST,        // naive summation
+    PRECISION_COMPENSATED, // compensated sums, and pivoted factorizations
+} Precision;
+
+// Declare runtime structure
+//
+// A runtime is bound to the calling thread for the duration of a library
+// call, and determines where kernels allocate memory and schedule work.
+// Long-running kernels poll the cancellation flag, and return a null
+// result once it is set. Large blocks are placed across NUMA nodes by the
+// placement policy. Kernels record counters into the profile, if one is
+// enabled, and allocations against the budget, if one is set.
+typedef struct runtime {
+    const Allocator *allocator;
+    Pool *pool;
+    const atomic_int *cancel; // optional
+    Precision precision;
+    Placement placement;
+    Profile *profile; // optional
+    Budget *budget;   // optional
+} Runtime;
+
+// Function prototypes
+const Runtime *useRuntime(const Runtime *);
+const Runtime *currentRuntime(void);
+int isCancelled(void);
+Precision currentPrecision(void);
+Placement currentPlacement(void);
+Pool *currentPool(void);
+// Allocation
+void *maceAlloc(size_t);
+void *maceTryAlloc(size_t);
+int maceRefused(void);
+int isRefused(void);
+void *maceRetain(void *);
+int maceShared(const void *);
+size_t maceBlockSize(const void *);
+void maceFree(void *);
+
+#endif
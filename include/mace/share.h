@@ -0,0 +1,30 @@
+// File:        share.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef SHARE_H
+#define SHARE_H
+
+#include <stddef.h>
+
+#include "matrix.h"
+
+#define SHARE_NAME_MAX 64
+
+// Declare mapping structure
+//
+// Attached matrices are mapped copy-on-write: readers share the pages of the
+// segment until they write to them.
+typedef struct mapping {
+    void *addr;
+    size_t size;
+} Mapping;
+
+// Function prototypes
+int shareMat(Matrix, const char *);
+Matrix attachMat(const char *, Mapping *);
+int unshareMat(const char *);
+void unmapMat(Mapping *);
+
+#endif
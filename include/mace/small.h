@@ -0,0 +1,29 @@
+// File:        small.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef SMALL_H
+#define SMALL_H
+
+#include "matrix.h"
+
+#define SMALL_MAX 4
+
+// Declare small matrix structure (stack allocated)
+typedef struct small {
+    int m, n;
+    double data[SMALL_MAX][SMALL_MAX];
+} Small;
+
+// Function prototypes
+int isSmall(Matrix);
+Small toSmall(Matrix);
+void fromSmall(const Small *, Matrix);
+// Fixed-size Kernels
+void trnspSmall(const Small *, Small *);
+int invSmall(const Small *, Small *);
+void mulSmall(const Small *, const Small *, Small *);
+double detSmall(const Small *);
+
+#endif
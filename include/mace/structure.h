@@ -0,0 +1,38 @@
+// File:        structure.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef STRUCTURE_H
+#define STRUCTURE_H
+
+#include "matrix.h"
+
+// Declare structure
+//
+// Bandwidths bound the nonzero entries of a matrix: entry (i, j) is zero
+// unless -lower <= j - i <= upper. Diagonal, triangular and banded
+// matrices have a narrow band on one or both sides. Structures found by
+// scanning are exact; those carried through operations may overestimate
+// bandwidths, but never symmetry.
+typedef struct structure {
+    int lower, upper; // bandwidths
+    int symmetric;
+} Structure;
+
+// Function prototypes
+Structure findStructure(Matrix);
+int isBanded(Structure, Matrix);
+int isTriangular(Structure);
+// Propagation
+Structure transposeStructure(Structure);
+Structure inverseStructure(Structure, Matrix);
+Structure sumStructure(Structure, Structure);
+Structure productStructure(Structure, Structure, Matrix);
+// Structured Kernels
+Matrix structuredMul(Matrix, Structure, Matrix, Structure);
+Matrix structuredDecomp(Matrix, Structure, int[], int *);
+Matrix structuredInverse(Matrix, int[], Structure);
+Matrix structuredSolve(Matrix, int[], Matrix);
+
+#endif
@@ -0,0 +1,27 @@
+// File:        sum.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef SUM_H
+#define SUM_H
+
+#define LANES 4
+
+// Vector of lanes
+typedef double Lanes __attribute__((vector_size(LANES * sizeof(double))));
+
+// Accumulate a term (scalar or lanes) into a sum and its error
+#define ACCUMULATE(s, c, x)                 \
+    do {                                    \
+        __auto_type t = (s) + (x);          \
+        __auto_type z = t - (s);            \
+        (c) += ((s) - (t - z)) + ((x) - z); \
+        (s) = t;                            \
+    } while (0)
+
+// Function prototypes
+double sumCompensated(const double *, int);
+double dotCompensated(const double *, const double *, int);
+
+#endif
@@ -0,0 +1,22 @@
+// File:        target.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef TARGET_H
+#define TARGET_H
+
+// Performance builds compile hot kernels for several instruction sets,
+// selecting the best supported by the CPU when the library is loaded.
+// Native builds target the build machine directly instead.
+#if defined(PERF) && !defined(NATIVE) && defined(__x86_64__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define CLONES __attribute__((target_clones("default", "arch=x86-64-v3", "arch=x86-64-v4")))
+#endif
+#endif
+
+#ifndef CLONES
+#define CLONES
+#endif
+
+#endif
@@ -0,0 +1,17 @@
+// File:        tensor.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef TENSOR_H
+#define TENSOR_H
+
+#include "matrix.h"
+
+// Function prototypes
+Matrix kronMat(Matrix, Matrix);
+Matrix kronMulMat(Matrix, Matrix, Matrix);
+Matrix hadamardMat(Matrix, Matrix);
+Matrix outerMat(Matrix, Matrix);
+
+#endif
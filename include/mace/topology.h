@@ -0,0 +1,53 @@
+// File:        topology.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NODE_MAX 64  // NUMA nodes
+#define CPU_MAX 1024 // processors
+
+// Declare memory placement policies
+typedef enum placement {
+    PLACEMENT_LOCAL,      // pages on the node of the thread first touching them
+    PLACEMENT_INTERLEAVE, // pages spread across every node in turn
+} Placement;
+
+// Declare topology structure
+//
+// A topology groups the processors of the machine into NUMA nodes, as read
+// from sysfs. Setting MACE_NUMA to a node count, or to nodes x processors
+// per node (e.g. 2x4), simulates one instead. Simulated topologies split
+// work between nodes as real ones would, but never pin threads or bind
+// memory, so placement may be tested on single node machines.
+typedef struct topology {
+    int nodes, cpus;
+    int simulated;
+    int id[NODE_MAX];            // system identifier of each node
+    unsigned char node[CPU_MAX]; // node of each processor
+} Topology;
+
+// Declare per node chunk counters
+typedef struct placed {
+    uint64_t local;  // chunks run on the node they were assigned to
+    uint64_t stolen; // chunks taken from another node once idle
+} Placed;
+
+// Function prototypes
+const Topology *currentTopology(void);
+int workerNode(int, int);
+void bindNode(int);
+int currentNode(void);
+// Memory
+void placeMemory(void *, size_t, Placement);
+// Counters
+void countChunk(int, int);
+void readPlaced(Placed[NODE_MAX]);
+void resetPlaced(void);
+
+#endif
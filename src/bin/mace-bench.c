@@ -0,0 +1,347 @@
+// File:        mace-bench.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mace/matrix.h"
+#include "mace/profile.h"
+#include "mace/runtime.h"
+
+// Compares each precision on the same inputs. Errors are normwise,
+// relative to a long double reference, and times are per operation.
+// Counters are per operation, summed over the kernels which implement it.
+// With --json, results are written as an array of records instead of a
+// table, with null for unavailable hardware counters.
+
+#define MIN_TIME 0.2 // seconds spent timing each case
+
+static const char *const modes[] = {
+    [PRECISION_FAST] = "fast",
+    [PRECISION_COMPENSATED] = "compensated",
+};
+
+// -- Inputs --
+// Entries span many binades with mixed signs, so sums cancel
+static double wide(void) {
+    double u = 2.0 * rand() / RAND_MAX - 1.0;
+    return ldexp(u, rand() % 33 - 16);
+}
+
+static Matrix randomMat(int m, int n, double (*entry)(void)) {
+    Matrix A = emptyMat(m, n);
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++)
+            A.data[i][j] = entry();
+    }
+    return A;
+}
+
+static double uniform(void) {
+    return 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+// -- References --
+typedef long double Real;
+
+static Real *newReal(int m, int n) {
+    return calloc((size_t)m * n, sizeof(Real));
+}
+
+static Real *refMul(Matrix A, Matrix B) {
+    Real *C = newReal(A.m, B.n);
+    for (int i = 0; i < A.m; i++) {
+        for (int j = 0; j < B.n; j++) {
+            // Kahan summation on top of extended precision
+            Real sum = 0, comp = 0;
+            for (int k = 0; k < A.n; k++) {
+                Real y = (Real)A.data[i][k] * B.data[k][j] - comp;
+                Real t = sum + y;
+                comp = (t - sum) - y;
+                sum = t;
+            }
+            C[i * B.n + j] = sum;
+        }
+    }
+    return C;
+}
+
+static Real *refInverse(Matrix A) {
+    int n = A.n;
+    Real *M = newReal(n, 2 * n);
+
+    // Gauss-Jordan with partial pivoting on [A | I]
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++)
+            M[i * 2 * n + j] = A.data[i][j];
+        M[i * 2 * n + n + i] = 1;
+    }
+    for (int k = 0; k < n; k++) {
+        int pivot = k;
+        for (int i = k + 1; i < n; i++) {
+            if (fabsl(M[i * 2 * n + k]) > fabsl(M[pivot * 2 * n + k]))
+                pivot = i;
+        }
+        for (int j = 0; j < 2 * n; j++) {
+            Real t = M[k * 2 * n + j];
+            M[k * 2 * n + j] = M[pivot * 2 * n + j];
+            M[pivot * 2 * n + j] = t;
+        }
+        for (int i = 0; i < n; i++) {
+            if (i == k)
+                continue;
+            Real factor = M[i * 2 * n + k] / M[k * 2 * n + k];
+            for (int j = k; j < 2 * n; j++)
+                M[i * 2 * n + j] -= factor * M[k * 2 * n + j];
+        }
+    }
+
+    Real *X = newReal(n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++)
+            X[i * n + j] = M[i * 2 * n + n + j] / M[i * 2 * n + i];
+    }
+    free(M);
+    return X;
+}
+
+static Real refDeterminant(Matrix A) {
+    int n = A.n;
+    Real *M = newReal(n, n), det = 1;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++)
+            M[i * n + j] = A.data[i][j];
+    }
+
+    // Product of pivots from elimination with partial pivoting
+    for (int k = 0; k < n; k++) {
+        int pivot = k;
+        for (int i = k + 1; i < n; i++) {
+            if (fabsl(M[i * n + k]) > fabsl(M[pivot * n + k]))
+                pivot = i;
+        }
+        if (pivot != k) {
+            for (int j = 0; j < n; j++) {
+                Real t = M[k * n + j];
+                M[k * n + j] = M[pivot * n + j];
+                M[pivot * n + j] = t;
+            }
+            det = -det;
+        }
+        det *= M[k * n + k];
+        for (int i = k + 1; i < n; i++) {
+            Real factor = M[i * n + k] / M[k * n + k];
+            for (int j = k; j < n; j++)
+                M[i * n + j] -= factor * M[k * n + j];
+        }
+    }
+    free(M);
+    return det;
+}
+
+// Normwise relative error of a result against its reference
+static double error(Matrix C, const Real *R) {
+    Real diff = 0, norm = 0;
+    for (int i = 0; i < C.m; i++) {
+        for (int j = 0; j < C.n; j++) {
+            Real r = R[i * C.n + j];
+            diff += (C.data[i][j] - r) * (C.data[i][j] - r);
+            norm += r * r;
+        }
+    }
+    return sqrtl(diff / norm);
+}
+
+// -- Timing --
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct bench Bench;
+struct bench {
+    const char *name;
+    double (*measure)(const Bench *); // returns relative error
+    unsigned kernels;                 // bitmask of kernels counted
+    int n;
+    Matrix A, B;
+    Real *ref; // matrix reference
+    Real x;    // scalar reference
+};
+
+// -- Operations --
+static double measureMul(const Bench *b) {
+    Matrix C = mulMat(b->A, b->B);
+    double err = error(C, b->ref);
+    deleteMat(&C);
+    return err;
+}
+
+static double measureTrc(const Bench *b) {
+    return fabsl((trace(b->A) - b->x) / b->x);
+}
+
+static double measureDet(const Bench *b) {
+    return fabsl((determinant(b->A) - b->x) / b->x);
+}
+
+static double measureInv(const Bench *b) {
+    Matrix C = inverse(b->A);
+    double err = error(C, b->ref);
+    deleteMat(&C);
+    return err;
+}
+
+static double measureLU(const Bench *b) {
+    int *perm = malloc(b->n * sizeof(int)), sign;
+    Matrix LU = luDecomp(b->A, perm, &sign);
+    Matrix C = luInverse(LU, perm);
+    double err = error(C, b->ref);
+    deleteMat(&C);
+    deleteMat(&LU);
+    free(perm);
+    return err;
+}
+
+static Profile *profile;
+static int json;
+
+// Sum counters over the kernels of an operation
+static Counters total(const Bench *b) {
+    Counters counters[KERNEL_COUNT], sum = {};
+    readProfile(profile, counters);
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        if (!(b->kernels & (1u << k)))
+            continue;
+        sum.cycles += counters[k].cycles;
+        sum.instructions += counters[k].instructions;
+        sum.cacheMisses += counters[k].cacheMisses;
+        sum.flops += counters[k].flops;
+    }
+    return sum;
+}
+
+static void printRecord(const Bench *b, Precision p, double time, double cost, double err,
+                        const Counters *c, int reps) {
+    static int records;
+
+    if (!json) {
+        printf("%-6s %5d  %-12s %12.3f %8.2fx %12.2e\n", b->name, b->n, modes[p],
+               time * 1e6, cost, err);
+        return;
+    }
+
+    printf("%s\n  {\"op\": \"%s\", \"n\": %d, \"precision\": \"%s\", "
+           "\"time_us\": %.3f, \"cost\": %.3f, \"rel_error\": %.3e, "
+           "\"flops\": %.0f",
+           records++ ? "," : "[", b->name, b->n, modes[p], time * 1e6, cost, err,
+           (double)c->flops / reps);
+    if (hasCounters() && c->cycles) {
+        printf(", \"cycles\": %.0f, \"instructions\": %.0f, \"llc_misses\": %.0f, "
+               "\"ipc\": %.3f, \"flops_per_cycle\": %.3f}",
+               (double)c->cycles / reps, (double)c->instructions / reps,
+               (double)c->cacheMisses / reps, (double)c->instructions / c->cycles,
+               (double)c->flops / c->cycles);
+    } else {
+        printf(", \"cycles\": null, \"instructions\": null, \"llc_misses\": null, "
+               "\"ipc\": null, \"flops_per_cycle\": null}");
+    }
+}
+
+static void report(const Bench *b) {
+    double base = 0;
+
+    for (Precision p = PRECISION_FAST; p <= PRECISION_COMPENSATED; p++) {
+        Runtime runtime = *currentRuntime();
+        runtime.precision = p;
+        runtime.profile = profile;
+        const Runtime *saved = useRuntime(&runtime);
+
+        // Repeat until timing is stable
+        double err = b->measure(b), start = now(), elapsed;
+        int reps = 0;
+        resetProfile(profile);
+        do {
+            b->measure(b);
+            reps++;
+        } while ((elapsed = now() - start) < MIN_TIME);
+        useRuntime(saved);
+
+        double time = elapsed / reps;
+        if (p == PRECISION_FAST)
+            base = time;
+        Counters counters = total(b);
+        printRecord(b, p, time, time / base, err, &counters, reps);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "--json") != 0)) {
+        fprintf(stderr, "usage: %s [--json]\n", argv[0]);
+        return 1;
+    }
+    json = (argc == 2);
+
+    srand(1);
+    profile = newProfile();
+    enableProfile(profile, 1);
+    if (!json)
+        printf("%-6s %5s  %-12s %12s %9s %12s\n", "op", "n", "precision", "time (us)",
+               "cost", "rel. error");
+
+    // Products of wide-ranging entries
+    for (int n = 64; n <= 256; n *= 2) {
+        Bench b = {"mul", measureMul, 1 << KERNEL_MUL, n, randomMat(n, n, wide), randomMat(n, n, wide)};
+        b.ref = refMul(b.A, b.B);
+        report(&b);
+        free(b.ref);
+        deleteMat(&b.A);
+        deleteMat(&b.B);
+    }
+
+    // Sums of wide-ranging entries
+    for (int n = 512; n <= 2048; n *= 2) {
+        Bench b = {"trc", measureTrc, 1 << KERNEL_TRC, n, randomMat(n, n, wide)};
+        for (int i = 0; i < n; i++)
+            b.x += b.A.data[i][i];
+        report(&b);
+        deleteMat(&b.A);
+    }
+
+    // Cofactor expansion against pivoted factorization
+    for (int n = 6; n <= 8; n++) {
+        Bench b = {"det", measureDet, 1 << KERNEL_LU, n, randomMat(n, n, uniform)};
+        b.x = refDeterminant(b.A);
+        report(&b);
+        deleteMat(&b.A);
+    }
+    for (int n = 6; n <= 8; n++) {
+        Bench b = {"inv", measureInv, 1 << KERNEL_LU | 1 << KERNEL_LUINV, n, randomMat(n, n, uniform)};
+        b.ref = refInverse(b.A);
+        report(&b);
+        free(b.ref);
+        deleteMat(&b.A);
+    }
+
+    // Factorized inverses, as used by workspace operations
+    for (int n = 64; n <= 256; n *= 2) {
+        Bench b = {"lu", measureLU, 1 << KERNEL_LU | 1 << KERNEL_LUINV, n, randomMat(n, n, uniform)};
+        b.ref = refInverse(b.A);
+        report(&b);
+        free(b.ref);
+        deleteMat(&b.A);
+    }
+
+    if (json)
+        printf("\n]\n");
+    deleteProfile(profile);
+    return 0;
+}
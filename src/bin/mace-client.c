@@ -0,0 +1,105 @@
+// File:        mace-client.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define LINE_SIZE 4096
+
+// Write an entire buffer, retrying short writes
+static int writeAll(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        data += n;
+        size -= n;
+    }
+    return 0;
+}
+
+// Copy a NUL-terminated response to stdout, returning nonzero on hangup
+static int readResponse(int fd) {
+    char buffer[LINE_SIZE];
+    while (1) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+
+        // Stop at end of response
+        char *end = memchr(buffer, '\0', n);
+        fwrite(buffer, 1, end ? end - buffer : n, stdout);
+        if (end)
+            return 0;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s path\n", argv[0]);
+        return 1;
+    }
+
+    // Connect to server
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(argv[1]) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: socket path too long: %s\n", argv[1]);
+        return 1;
+    }
+    strcpy(addr.sun_path, argv[1]);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+        fprintf(stderr, "Error: could not connect to %s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    // Only prompt interactive users
+    int interactive = isatty(STDIN_FILENO);
+
+    // Send each line, and wait for its response
+    char line[LINE_SIZE];
+    while (1) {
+        if (interactive) {
+            printf(">>> ");
+            fflush(stdout);
+        }
+
+        if (!fgets(line, sizeof(line), stdin))
+            break;
+
+        // Send overlong lines in pieces, leaving none unsent if input ends
+        // right after one
+        size_t len = strlen(line);
+        int status = 0;
+        while (len && line[len - 1] != '\n' && len + 1 == sizeof(line)) {
+            if ((status = writeAll(fd, line, len)))
+                break;
+            len = fgets(line, sizeof(line), stdin) ? strlen(line) : 0;
+        }
+
+        // Terminate final line
+        if (!len || line[len - 1] != '\n')
+            line[len++] = '\n';
+
+        if (status || writeAll(fd, line, len) || readResponse(fd))
+            break; // server hung up
+        fflush(stdout);
+    }
+
+    close(fd);
+    return 0;
+}
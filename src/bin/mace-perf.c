@@ -0,0 +1,261 @@
+// File:        mace-perf.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Runs scripts end to end through mace, discarding their output, and
+// compares each against a baseline. Every script is run several times,
+// keeping the best wall time and instruction count, and the peak resident
+// set size. Instructions are counted in user space, and are omitted where
+// performance counters are unavailable.
+
+#define RUNS 5
+#define THRESHOLD 20.0 // percent
+#define NAME_MAX_LEN 64
+
+// Declare measurement structure
+typedef struct sample {
+    char name[NAME_MAX_LEN];
+    double wall;           // milliseconds
+    uint64_t instructions; // zero when not counted
+    long rss;              // kilobytes
+} Sample;
+
+static const char *usage = "usage: %s [-r runs] [-t percent] [-u] baseline script...\n";
+
+// -- Measurement --
+// Open a counter of user space instructions for a process
+static int openCounter(pid_t pid) {
+    struct perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+// Run a script once
+static int measure(const char *mace, const char *script, Sample *sample) {
+    // Hold the child until its counter is attached
+    int gate[2];
+    if (pipe(gate))
+        return -1;
+
+    double start = now();
+    pid_t pid = fork();
+    if (pid < 0)
+        return -1;
+    if (pid == 0) {
+        char go;
+        close(gate[1]);
+        if (read(gate[0], &go, 1) != 1)
+            _exit(127);
+
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        execl(mace, mace, script, (char *)NULL);
+        _exit(127);
+    }
+
+    close(gate[0]);
+    int counter = openCounter(pid);
+    (void)!write(gate[1], "", 1);
+    close(gate[1]);
+
+    int status;
+    struct rusage usage;
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR)
+        ;
+    sample->wall = now() - start;
+    sample->rss = usage.ru_maxrss;
+    sample->instructions = 0;
+    if (counter >= 0) {
+        if (read(counter, &sample->instructions, sizeof(uint64_t)) != sizeof(uint64_t))
+            sample->instructions = 0;
+        close(counter);
+    }
+
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+}
+
+// Run a script repeatedly, keeping the best of each measurement
+static int bench(const char *mace, const char *script, int runs, Sample *best) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s", script);
+    snprintf(best->name, sizeof(best->name), "%s", basename(path));
+
+    for (int i = 0; i < runs; i++) {
+        Sample run;
+        if (measure(mace, script, &run))
+            return -1;
+        if (i == 0 || run.wall < best->wall)
+            best->wall = run.wall;
+        if (i == 0 || run.instructions < best->instructions)
+            best->instructions = run.instructions;
+        if (i == 0 || run.rss > best->rss)
+            best->rss = run.rss;
+    }
+
+    return 0;
+}
+
+// -- Baseline --
+static int readBaseline(const char *path, Sample **samples) {
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return 0;
+
+    int count = 0;
+    Sample sample;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        // Skip header and malformed lines
+        unsigned long long instructions;
+        if (sscanf(line, "%63s %lf %llu %ld", sample.name, &sample.wall, &instructions,
+                   &sample.rss) != 4)
+            continue;
+        sample.instructions = instructions;
+
+        *samples = realloc(*samples, (count + 1) * sizeof(Sample));
+        (*samples)[count++] = sample;
+    }
+    fclose(file);
+
+    return count;
+}
+
+static int writeBaseline(const char *path, const Sample samples[], int count) {
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return -1;
+
+    fprintf(file, "# script\twall_ms\tinstructions\tmaxrss_kb\n");
+    for (int i = 0; i < count; i++)
+        fprintf(file, "%s\t%.3f\t%llu\t%ld\n", samples[i].name, samples[i].wall,
+                (unsigned long long)samples[i].instructions, samples[i].rss);
+
+    return fclose(file);
+}
+
+// -- Comparison --
+// Report change relative to baseline, returning whether it regressed
+static int compare(double value, double base, double threshold, char *delta, size_t size) {
+    // Skip measurements missing on either side
+    if (value <= 0 || base <= 0) {
+        snprintf(delta, size, "%8s", "-");
+        return 0;
+    }
+
+    double change = 100 * (value - base) / base;
+    int regressed = change > threshold;
+    snprintf(delta, size, "%+7.1f%%%s", change, regressed ? "!" : "");
+    return regressed;
+}
+
+int main(int argc, char *argv[]) {
+    int runs = RUNS, update = 0, opt;
+    double threshold = THRESHOLD;
+
+    while ((opt = getopt(argc, argv, "r:t:u")) != -1) {
+        switch (opt) {
+            case 'r':
+                runs = atoi(optarg);
+                break;
+            case 't':
+                threshold = atof(optarg);
+                break;
+            case 'u':
+                update = 1;
+                break;
+            default:
+                fprintf(stderr, usage, argv[0]);
+                return 2;
+        }
+    }
+    if (argc - optind < 2 || runs < 1) {
+        fprintf(stderr, usage, argv[0]);
+        return 2;
+    }
+    const char *path = argv[optind++];
+
+    // Run mace from beside this binary
+    char mace[PATH_MAX];
+    char self[PATH_MAX];
+    snprintf(self, sizeof(self), "%s", argv[0]);
+    snprintf(mace, sizeof(mace), "%s/mace", dirname(self));
+
+    Sample *base = NULL;
+    int nbase = update ? 0 : readBaseline(path, &base);
+
+    int count = argc - optind, regressions = 0;
+    Sample *samples = calloc(count, sizeof(Sample));
+    printf("%-16s %10s %9s %14s %9s %10s %9s\n", "script", "wall (ms)", "", "instructions",
+           "", "rss (KB)", "");
+    for (int i = 0; i < count; i++) {
+        Sample *sample = &samples[i];
+        if (bench(mace, argv[optind + i], runs, sample)) {
+            fprintf(stderr, "Error: could not run %s.\n", argv[optind + i]);
+            return 2;
+        }
+
+        // Find baseline by script name
+        Sample none = {}, *prev = &none;
+        for (int j = 0; j < nbase; j++) {
+            if (strcmp(base[j].name, sample->name) == 0)
+                prev = &base[j];
+        }
+
+        char wall[16], instructions[16], rss[16];
+        regressions += compare(sample->wall, prev->wall, threshold, wall, sizeof(wall));
+        regressions += compare(sample->instructions, prev->instructions, threshold,
+                               instructions, sizeof(instructions));
+        regressions += compare(sample->rss, prev->rss, threshold, rss, sizeof(rss));
+        printf("%-16s %10.1f %9s %14llu %9s %10ld %9s\n", sample->name, sample->wall, wall,
+               (unsigned long long)sample->instructions, instructions, sample->rss, rss);
+    }
+
+    // Record new baseline
+    if (update) {
+        if (writeBaseline(path, samples, count)) {
+            fprintf(stderr, "Error: could not write %s.\n", path);
+            return 2;
+        }
+        printf("Baseline written to %s.\n", path);
+    } else if (!nbase) {
+        printf("No baseline at %s. Record one with -u.\n", path);
+    } else if (regressions) {
+        printf("%d measurement(s) regressed by more than %.1f%%.\n", regressions, threshold);
+    }
+
+    free(base);
+    free(samples);
+    return regressions ? 1 : 0;
+}
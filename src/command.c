@@ -0,0 +1,295 @@
+// File:        command.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "command.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "expr.h"
+#include "job.h"
+#include "journal.h"
+#include "mace/mace.h"
+#include "repl.h"
+
+// Commands are kept in an open-addressed hash table, at most half full, so
+// lookups cost a hash and (almost always) a single comparison. Registration
+// order is remembered separately for listing.
+
+static const Command *registry[REGISTRY_SIZE];
+static const Command *order[REGISTRY_SIZE / 2];
+static int count;
+
+// FNV-1a hash of a command name
+static uint32_t hash(const char name[]) {
+    uint32_t h = 2166136261u;
+    for (; *name; name++)
+        h = (h ^ (unsigned char)*name) * 16777619u;
+    return h;
+}
+
+// Find the slot holding a name, or the empty slot where it belongs
+static int probe(const char name[]) {
+    int slot = hash(name) & (REGISTRY_SIZE - 1);
+    while (registry[slot] && strcmp(registry[slot]->name, name) != 0)
+        slot = (slot + 1) & (REGISTRY_SIZE - 1);
+    return slot;
+}
+
+int registerCommand(const Command *cmd) {
+    // Return early on a full registry
+    if (count >= REGISTRY_SIZE / 2)
+        return -1;
+
+    // Replace any command with the same name
+    int slot = probe(cmd->name);
+    if (registry[slot]) {
+        for (int i = 0; i < count; i++) {
+            if (order[i] == registry[slot])
+                order[i] = cmd;
+        }
+    } else {
+        order[count++] = cmd;
+    }
+    registry[slot] = cmd;
+
+    return 0;
+}
+
+const Command *findCommand(const char name[]) {
+    return registry[probe(name)];
+}
+
+int numCommands(void) {
+    return count;
+}
+
+const Command *getCommand(int index) {
+    return (index >= 0 && index < count) ? order[index] : NULL;
+}
+
+// -- Dispatch --
+// Convert a token to a matrix identifier, or -1 if not recognized
+int identifier(const char token[]) {
+    // Get matrix identifier
+    if (strlen(token) == 1 && isalpha(token[0]))
+        return toupper(token[0]) - 'A';
+    // Determine if "Mat" prefix is used
+    else if (strncmp(token, "Mat", 3) == 0 && strlen(token) == 4 && isalpha(token[3]))
+        return toupper(token[3]) - 'A';
+    // Check for "ans" input
+    else if (strcmp(token, "ans") == 0 || strcmp(token, "MatAns") == 0)
+        return ANS;
+
+    return -1;
+}
+
+// Convert a token to an argument of the given type, returning 0 on success
+static int convert(Context *ctx, char type, char token[], Arg *arg, int index) {
+    char *end;
+
+    switch (type) {
+        case 'm': // matrix identifier
+            if ((arg->id = identifier(token)) == -1) {
+                output("Error: operand #%d not recognized.\n", index);
+                return -1;
+            }
+            return 0;
+
+        case 'n': // number
+            // Use value of "ans" if it is a scalar
+            if (identifier(token) == ANS) {
+                Matrix ans;
+                if (maceGet(ctx, ANS, &ans) || ans.m != 1 || !isSquare(ans)) {
+                    printError(MACE_ENOANS);
+                    return -1;
+                }
+                arg->num = ans.data[0][0];
+                return 0;
+            }
+            arg->num = strtod(token, &end);
+            break;
+
+        case 'i': // integer
+            arg->count = strtol(token, &end, 10);
+            break;
+
+        default: // word
+            arg->word = token;
+            return 0;
+    }
+
+    // Reject partially converted numbers
+    if (*end) {
+        output("Error: parameter #%d is not %s.\n", index, (type == 'i') ? "an integer" : "a number");
+        return -1;
+    }
+
+    return 0;
+}
+
+// Parse input according to a signature, returning the argument count or -1
+static int parseArgs(Context *ctx, const char signature[], char input[], Arg argv[]) {
+    // Pass rest of input unsplit
+    if (signature[0] == 's' || signature[0] == 'e') {
+        if (!input && signature[1] != '?') {
+            output("Error: incorrect number of parameters. (0/1)\n");
+            return -1;
+        }
+        argv[0].word = input;
+        return input ? 1 : 0;
+    }
+
+    // Split input
+    int argc = 0;
+    char *tokens[MAX_ARGS], *save;
+    for (char *token = input ? strtok_r(input, " ", &save) : NULL; token;
+         token = strtok_r(NULL, " ", &save)) {
+        if (argc == MAX_ARGS) {
+            output("Error: too many parameters. (max %d)\n", MAX_ARGS);
+            return -1;
+        }
+        tokens[argc++] = token;
+    }
+
+    // Determine arity from signature
+    int len = strlen(signature);
+    char suffix = len ? signature[len - 1] : '\0';
+    int types = (suffix == '?' || suffix == '*') ? len - 1 : len;
+    int min = (suffix == '?' || suffix == '*') ? types - 1 : types;
+    int max = (suffix == '*') ? MAX_ARGS : types;
+
+    // Count parameters
+    if (argc < min || argc > max) {
+        output("Error: incorrect number of parameters. (%d/%d)\n", argc, (argc < min) ? min : max);
+        return -1;
+    }
+
+    // Convert each parameter (repeating the final type)
+    for (int i = 0; i < argc; i++) {
+        char type = signature[(i < types) ? i : types - 1];
+        if (convert(ctx, type, tokens[i], &argv[i], i + 1))
+            return -1;
+    }
+
+    return argc;
+}
+
+// Find matrices read by a command, returning their count or -1 for all
+int operands(const Command *cmd, const char args[], int ids[]) {
+    char copy[MAX] = {}, *save;
+    if (args)
+        strncpy(copy, args, MAX - 1);
+
+    // Expressions name every operand they read
+    int count = 0;
+    if (cmd->signature[0] == 'e') {
+        Expr expr;
+        if (parseExpr(args, &expr))
+            return 0;
+        for (; count < expr.map.operands; count++)
+            ids[count] = expr.ids[count];
+        return count;
+    }
+
+    // Rest of input may only name ans
+    if (cmd->signature[0] == 's') {
+        char *token = strtok_r(copy, " ", &save);
+        if (token && identifier(token) == ANS && !strtok_r(NULL, " ", &save))
+            ids[count++] = ANS;
+        return count;
+    }
+
+    // Collect identifiers, and ans used as a number
+    int len = strlen(cmd->signature), index = 0;
+    for (char *token = strtok_r(copy, " ", &save); token && count < MAX_ARGS;
+         token = strtok_r(NULL, " ", &save), index++) {
+        char type = cmd->signature[(index < len) ? index : len - 1];
+        if (type == '*' || type == '?')
+            type = cmd->signature[len - 2];
+
+        int id = identifier(token);
+        if ((type == 'm' && id != -1) || (type == 'n' && id == ANS))
+            ids[count++] = id;
+    }
+
+    // Repeated operands default to the whole workspace
+    if (index == 0 && len > 1 && cmd->signature[len - 1] == '*')
+        return -1;
+    return count;
+}
+
+int execute(Context *ctx, char input[]) {
+    // Report jobs finished since the last command
+    reportJobs(ctx);
+
+    // Keep line as entered, while recording
+    char line[MAX] = {};
+    int recording = recordingPath(ctx) != NULL;
+    if (recording)
+        snprintf(line, MAX, "%.*s", (int)strcspn(input, "\n"), input);
+
+    // Strip trailing '&', which runs the command as a job
+    int len = strcspn(input, "\n");
+    while (len > 0 && isspace((unsigned char)input[len - 1]))
+        len--;
+    int background = (len > 0 && input[len - 1] == '&');
+    if (background) {
+        do
+            input[--len] = '\0';
+        while (len > 0 && isspace((unsigned char)input[len - 1]));
+    }
+
+    // Split command name from arguments
+    char *save;
+    char *name = strtok_r(input, " \n", &save);
+    if (!name || name[0] == '#')
+        return 0; // do nothing on blank input or comments
+    char *args = strtok_r(NULL, "\n", &save);
+
+    // Look up command
+    const Command *cmd = findCommand(name);
+    if (!cmd) {
+        output("Invalid command.\n");
+        return 0;
+    }
+
+    // Never journal commands controlling the journal itself
+    recording &= strcmp(name, "record") != 0;
+
+    // Start job against a snapshot of the workspace
+    if (background) {
+        if (cmd->effects != EFFECT_ANS) {
+            output("Error: %s cannot run in the background.\n", name);
+            return 0;
+        }
+
+        char job[MAX];
+        snprintf(job, MAX, "%s %s", name, args ? args : "");
+        startJob(ctx, job);
+        if (recording)
+            journalCommand(ctx, line, 0);
+        return 0;
+    }
+
+    // Validate arguments, and run command
+    Arg argv[MAX_ARGS];
+    int argc = parseArgs(ctx, cmd->signature, args, argv);
+    if (argc < 0)
+        return 0;
+
+    // Journal commands run while recording
+    double start = recording ? journalClock() : 0;
+    int quit = cmd->handler(ctx, argc, argv);
+    if (recording)
+        journalCommand(ctx, line, journalClock() - start);
+
+    return quit;
+}
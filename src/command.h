@@ -0,0 +1,57 @@
+// File:        command.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include "mace/mace.h"
+
+#define REGISTRY_SIZE 256 // must be a power of 2
+#define MAX_ARGS 32
+
+// Command effects, used to decide which commands may run concurrently
+#define EFFECT_ANY 0    // may change anything, so runs alone
+#define EFFECT_ANS 1    // only replaces ans
+#define EFFECT_CREATE 2 // only adds a matrix to the workspace
+#define EFFECT_PRINT 3  // only prints
+#define EFFECT_CLEAR 4  // empties the workspace, so runs alone
+
+// Declare argument structure
+typedef union arg {
+    int id;     // 'm': matrix identifier (or ANS)
+    int count;  // 'i': integer
+    double num; // 'n': number (or 1x1 ans)
+    char *word; // 'w': word, 's': rest of input, 'e': expression
+} Arg;
+
+// Declare command structure
+//
+// A signature lists the type of each parameter. A trailing '?' makes the
+// last parameter optional, and a trailing '*' repeats it any number of
+// times (including zero). An expression takes the rest of input, and reads
+// every matrix it names. Commands whose only effect is replacing ans may be
+// run as a job by ending the line with '&'.
+typedef struct command {
+    const char *name;
+    int (*handler)(Context *, int, Arg[]); // returns nonzero to quit
+    const char *signature;
+    const char *summary;     // quick help menu entry
+    const char *description; // help menu entries
+    const char *parameters;
+    const char *examples;
+    int effects;
+} Command;
+
+// Function prototypes
+int registerCommand(const Command *);
+const Command *findCommand(const char[]);
+int numCommands(void);
+const Command *getCommand(int);
+// Dispatch
+int identifier(const char[]);
+int operands(const Command *, const char[], int[]);
+int execute(Context *, char[]);
+
+#endif
@@ -0,0 +1,229 @@
+// File:        expr.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include "expr.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "command.h"
+
+// Expressions are parsed by recursive descent, emitting a map in postfix
+// order as they go. Every identifier naming the same matrix shares one
+// operand. Grammar, from lowest precedence:
+//
+//   compare = sum [("<" | ">" | "==") sum]
+//   sum     = product {("+" | "-") product}
+//   product = unary {("*" | "/") unary}
+//   unary   = "-" unary | atom
+//   atom    = number | matrix | "(" compare ")" | function "(" args ")"
+
+// Declare parser structure
+typedef struct parser {
+    const char *at;
+    Expr *expr;
+    const char *error;
+} Parser;
+
+// Declare function structure
+typedef struct function {
+    const char *name;
+    Op op;
+    int arity;
+} Function;
+
+static const Function functions[] = {
+    {"abs", OP_ABS, 1},
+    {"exp", OP_EXP, 1},
+    {"log", OP_LOG, 1},
+    {"sqrt", OP_SQRT, 1},
+    {"min", OP_MIN, 2},
+    {"max", OP_MAX, 2},
+};
+
+static int compare(Parser *);
+
+// -- Lexing --
+static void skip(Parser *p) {
+    while (isspace((unsigned char)*p->at))
+        p->at++;
+}
+
+// Consume a token if it comes next
+static int accept(Parser *p, const char token[]) {
+    skip(p);
+    size_t len = strlen(token);
+    if (strncmp(p->at, token, len) != 0)
+        return 0;
+
+    p->at += len;
+    return 1;
+}
+
+static int fail(Parser *p, const char error[]) {
+    // Keep the first error
+    if (!p->error)
+        p->error = error;
+    return -1;
+}
+
+static int emit(Parser *p, int status) {
+    return status ? fail(p, "expression is too long") : 0;
+}
+
+// -- Grammar --
+static int operand(Parser *p, int id) {
+    // Share operands naming the same matrix
+    Map *map = &p->expr->map;
+    int k = 0;
+    while (k < map->operands && p->expr->ids[k] != id)
+        k++;
+    if (k == MAP_OPERANDS)
+        return fail(p, "expression has too many operands");
+
+    p->expr->ids[k] = id;
+    return emit(p, mapLoad(map, k));
+}
+
+static int call(Parser *p, const Function *f) {
+    for (int i = 0; i < f->arity; i++) {
+        if ((i && !accept(p, ",")) || compare(p))
+            return fail(p, "missing function argument");
+    }
+    if (!accept(p, ")"))
+        return fail(p, "missing closing parenthesis");
+
+    return emit(p, mapOp(&p->expr->map, f->op));
+}
+
+static int atom(Parser *p) {
+    skip(p);
+
+    // Parenthesized expressions
+    if (accept(p, "(")) {
+        if (compare(p))
+            return -1;
+        return accept(p, ")") ? 0 : fail(p, "missing closing parenthesis");
+    }
+
+    // Numbers
+    char *end;
+    double value = strtod(p->at, &end);
+    if (end != p->at && !isalpha((unsigned char)*p->at)) {
+        p->at = end;
+        return emit(p, mapConst(&p->expr->map, value));
+    }
+
+    // Read a name
+    char name[16] = {};
+    size_t len = 0;
+    while (isalnum((unsigned char)p->at[len]))
+        len++;
+    if (!len || len >= sizeof(name))
+        return fail(p, "expected a number, matrix or function");
+    memcpy(name, p->at, len);
+    p->at += len;
+
+    // Functions are followed by their arguments
+    if (accept(p, "(")) {
+        for (size_t i = 0; i < sizeof(functions) / sizeof(*functions); i++) {
+            if (strcmp(name, functions[i].name) == 0)
+                return call(p, &functions[i]);
+        }
+        return fail(p, "unknown function");
+    }
+
+    int id = identifier(name);
+    return (id == -1) ? fail(p, "operand not recognized") : operand(p, id);
+}
+
+static int unary(Parser *p) {
+    if (accept(p, "-")) {
+        if (unary(p))
+            return -1;
+        return emit(p, mapOp(&p->expr->map, OP_NEG));
+    }
+
+    return atom(p);
+}
+
+static int product(Parser *p) {
+    if (unary(p))
+        return -1;
+
+    for (;;) {
+        Op op;
+        if (accept(p, "*"))
+            op = OP_MUL;
+        else if (accept(p, "/"))
+            op = OP_DIV;
+        else
+            return 0;
+
+        if (unary(p) || emit(p, mapOp(&p->expr->map, op)))
+            return -1;
+    }
+}
+
+static int sum(Parser *p) {
+    if (product(p))
+        return -1;
+
+    for (;;) {
+        Op op;
+        if (accept(p, "+"))
+            op = OP_ADD;
+        else if (accept(p, "-"))
+            op = OP_SUB;
+        else
+            return 0;
+
+        if (product(p) || emit(p, mapOp(&p->expr->map, op)))
+            return -1;
+    }
+}
+
+static int compare(Parser *p) {
+    if (sum(p))
+        return -1;
+
+    Op op;
+    if (accept(p, "=="))
+        op = OP_EQ;
+    else if (accept(p, "<"))
+        op = OP_LT;
+    else if (accept(p, ">"))
+        op = OP_GT;
+    else
+        return 0;
+
+    if (sum(p))
+        return -1;
+    return emit(p, mapOp(&p->expr->map, op));
+}
+
+const char *parseExpr(const char input[], Expr *expr) {
+    *expr = (Expr){};
+    Parser p = {input ? input : "", expr, NULL};
+
+    // Parse whole input
+    if (!compare(&p)) {
+        skip(&p);
+        if (*p.at)
+            fail(&p, "unexpected input after expression");
+    }
+
+    // Reject programs too deep to evaluate, checked on scalar operands
+    double zero = 0, *row = &zero;
+    Matrix operands[MAP_OPERANDS];
+    int m, n;
+    for (int k = 0; k < MAP_OPERANDS; k++)
+        operands[k] = (Matrix){1, 1, &row};
+    if (!p.error && mapShape(&expr->map, operands, &m, &n))
+        fail(&p, "expression is too deeply nested");
+
+    return p.error;
+}
@@ -0,0 +1,20 @@
+// File:        expr.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef EXPR_H
+#define EXPR_H
+
+#include "mace/map.h"
+
+// Declare expression structure
+typedef struct expr {
+    Map map;
+    int ids[MAP_OPERANDS]; // matrix identifier of each operand
+} Expr;
+
+// Function prototypes
+const char *parseExpr(const char[], Expr *);
+
+#endif
@@ -0,0 +1,272 @@
+// File:        job.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "job.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "command.h"
+#include "mace/mace.h"
+#include "repl.h"
+
+// Jobs run a command on the pool against a fork of the workspace, capturing
+// its output. Finished jobs are reported by the thread owning the context,
+// which is also the only one to adopt their ans, so the workspace itself is
+// never shared between threads.
+
+// Job states
+enum {
+    JOB_PENDING, // waiting for a pool thread
+    JOB_RUNNING,
+    JOB_DONE,
+};
+
+// Declare job structure
+typedef struct job {
+    int id;
+    char input[MAX];
+    Context *fork; // owned by the context's thread
+    atomic_int state;
+    atomic_int refs; // table and pool task
+    int cancelled;
+    char *output; // captured output
+    size_t size;
+    struct table *table;
+} Job;
+
+// Declare job table structure
+typedef struct table {
+    int next; // id of next job
+    Job *jobs[MAX_JOBS];
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+} Table;
+
+static void releaseJob(Job *job) {
+    // Last reference frees the job
+    if (atomic_fetch_sub(&job->refs, 1) == 1) {
+        free(job->output);
+        free(job);
+    }
+}
+
+static void runJob(Job *job) {
+    char input[MAX];
+    strcpy(input, job->input); // execute splits its input in place
+
+    // Capture output of command
+    FILE *out = open_memstream(&job->output, &job->size);
+    FILE *previous = useOutput(out);
+    execute(job->fork, input);
+    useOutput(previous);
+    if (out)
+        fclose(out);
+
+    // Wake waiting threads
+    Table *table = job->table;
+    pthread_mutex_lock(&table->lock);
+    atomic_store(&job->state, JOB_DONE);
+    pthread_cond_broadcast(&table->finished);
+    pthread_mutex_unlock(&table->lock);
+}
+
+// Claim a pending job, returning nonzero if this thread must run it
+static int claimJob(Job *job) {
+    int expected = JOB_PENDING;
+    return atomic_compare_exchange_strong(&job->state, &expected, JOB_RUNNING);
+}
+
+static void poolJob(void *arg) {
+    Job *job = arg;
+
+    // Job may have already been run by a waiting thread
+    if (claimJob(job))
+        runJob(job);
+    releaseJob(job);
+}
+
+static Job *findJob(Table *table, int id) {
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (table->jobs[i] && table->jobs[i]->id == id)
+            return table->jobs[i];
+    }
+    return NULL;
+}
+
+static void finishJob(Job *job) {
+    // Run unstarted jobs rather than wait for a pool thread
+    if (claimJob(job)) {
+        runJob(job);
+        return;
+    }
+
+    Table *table = job->table;
+    pthread_mutex_lock(&table->lock);
+    while (atomic_load(&job->state) != JOB_DONE)
+        pthread_cond_wait(&table->finished, &table->lock);
+    pthread_mutex_unlock(&table->lock);
+}
+
+static void removeJob(Table *table, int index) {
+    Job *job = table->jobs[index];
+    deleteContext(job->fork);
+    job->fork = NULL;
+    table->jobs[index] = NULL;
+    releaseJob(job);
+}
+
+int startJob(Context *ctx, const char input[]) {
+    // Create job table on first use
+    Table *table = maceUserData(ctx);
+    if (!table) {
+        table = calloc(1, sizeof(Table));
+        if (!table) {
+            output("Error: could not start job.\n");
+            return -1;
+        }
+        pthread_mutex_init(&table->lock, NULL);
+        pthread_cond_init(&table->finished, NULL);
+        maceSetUserData(ctx, table);
+    }
+
+    // Find free slot
+    int index = 0;
+    while (index < MAX_JOBS && table->jobs[index])
+        index++;
+    if (index == MAX_JOBS) {
+        output("Error: too many jobs. Wait for a job to finish and try "
+               "again. (max %d)\n",
+               MAX_JOBS);
+        return -1;
+    }
+
+    // Create job against a snapshot of the workspace
+    Job *job = calloc(1, sizeof(Job));
+    Context *fork = job ? maceFork(ctx) : NULL;
+    if (!fork) {
+        free(job);
+        output("Error: could not start job.\n");
+        return -1;
+    }
+    job->id = ++table->next;
+    strncpy(job->input, input, MAX - 1);
+    job->fork = fork;
+    job->table = table;
+    atomic_init(&job->state, JOB_PENDING);
+    atomic_init(&job->refs, 2);
+    table->jobs[index] = job;
+
+    output("[%d] %s\n", job->id, job->input);
+    poolSubmit(currentPool(), poolJob, job);
+    return job->id;
+}
+
+void reportJobs(Context *ctx) {
+    Table *table = maceUserData(ctx);
+    if (!table)
+        return;
+
+    // Report finished jobs
+    for (int i = 0; i < MAX_JOBS; i++) {
+        Job *job = table->jobs[i];
+        if (!job || atomic_load(&job->state) != JOB_DONE)
+            continue;
+
+        // Print output, and publish ans and factors of successful jobs
+        if (job->cancelled) {
+            output("[%d] Cancelled\t%s\n", job->id, job->input);
+        } else {
+            output("[%d] Done\t%s\n", job->id, job->input);
+            if (job->output)
+                output("%s", job->output);
+            maceAdopt(ctx, job->fork);
+        }
+
+        removeJob(table, i);
+    }
+}
+
+void listJobs(Context *ctx) {
+    Table *table = maceUserData(ctx);
+    int count = 0;
+
+    for (int i = 0; table && i < MAX_JOBS; i++) {
+        Job *job = table->jobs[i];
+        if (!job)
+            continue;
+
+        int state = atomic_load(&job->state);
+        output("[%d] %s\t%s\n", job->id,
+               (state == JOB_DONE) ? "Done" : (state == JOB_RUNNING) ? "Running" : "Pending",
+               job->input);
+        count++;
+    }
+
+    if (!count)
+        output("No jobs.\n");
+}
+
+int waitJob(Context *ctx, int id) {
+    Table *table = maceUserData(ctx);
+
+    // Wait for all jobs
+    if (id == 0) {
+        for (int i = 0; table && i < MAX_JOBS; i++) {
+            if (table->jobs[i])
+                finishJob(table->jobs[i]);
+        }
+        reportJobs(ctx);
+        return 0;
+    }
+
+    // Return early on unknown jobs
+    Job *job = table ? findJob(table, id) : NULL;
+    if (!job)
+        return -1;
+
+    finishJob(job);
+    reportJobs(ctx);
+    return 0;
+}
+
+int cancelJob(Context *ctx, int id) {
+    Table *table = maceUserData(ctx);
+
+    // Return early on unknown jobs
+    Job *job = table ? findJob(table, id) : NULL;
+    if (!job)
+        return -1;
+
+    // Kernels stop at their next cancellation point
+    job->cancelled = 1;
+    maceCancel(job->fork);
+    return 0;
+}
+
+void stopJobs(Context *ctx) {
+    Table *table = maceUserData(ctx);
+    if (!table)
+        return;
+
+    // Cancel and discard every job
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (table->jobs[i]) {
+            maceCancel(table->jobs[i]->fork);
+            finishJob(table->jobs[i]);
+            removeJob(table, i);
+        }
+    }
+
+    pthread_cond_destroy(&table->finished);
+    pthread_mutex_destroy(&table->lock);
+    free(table);
+    maceSetUserData(ctx, NULL);
+}
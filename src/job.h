@@ -0,0 +1,21 @@
+// File:        job.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef JOB_H
+#define JOB_H
+
+#include "mace/mace.h"
+
+#define MAX_JOBS 16
+
+// Function prototypes
+int startJob(Context *, const char[]);
+void reportJobs(Context *);
+void listJobs(Context *);
+int waitJob(Context *, int);
+int cancelJob(Context *, int);
+void stopJobs(Context *);
+
+#endif
@@ -0,0 +1,210 @@
+// File:        journal.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "journal.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "command.h"
+#include "job.h"
+#include "repl.h"
+
+// A journal records every command run on a context while recording, each
+// preceded by a comment holding when it started and how long it took. It
+// is appended to and flushed after every command, so it survives crashes,
+// and it is itself a script. Replaying a journal runs its commands one at a
+// time, with output discarded, and compares how long each took against
+// its recording. Commands run while replaying are never recorded.
+
+#define SLOWEST 5 // commands reported after a replay
+
+// Declare journal structure
+typedef struct journal {
+    Context *ctx;
+    FILE *file;
+    char *path;
+    struct journal *next;
+} Journal;
+
+// Declare replayed command structure
+typedef struct replayed {
+    char input[MAX];
+    double recorded, replayed; // milliseconds, recorded negative if unknown
+} Replayed;
+
+static Journal *journals;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local int replaying;
+
+// Find the journal of a context, holding the lock
+static Journal **findJournal(Context *ctx) {
+    Journal **J = &journals;
+    while (*J && (*J)->ctx != ctx)
+        J = &(*J)->next;
+    return J;
+}
+
+// -- Recording --
+int startRecording(Context *ctx, const char *path) {
+    FILE *file = fopen(path, "a");
+    if (!file)
+        return -1;
+
+    // Mark the start of new journals
+    if (ftell(file) == 0)
+        fprintf(file, "# mace journal\n");
+    fflush(file);
+
+    Journal *J = malloc(sizeof(Journal));
+    *J = (Journal){ctx, file, strdup(path), NULL};
+
+    pthread_mutex_lock(&lock);
+    J->next = journals;
+    journals = J;
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+int stopRecording(Context *ctx) {
+    pthread_mutex_lock(&lock);
+    Journal **link = findJournal(ctx), *J = *link;
+    if (J)
+        *link = J->next;
+    pthread_mutex_unlock(&lock);
+
+    // Return early when not recording
+    if (!J)
+        return -1;
+
+    fclose(J->file);
+    free(J->path);
+    free(J);
+    return 0;
+}
+
+const char *recordingPath(Context *ctx) {
+    pthread_mutex_lock(&lock);
+    Journal *J = *findJournal(ctx);
+    pthread_mutex_unlock(&lock);
+
+    return (J && !replaying) ? J->path : NULL;
+}
+
+double journalClock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void journalCommand(Context *ctx, const char input[], double elapsed) {
+    // Find when the command started
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    double started = ts.tv_sec + ts.tv_nsec * 1e-9 - elapsed;
+    time_t seconds = started;
+    struct tm tm;
+    char stamp[32];
+    gmtime_r(&seconds, &tm);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &tm);
+
+    pthread_mutex_lock(&lock);
+    Journal *J = *findJournal(ctx);
+    if (J && !replaying) {
+        fprintf(J->file, "# %s.%03dZ %.3f ms\n%s\n", stamp,
+                (int)((started - seconds) * 1e3), elapsed * 1e3, input);
+        fflush(J->file);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+// -- Replay --
+// Keep the commands furthest over their recorded duration, slowest first
+static void rank(Replayed slowest[], int *count, const Replayed *R) {
+    double over = R->replayed - ((R->recorded < 0) ? 0 : R->recorded);
+    int i = (*count < SLOWEST) ? (*count)++ : SLOWEST;
+    for (; i > 0; i--) {
+        const Replayed *prev = &slowest[i - 1];
+        if (prev->replayed - ((prev->recorded < 0) ? 0 : prev->recorded) >= over)
+            break;
+        if (i < SLOWEST)
+            slowest[i] = *prev;
+    }
+    if (i < SLOWEST)
+        slowest[i] = *R;
+}
+
+int replayJournal(Context *ctx, const char *path) {
+    FILE *file = fopen(path, "r");
+    FILE *sink = fopen("/dev/null", "w");
+    if (!file || !sink) {
+        if (file)
+            fclose(file);
+        if (sink)
+            fclose(sink);
+        return -1;
+    }
+
+    Replayed slowest[SLOWEST];
+    int count = 0, ranked = 0, quit = 0;
+    double recorded = -1, total = 0, expected = 0;
+    char *line = NULL;
+    size_t capacity = 0;
+    while (!quit && getline(&line, &capacity, file) >= 0) {
+        // Remember the duration recorded for the next command
+        double ms;
+        if (line[0] == '#') {
+            if (sscanf(line, "# %*s %lf ms", &ms) == 1)
+                recorded = ms;
+            continue;
+        }
+        if (strlen(line) >= MAX || strspn(line, " \t\r\n") == strlen(line))
+            continue;
+
+        // Run command headlessly, without recording it
+        Replayed R = {.recorded = recorded};
+        strcpy(R.input, line);
+        R.input[strcspn(R.input, "\n")] = '\0';
+        FILE *previous = useOutput(sink);
+        replaying = 1;
+        double start = journalClock();
+        quit = execute(ctx, line);
+        R.replayed = (journalClock() - start) * 1e3;
+        replaying = 0;
+        useOutput(previous);
+
+        count++;
+        total += R.replayed;
+        expected += (recorded < 0) ? 0 : recorded;
+        rank(slowest, &ranked, &R);
+        recorded = -1;
+    }
+    free(line);
+    fclose(file);
+
+    // Let jobs started by the journal finish
+    FILE *previous = useOutput(sink);
+    waitJob(ctx, 0);
+    useOutput(previous);
+    fclose(sink);
+
+    // Report commands furthest over their recording
+    output("Replayed %d command%s in %.3f ms (recorded %.3f ms).\n", count,
+           (count == 1) ? "" : "s", total, expected);
+    for (int i = 0; i < ranked; i++) {
+        if (slowest[i].recorded < 0)
+            output("\t%10.3f ms (not recorded)\t%s\n", slowest[i].replayed, slowest[i].input);
+        else
+            output("\t%10.3f ms (recorded %.3f ms)\t%s\n", slowest[i].replayed,
+                   slowest[i].recorded, slowest[i].input);
+    }
+
+    return 0;
+}
@@ -0,0 +1,20 @@
+// File:        journal.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "mace/mace.h"
+
+// Function prototypes
+int startRecording(Context *, const char *);
+int stopRecording(Context *);
+const char *recordingPath(Context *);
+double journalClock(void);
+void journalCommand(Context *, const char[], double);
+// Replay
+int replayJournal(Context *, const char *);
+
+#endif
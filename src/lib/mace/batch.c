@@ -0,0 +1,349 @@
+// File:        batch.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include "mace/batch.h"
+
+#include <math.h>
+
+#include "mace/matrix.h"
+#include "mace/pool.h"
+#include "mace/runtime.h"
+#include "mace/small.h"
+
+// Kernels iterate over the batch in the innermost loop, with unit stride
+// and restrict-qualified streams, so the compiler vectorizes across
+// independent matrices. Batches are split across the current thread pool in
+// chunks of GRAIN matrices.
+
+#define GRAIN 4096
+
+// Streams of one batch never overlap, whatever the batch size
+#if defined(__GNUC__) && !defined(__clang__)
+#define IVDEP _Pragma("GCC ivdep")
+#else
+#define IVDEP
+#endif
+
+// Element (i, j) of a square n x n stack at batch index k
+#define AT(x, i, j) x[((i) * N + (j)) * count + k]
+
+// Declare kernel arguments structure
+typedef struct args {
+    Batch A, B, C;
+} Args;
+
+Batch emptyBatch(int count, int m, int n) {
+    // Return NULL for invalid dimensions
+    if (count < 1 || m < 1 || n < 1)
+        return NULL_BATCH;
+
+    Batch A;
+    A.count = count;
+    A.m = m;
+    A.n = n;
+    A.data = maceTryAlloc((size_t)count * m * n * sizeof(double));
+
+    // Return NULL once over budget
+    return A.data ? A : NULL_BATCH;
+}
+
+void deleteBatch(Batch *A) {
+    maceFree(A->data);
+
+    // Reset fields
+    *A = NULL_BATCH;
+}
+
+int isNullBatch(Batch A) {
+    return (A.count == 0) && (A.data == 0);
+}
+
+// -- Conversions --
+Batch matToBatch(Matrix A, int m) {
+    // Return early on rows not evenly divided into blocks
+    if (isNull(A) || m < 1 || A.m % m)
+        return NULL_BATCH;
+
+    Batch B = emptyBatch(A.m / m, m, A.n);
+
+    // Scatter stacked blocks into batch layout
+    for (int k = 0; !isNullBatch(B) && k < B.count; k++) {
+        for (int i = 0; i < B.m; i++) {
+            for (int j = 0; j < B.n; j++) {
+                B.data[(i * B.n + j) * B.count + k] = A.data[k * m + i][j];
+            }
+        }
+    }
+
+    return B;
+}
+
+Matrix batchToMat(Batch B) {
+    Matrix A = emptyMat(B.count * B.m, B.n);
+
+    // Gather batch into vertically stacked blocks
+    for (int k = 0; !isNull(A) && k < B.count; k++) {
+        for (int i = 0; i < B.m; i++) {
+            for (int j = 0; j < B.n; j++) {
+                A.data[k * B.m + i][j] = B.data[(i * B.n + j) * B.count + k];
+            }
+        }
+    }
+
+    return A; // must be freed
+}
+
+// -- Batched kernels --
+static void mulRange(void *arg, int begin, int end) {
+    Args *args = arg;
+    if (isCancelled())
+        return; // skip remaining chunks
+    int count = args->A.count, p = args->A.n;
+    const double *restrict a = args->A.data;
+    const double *restrict b = args->B.data;
+    double *restrict c = args->C.data;
+
+    for (int i = 0; i < args->C.m; i++) {
+        for (int j = 0; j < args->C.n; j++) {
+            double *restrict cij = c + (size_t)(i * args->C.n + j) * count;
+
+            // Accumulate products for every matrix in the chunk
+            for (int l = 0; l < p; l++) {
+                const double *restrict ail = a + (size_t)(i * p + l) * count;
+                const double *restrict blj = b + (size_t)(l * args->C.n + j) * count;
+                IVDEP
+                for (int k = begin; k < end; k++)
+                    cij[k] += ail[k] * blj[k];
+            }
+        }
+    }
+}
+
+static void det2Range(const double *restrict a, double *restrict d, int count, int begin, int end) {
+    enum { N = 2 };
+    IVDEP
+    for (int k = begin; k < end; k++)
+        d[k] = AT(a, 0, 0) * AT(a, 1, 1) - AT(a, 0, 1) * AT(a, 1, 0);
+}
+
+static void det3Range(const double *restrict a, double *restrict d, int count, int begin, int end) {
+    enum { N = 3 };
+    IVDEP
+    for (int k = begin; k < end; k++) {
+        d[k] = AT(a, 0, 0) * (AT(a, 1, 1) * AT(a, 2, 2) - AT(a, 1, 2) * AT(a, 2, 1)) -
+               AT(a, 0, 1) * (AT(a, 1, 0) * AT(a, 2, 2) - AT(a, 1, 2) * AT(a, 2, 0)) +
+               AT(a, 0, 2) * (AT(a, 1, 0) * AT(a, 2, 1) - AT(a, 1, 1) * AT(a, 2, 0));
+    }
+}
+
+// 2x2 sub-determinants of the top (s) and bottom (c) row pairs at index k
+#define SUBDET4(a)                                                      \
+    double s0 = AT(a, 0, 0) * AT(a, 1, 1) - AT(a, 1, 0) * AT(a, 0, 1);  \
+    double s1 = AT(a, 0, 0) * AT(a, 1, 2) - AT(a, 1, 0) * AT(a, 0, 2);  \
+    double s2 = AT(a, 0, 0) * AT(a, 1, 3) - AT(a, 1, 0) * AT(a, 0, 3);  \
+    double s3 = AT(a, 0, 1) * AT(a, 1, 2) - AT(a, 1, 1) * AT(a, 0, 2);  \
+    double s4 = AT(a, 0, 1) * AT(a, 1, 3) - AT(a, 1, 1) * AT(a, 0, 3);  \
+    double s5 = AT(a, 0, 2) * AT(a, 1, 3) - AT(a, 1, 2) * AT(a, 0, 3);  \
+    double c5 = AT(a, 2, 2) * AT(a, 3, 3) - AT(a, 3, 2) * AT(a, 2, 3);  \
+    double c4 = AT(a, 2, 1) * AT(a, 3, 3) - AT(a, 3, 1) * AT(a, 2, 3);  \
+    double c3 = AT(a, 2, 1) * AT(a, 3, 2) - AT(a, 3, 1) * AT(a, 2, 2);  \
+    double c2 = AT(a, 2, 0) * AT(a, 3, 3) - AT(a, 3, 0) * AT(a, 2, 3);  \
+    double c1 = AT(a, 2, 0) * AT(a, 3, 2) - AT(a, 3, 0) * AT(a, 2, 2);  \
+    double c0 = AT(a, 2, 0) * AT(a, 3, 1) - AT(a, 3, 0) * AT(a, 2, 1);  \
+    double det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+static void det4Range(const double *restrict a, double *restrict d, int count, int begin, int end) {
+    enum { N = 4 };
+    IVDEP
+    for (int k = begin; k < end; k++) {
+        SUBDET4(a)
+        d[k] = det;
+    }
+}
+
+static void inv2Range(const double *restrict a, double *restrict b, int count, int begin, int end) {
+    enum { N = 2 };
+    IVDEP
+    for (int k = begin; k < end; k++) {
+        double det = AT(a, 0, 0) * AT(a, 1, 1) - AT(a, 0, 1) * AT(a, 1, 0);
+        double r = 1 / det;
+        r = isfinite(r) ? r : NAN; // poison non-invertible matrices
+
+        AT(b, 0, 0) = AT(a, 1, 1) * r;
+        AT(b, 0, 1) = -AT(a, 0, 1) * r;
+        AT(b, 1, 0) = -AT(a, 1, 0) * r;
+        AT(b, 1, 1) = AT(a, 0, 0) * r;
+    }
+}
+
+static void inv3Range(const double *restrict a, double *restrict b, int count, int begin, int end) {
+    enum { N = 3 };
+    IVDEP
+    for (int k = begin; k < end; k++) {
+        double b00 = AT(a, 1, 1) * AT(a, 2, 2) - AT(a, 1, 2) * AT(a, 2, 1);
+        double b01 = AT(a, 0, 2) * AT(a, 2, 1) - AT(a, 0, 1) * AT(a, 2, 2);
+        double b02 = AT(a, 0, 1) * AT(a, 1, 2) - AT(a, 0, 2) * AT(a, 1, 1);
+        double b10 = AT(a, 1, 2) * AT(a, 2, 0) - AT(a, 1, 0) * AT(a, 2, 2);
+        double b11 = AT(a, 0, 0) * AT(a, 2, 2) - AT(a, 0, 2) * AT(a, 2, 0);
+        double b12 = AT(a, 0, 2) * AT(a, 1, 0) - AT(a, 0, 0) * AT(a, 1, 2);
+        double b20 = AT(a, 1, 0) * AT(a, 2, 1) - AT(a, 1, 1) * AT(a, 2, 0);
+        double b21 = AT(a, 0, 1) * AT(a, 2, 0) - AT(a, 0, 0) * AT(a, 2, 1);
+        double b22 = AT(a, 0, 0) * AT(a, 1, 1) - AT(a, 0, 1) * AT(a, 1, 0);
+        double det = AT(a, 0, 0) * b00 + AT(a, 0, 1) * b10 + AT(a, 0, 2) * b20;
+        double r = 1 / det;
+        r = isfinite(r) ? r : NAN; // poison non-invertible matrices
+
+        // Store only after every input has been read
+        AT(b, 0, 0) = b00 * r;
+        AT(b, 0, 1) = b01 * r;
+        AT(b, 0, 2) = b02 * r;
+        AT(b, 1, 0) = b10 * r;
+        AT(b, 1, 1) = b11 * r;
+        AT(b, 1, 2) = b12 * r;
+        AT(b, 2, 0) = b20 * r;
+        AT(b, 2, 1) = b21 * r;
+        AT(b, 2, 2) = b22 * r;
+    }
+}
+
+static void inv4Range(const double *restrict a, double *restrict b, int count, int begin, int end) {
+    enum { N = 4 };
+    IVDEP
+    for (int k = begin; k < end; k++) {
+        SUBDET4(a)
+        double r = 1 / det;
+        r = isfinite(r) ? r : NAN; // poison non-invertible matrices
+
+        AT(b, 0, 0) = (AT(a, 1, 1) * c5 - AT(a, 1, 2) * c4 + AT(a, 1, 3) * c3) * r;
+        AT(b, 0, 1) = (-AT(a, 0, 1) * c5 + AT(a, 0, 2) * c4 - AT(a, 0, 3) * c3) * r;
+        AT(b, 0, 2) = (AT(a, 3, 1) * s5 - AT(a, 3, 2) * s4 + AT(a, 3, 3) * s3) * r;
+        AT(b, 0, 3) = (-AT(a, 2, 1) * s5 + AT(a, 2, 2) * s4 - AT(a, 2, 3) * s3) * r;
+        AT(b, 1, 0) = (-AT(a, 1, 0) * c5 + AT(a, 1, 2) * c2 - AT(a, 1, 3) * c1) * r;
+        AT(b, 1, 1) = (AT(a, 0, 0) * c5 - AT(a, 0, 2) * c2 + AT(a, 0, 3) * c1) * r;
+        AT(b, 1, 2) = (-AT(a, 3, 0) * s5 + AT(a, 3, 2) * s2 - AT(a, 3, 3) * s1) * r;
+        AT(b, 1, 3) = (AT(a, 2, 0) * s5 - AT(a, 2, 2) * s2 + AT(a, 2, 3) * s1) * r;
+        AT(b, 2, 0) = (AT(a, 1, 0) * c4 - AT(a, 1, 1) * c2 + AT(a, 1, 3) * c0) * r;
+        AT(b, 2, 1) = (-AT(a, 0, 0) * c4 + AT(a, 0, 1) * c2 - AT(a, 0, 3) * c0) * r;
+        AT(b, 2, 2) = (AT(a, 3, 0) * s4 - AT(a, 3, 1) * s2 + AT(a, 3, 3) * s0) * r;
+        AT(b, 2, 3) = (-AT(a, 2, 0) * s4 + AT(a, 2, 1) * s2 - AT(a, 2, 3) * s0) * r;
+        AT(b, 3, 0) = (-AT(a, 1, 0) * c3 + AT(a, 1, 1) * c1 - AT(a, 1, 2) * c0) * r;
+        AT(b, 3, 1) = (AT(a, 0, 0) * c3 - AT(a, 0, 1) * c1 + AT(a, 0, 2) * c0) * r;
+        AT(b, 3, 2) = (-AT(a, 3, 0) * s3 + AT(a, 3, 1) * s1 - AT(a, 3, 2) * s0) * r;
+        AT(b, 3, 3) = (AT(a, 2, 0) * s3 - AT(a, 2, 1) * s1 + AT(a, 2, 2) * s0) * r;
+    }
+}
+
+static void inv1Range(const double *restrict a, double *restrict b, int count, int begin, int end) {
+    (void)count;
+    IVDEP
+    for (int k = begin; k < end; k++) {
+        double r = 1 / a[k];
+        b[k] = isfinite(r) ? r : NAN; // poison non-invertible matrices
+    }
+}
+
+// Poison inverses of matrices singular to working precision, estimating the
+// reciprocal condition from the 1-norms of each matrix and its inverse
+static void rcondRange(const double *restrict a, double *restrict b, int N, int count, int begin,
+                       int end) {
+    IVDEP
+    for (int k = begin; k < end; k++) {
+        double normA = 0, normB = 0;
+        for (int j = 0; j < N; j++) {
+            double sumA = 0, sumB = 0;
+            for (int i = 0; i < N; i++) {
+                sumA += fabs(AT(a, i, j));
+                sumB += fabs(AT(b, i, j));
+            }
+            normA = fmax(normA, sumA);
+            normB = fmax(normB, sumB);
+        }
+        double poison = 1 / (normA * normB) >= RCOND_MIN ? 1 : NAN;
+
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++)
+                AT(b, i, j) *= poison;
+    }
+}
+
+static void invRange(void *arg, int begin, int end) {
+    Args *args = arg;
+    if (isCancelled())
+        return; // skip remaining chunks
+    void (*kernels[])(const double *restrict, double *restrict, int, int, int) = {
+        inv1Range,
+        inv2Range,
+        inv3Range,
+        inv4Range,
+    };
+
+    kernels[args->A.n - 1](args->A.data, args->C.data, args->A.count, begin, end);
+    rcondRange(args->A.data, args->C.data, args->A.n, args->A.count, begin, end);
+}
+
+static void detRange(void *arg, int begin, int end) {
+    Args *args = arg;
+    if (isCancelled())
+        return; // skip remaining chunks
+
+    switch (args->A.n) {
+        case 1: // Determinant of 1x1 is itself
+            for (int k = begin; k < end; k++)
+                args->C.data[k] = args->A.data[k];
+            break;
+        case 2:
+            det2Range(args->A.data, args->C.data, args->A.count, begin, end);
+            break;
+        case 3:
+            det3Range(args->A.data, args->C.data, args->A.count, begin, end);
+            break;
+        case 4:
+            det4Range(args->A.data, args->C.data, args->A.count, begin, end);
+            break;
+    }
+}
+
+// -- Batched operations --
+Batch mulMatBatched(Batch A, Batch B) {
+    // Return early on mismatched dimensions or batch sizes
+    if (isNullBatch(A) || (A.count != B.count) || (A.n != B.m))
+        return NULL_BATCH;
+
+    Args args = {A, B, emptyBatch(A.count, A.m, B.n)};
+    if (!isNullBatch(args.C))
+        parallelFor(currentPool(), A.count, GRAIN, mulRange, &args);
+    if (isCancelled())
+        deleteBatch(&args.C); // discard partial result
+
+    return args.C; // must be freed
+}
+
+Batch inverseBatched(Batch A) {
+    // Return early on non-square or unsupported dimensions
+    if (isNullBatch(A) || (A.m != A.n) || (A.n > SMALL_MAX))
+        return NULL_BATCH;
+
+    Args args = {A, NULL_BATCH, emptyBatch(A.count, A.m, A.n)};
+    if (!isNullBatch(args.C))
+        parallelFor(currentPool(), A.count, GRAIN, invRange, &args);
+    if (isCancelled())
+        deleteBatch(&args.C); // discard partial result
+
+    return args.C; // must be freed
+}
+
+Batch detBatched(Batch A) {
+    // Return early on non-square or unsupported dimensions
+    if (isNullBatch(A) || (A.m != A.n) || (A.n > SMALL_MAX))
+        return NULL_BATCH;
+
+    Args args = {A, NULL_BATCH, emptyBatch(A.count, 1, 1)};
+    if (!isNullBatch(args.C))
+        parallelFor(currentPool(), A.count, GRAIN, detRange, &args);
+    if (isCancelled())
+        deleteBatch(&args.C); // discard partial result
+
+    return args.C; // must be freed
+}
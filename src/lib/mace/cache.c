@@ -0,0 +1,414 @@
+// File:        cache.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include "mace/cache.h"
+
+#include "mace/matrix.h"
+#include "mace/reduce.h"
+#include "mace/runtime.h"
+#include "mace/small.h"
+#include "mace/structure.h"
+
+// Entries own their matrix, and every derived result held in the cache.
+// Cached matrices are never handed out directly; callers receive copies
+// they are responsible for freeing. Borrowed entries share storage with
+// the original by reference count, so storage is copied on first write.
+// Rank-one updates refresh the factors, inverse and determinant they hold
+// in O(n^2), rather than discarding them. Borrowed entries keep the version
+// of the original, so quantities derived on a borrow may be merged back
+// while both still hold the same matrix.
+
+// Validate the cache against the current version of the entry
+static Cache *lookup(Entry *E) {
+    if (E->cache.version != E->version) {
+        clearCache(&E->cache);
+        E->cache.version = E->version;
+    }
+
+    return &E->cache;
+}
+
+Entry newEntry(Matrix A) {
+    Entry E = {};
+    E.mat = A;
+    return E;
+}
+
+void deleteEntry(Entry *E) {
+    clearCache(&E->cache);
+    if (!isNull(E->mat))
+        deleteMat(&E->mat);
+    unmapMat(&E->map);
+    deletePacked(&E->packed);
+
+    // Reset fields
+    *E = (Entry){};
+}
+
+Entry borrowEntry(Entry *E) {
+    Entry B = {};
+
+    // Packed matrices are shared until unpacked
+    if (E->packed.data) {
+        B.packed = E->packed;
+        maceRetain(B.packed.data);
+        return B;
+    }
+    if (isNull(E->mat))
+        return B;
+
+    // Mapped matrices are copied, as the mapping is owned by the entry
+    B.mat = E->map.addr ? copyMat(E->mat) : retainMat(E->mat);
+
+    // Share derived quantities that are still valid
+    Cache *cache = lookup(E);
+    B.version = E->version;
+    B.cache = *cache;
+    if (cache->valid & CACHE_LU) {
+        retainMat(cache->lu);
+        maceRetain(cache->perm);
+    }
+    if (cache->valid & CACHE_INV)
+        retainMat(cache->inv);
+    if (cache->valid & CACHE_TRNSP)
+        retainMat(cache->trnsp);
+
+    return B;
+}
+
+void mergeEntry(Entry *E, Entry *B) {
+    // Return early unless both hold the same version of one matrix
+    if (isNull(E->mat) || B->mat.data != E->mat.data || B->version != E->version)
+        return;
+
+    // Take quantities only the borrow has found, sharing storage
+    Cache *cache = lookup(E), *from = lookup(B);
+    unsigned taken = from->valid & ~cache->valid;
+    if (taken & CACHE_LU) {
+        cache->lu = retainMat(from->lu);
+        cache->perm = maceRetain(from->perm);
+        cache->sign = from->sign;
+    }
+    if (taken & CACHE_INV)
+        cache->inv = isNull(from->inv) ? from->inv : retainMat(from->inv);
+    if (taken & CACHE_TRNSP)
+        cache->trnsp = retainMat(from->trnsp);
+    if (taken & CACHE_DET)
+        cache->det = from->det;
+    if (taken & CACHE_TRC)
+        cache->trc = from->trc;
+    if (taken & CACHE_RCOND)
+        cache->rcond = from->rcond;
+    if (taken & CACHE_NORMS) {
+        for (int k = 0; k < NORMS; k++)
+            cache->norms[k] = from->norms[k];
+    }
+    if (taken & CACHE_STRUCT)
+        cache->structure = from->structure;
+    cache->valid |= taken;
+}
+
+// Copy a matrix before writing, if it is shared, failing when over budget
+static int ownMat(Matrix *A) {
+    if (!maceShared(A->data))
+        return 0;
+
+    Matrix B = copyMat(*A);
+    if (isNull(B))
+        return -1;
+    deleteMat(A);
+    *A = B;
+    return 0;
+}
+
+int ownEntry(Entry *E) {
+    return ownMat(&E->mat);
+}
+
+void updateEntry(Entry *E, const double u[], const double v[]) {
+    // Take derived quantities of the previous version
+    Cache prev = *lookup(E);
+    E->cache = (Cache){.version = E->cache.version};
+    touchEntry(E);
+    Cache *cache = lookup(E);
+
+    // Small matrices recompute faster than they update, and compensated
+    // precision refactors rather than accumulate update error
+    int refresh = !isSmall(E->mat) && currentPrecision() != PRECISION_COMPENSATED;
+
+    // Update factors, unless singular
+    if (refresh && (prev.valid & CACHE_LU) && prev.sign && !ownMat(&prev.lu)) {
+        if (!luUpdate(prev.lu, prev.perm, u, v)) {
+            cache->lu = prev.lu;
+            cache->perm = prev.perm;
+            cache->sign = prev.sign;
+            cache->det = luDeterminant(cache->lu, cache->sign);
+            cache->valid |= CACHE_LU | CACHE_DET;
+            prev.valid &= ~CACHE_LU;
+        }
+    }
+
+    // Update inverse, and determinant by the same ratio
+    double ratio;
+    if (refresh && (prev.valid & CACHE_INV) && !isNull(prev.inv) && !ownMat(&prev.inv)) {
+        if (!inverseUpdate(prev.inv, u, v, &ratio)) {
+            cache->inv = prev.inv;
+            cache->valid |= CACHE_INV;
+            prev.valid &= ~CACHE_INV;
+            if ((prev.valid & CACHE_DET) && !(cache->valid & CACHE_DET)) {
+                cache->det = prev.det * ratio;
+                cache->valid |= CACHE_DET;
+            }
+        }
+    }
+
+    // Estimate condition now, refactoring once updates leave the matrix
+    // singular to working precision, as their results are then noise
+    if (cache->valid & (CACHE_LU | CACHE_INV)) {
+        double norm = cachedNorm(E, NORM_ONE);
+        double rcond = (cache->valid & CACHE_LU) ? luRcond(cache->lu, cache->perm, norm)
+                                                 : 1 / (norm * normMat(cache->inv, NORM_ONE));
+        if (rcond < RCOND_MIN) {
+            clearCache(cache);
+        } else {
+            cache->rcond = rcond;
+            cache->valid |= CACHE_RCOND;
+        }
+    }
+
+    // Copy changed entries of the transpose
+    if ((prev.valid & CACHE_TRNSP) && !ownMat(&prev.trnsp)) {
+        for (int i = 0; i < E->mat.m; i++) {
+            for (int j = 0; u[i] && j < E->mat.n; j++) {
+                if (v[j])
+                    prev.trnsp.data[j][i] = E->mat.data[i][j];
+            }
+        }
+        cache->trnsp = prev.trnsp;
+        cache->valid |= CACHE_TRNSP;
+        prev.valid &= ~CACHE_TRNSP;
+    }
+
+    clearCache(&prev);
+
+    // Never remember cancelled quantities
+    if (isCancelled())
+        clearCache(cache);
+}
+
+void touchEntry(Entry *E) {
+    // Any mutation invalidates derived quantities
+    E->version++;
+}
+
+void clearCache(Cache *cache) {
+    if (cache->valid & CACHE_LU) {
+        deleteMat(&cache->lu);
+        maceFree(cache->perm);
+    }
+    if ((cache->valid & CACHE_INV) && !isNull(cache->inv))
+        deleteMat(&cache->inv);
+    if (cache->valid & CACHE_TRNSP)
+        deleteMat(&cache->trnsp);
+
+    // Reset fields, preserving version
+    *cache = (Cache){.version = cache->version};
+}
+
+Footprint entryFootprint(const Entry *E) {
+    const Cache *cache = &E->cache;
+    Footprint f = {
+        .matrix = maceBlockSize(E->mat.data),
+        .mapped = E->map.size,
+        .packed = E->packed.size,
+        .shared = maceShared(E->mat.data) || maceShared(E->packed.data),
+    };
+
+    // Count derived matrices still held, whether or not current
+    if (cache->valid & CACHE_LU)
+        f.cache += maceBlockSize(cache->lu.data) + maceBlockSize(cache->perm);
+    if (cache->valid & CACHE_INV)
+        f.cache += maceBlockSize(cache->inv.data);
+    if (cache->valid & CACHE_TRNSP)
+        f.cache += maceBlockSize(cache->trnsp.data);
+
+    return f;
+}
+
+// -- Memoized operations --
+Matrix cachedLU(Entry *E, int **perm, int *sign) {
+    Cache *cache = lookup(E);
+
+    // Factorize on first use
+    if (!(cache->valid & CACHE_LU)) {
+        // Return early on bad dimensions
+        if (isNull(E->mat) || !isSquare(E->mat))
+            return NULL_MATRIX;
+
+        // Factorize within the band of structured matrices
+        cache->perm = maceAlloc(E->mat.m * sizeof(int));
+        if (!cache->perm)
+            return NULL_MATRIX;
+        cache->lu = structuredDecomp(E->mat, cachedStructure(E), cache->perm, &cache->sign);
+
+        // Never remember a cancelled factorization
+        if (isNull(cache->lu)) {
+            maceFree(cache->perm);
+            cache->perm = NULL;
+            return NULL_MATRIX;
+        }
+        cache->valid |= CACHE_LU;
+    }
+
+    // Factors remain owned by the cache
+    *perm = cache->perm;
+    *sign = cache->sign;
+    return cache->lu;
+}
+
+Matrix cachedInverse(Entry *E) {
+    Cache *cache = lookup(E);
+
+    if (!(cache->valid & CACHE_INV)) {
+        // Reject matrices singular to working precision before inverting
+        if (cachedRcond(E) < RCOND_MIN) {
+            cache->inv = NULL_MATRIX;
+        } else if (isSmall(E->mat)) {
+            // Small matrices use fixed-size kernels
+            cache->inv = inverse(E->mat);
+        } else {
+            int *perm, sign;
+            Matrix LU = cachedLU(E, &perm, &sign);
+
+            Structure s = cachedStructure(E);
+            cache->inv = isNull(LU) ? NULL_MATRIX : structuredInverse(LU, perm, s);
+        }
+
+        // Never remember a cancelled or refused inverse
+        if (isCancelled() || isRefused()) {
+            if (!isNull(cache->inv))
+                deleteMat(&cache->inv);
+            return NULL_MATRIX;
+        }
+        cache->valid |= CACHE_INV;
+    }
+
+    return isNull(cache->inv) ? NULL_MATRIX : copyMat(cache->inv);
+}
+
+Matrix cachedTranspose(Entry *E) {
+    Cache *cache = lookup(E);
+
+    if (!(cache->valid & CACHE_TRNSP)) {
+        // Return early on null matrix
+        if (isNull(E->mat))
+            return NULL_MATRIX;
+
+        // Never remember a refused transpose
+        cache->trnsp = transpose(E->mat);
+        if (isNull(cache->trnsp))
+            return NULL_MATRIX;
+        cache->valid |= CACHE_TRNSP;
+    }
+
+    return copyMat(cache->trnsp);
+}
+
+double cachedDeterminant(Entry *E) {
+    Cache *cache = lookup(E);
+
+    if (!(cache->valid & CACHE_DET)) {
+        // Triangular matrices are the product of their diagonal, and small
+        // matrices use fixed-size kernels, neither factorizing
+        if (isTriangular(cachedStructure(E))) {
+            cache->det = luDeterminant(E->mat, 1);
+        } else if (isSmall(E->mat)) {
+            cache->det = determinant(E->mat);
+        } else {
+            int *perm, sign;
+            Matrix LU = cachedLU(E, &perm, &sign);
+
+            // Reuse factors shared with the inverse
+            cache->det = isNull(LU) ? 0 : luDeterminant(LU, sign);
+        }
+
+        // Never remember a cancelled or refused determinant
+        if (isCancelled() || isRefused())
+            return 0;
+        cache->valid |= CACHE_DET;
+    }
+
+    return cache->det;
+}
+
+double cachedTrace(Entry *E) {
+    Cache *cache = lookup(E);
+
+    if (!(cache->valid & CACHE_TRC)) {
+        cache->trc = trace(E->mat);
+        cache->valid |= CACHE_TRC;
+    }
+
+    return cache->trc;
+}
+
+double cachedRcond(Entry *E) {
+    Cache *cache = lookup(E);
+
+    if (!(cache->valid & CACHE_RCOND)) {
+        int *perm, sign;
+        Matrix LU = cachedLU(E, &perm, &sign);
+
+        // Return early on cancelled or refused factorization
+        if (isNull(LU))
+            return 0;
+
+        // Estimate from factors shared with the inverse
+        double rcond = luRcond(LU, perm, cachedNorm(E, NORM_ONE));
+        if (isRefused())
+            return 0;
+        cache->rcond = rcond;
+        cache->valid |= CACHE_RCOND;
+    }
+
+    return cache->rcond;
+}
+
+double cachedNorm(Entry *E, Norm type) {
+    Cache *cache = lookup(E);
+
+    if (!(cache->valid & CACHE_NORMS)) {
+        // Find every norm in the same pass
+        Matrix norms = normsMat(E->mat, AXIS_ALL, (1u << NORMS) - 1);
+
+        // Never remember cancelled norms
+        if (isNull(norms))
+            return 0;
+        for (int k = 0; k < NORMS; k++)
+            cache->norms[k] = norms.data[0][k];
+        deleteMat(&norms);
+        cache->valid |= CACHE_NORMS;
+    }
+
+    return cache->norms[type];
+}
+
+Structure cachedStructure(Entry *E) {
+    Cache *cache = lookup(E);
+
+    if (!(cache->valid & CACHE_STRUCT)) {
+        cache->structure = findStructure(E->mat);
+        cache->valid |= CACHE_STRUCT;
+    }
+
+    return cache->structure;
+}
+
+void setStructure(Entry *E, Structure s) {
+    // Structure known from how the matrix was made need not be found
+    Cache *cache = lookup(E);
+    cache->structure = s;
+    cache->valid |= CACHE_STRUCT;
+}
@@ -0,0 +1,378 @@
+// File:        checkpoint.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "mace/checkpoint.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mace/compress.h"
+#include "mace/pool.h"
+#include "mace/runtime.h"
+
+// A checkpoint is a header, an index of records, and the rows of each
+// matrix in order, starting at an offset aligned for mapping on any page
+// size. Gaps between matrices are left as holes. Compressed matrices are
+// split into blocks, packed and unpacked in parallel, preceded by the size
+// of each block. Blocks which do not compress are stored as is.
+// Checkpoints are written beside their destination, and renamed over it
+// once complete.
+
+#define CHECKPOINT_MAGIC 0x31504b434543414dULL // "MACECKP1"
+#define HEADER_SIZE 64
+#define ALIGN 65536         // bytes, a multiple of every page size
+#define BLOCK (1 << 17)     // doubles per compressed block
+#define STORED (1ULL << 63) // block size flag, for uncompressed blocks
+
+// Declare encodings
+typedef enum codec {
+    CODEC_RAW,
+    CODEC_PACKED,
+} Codec;
+
+// Declare checkpoint header structure
+typedef struct header {
+    uint64_t magic;
+    int32_t count;
+} Header;
+
+// Declare record structure
+typedef struct record {
+    int32_t slot, m, n;
+    uint32_t codec;
+    uint64_t offset, size;
+} Record;
+
+// Declare block arguments structure
+typedef struct blocks {
+    const double *x;     // unpacked entries
+    size_t count;        // unpacked entries in total
+    unsigned char **out; // packed blocks
+    uint64_t *sizes;     // packed size of each block
+    const unsigned char *in;
+    const uint64_t *offsets; // offset of each packed block
+    atomic_int failed;
+} Blocks;
+
+static size_t blockLength(const Blocks *args, int b) {
+    size_t begin = (size_t)b * BLOCK;
+    return (args->count - begin < BLOCK) ? args->count - begin : BLOCK;
+}
+
+// -- Input and output --
+static int writeAll(int fd, const void *buf, size_t size, off_t offset) {
+    for (const char *p = buf; size;) {
+        ssize_t n = pwrite(fd, p, size, offset);
+        if (n <= 0)
+            return -1;
+        p += n;
+        size -= n;
+        offset += n;
+    }
+    return 0;
+}
+
+static int readAll(int fd, void *buf, size_t size, off_t offset) {
+    for (char *p = buf; size;) {
+        ssize_t n = pread(fd, p, size, offset);
+        if (n <= 0)
+            return -1;
+        p += n;
+        size -= n;
+        offset += n;
+    }
+    return 0;
+}
+
+static uint64_t align(uint64_t offset) {
+    return (offset + ALIGN - 1) / ALIGN * ALIGN;
+}
+
+// -- Packing --
+static void packRange(void *arg, int begin, int end) {
+    Blocks *args = arg;
+
+    for (int b = begin; b < end; b++) {
+        size_t len = blockLength(args, b);
+        const double *x = args->x + (size_t)b * BLOCK;
+        args->out[b] = maceTryAlloc(packBound(len));
+        if (!args->out[b]) {
+            atomic_store(&args->failed, 1);
+            continue;
+        }
+
+        // Store blocks which would not shrink
+        args->sizes[b] = packDoubles(x, len, args->out[b], len * sizeof(double));
+        if (!args->sizes[b]) {
+            memcpy(args->out[b], x, len * sizeof(double));
+            args->sizes[b] = len * sizeof(double) | STORED;
+        }
+    }
+}
+
+// Compress a matrix, returning its packed form, or none if refused
+static Packed packMat(Matrix A) {
+    size_t count = (size_t)A.m * A.n;
+    int blocks = (count + BLOCK - 1) / BLOCK;
+
+    // Gather rows not already contiguous
+    int contiguous = 1;
+    for (int i = 1; i < A.m && contiguous; i++)
+        contiguous = A.data[i] == A.data[0] + (size_t)i * A.n;
+    double *gathered = contiguous ? NULL : maceTryAlloc(count * sizeof(double));
+    if (!contiguous && !gathered)
+        return (Packed){};
+    for (int i = 0; gathered && i < A.m; i++)
+        memcpy(gathered + (size_t)i * A.n, A.data[i], A.n * sizeof(double));
+
+    Blocks args = {.x = gathered ? gathered : A.data[0], .count = count};
+    args.out = maceAlloc(blocks * sizeof(unsigned char *));
+    args.sizes = maceAlloc(blocks * sizeof(uint64_t));
+    atomic_init(&args.failed, !args.out || !args.sizes);
+    if (!atomic_load(&args.failed))
+        parallelFor(currentPool(), blocks, 1, packRange, &args);
+
+    // Concatenate block sizes and blocks
+    Packed P = {A.m, A.n, NULL, blocks * sizeof(uint64_t)};
+    if (!atomic_load(&args.failed)) {
+        for (int b = 0; b < blocks; b++)
+            P.size += args.sizes[b] & ~STORED;
+        P.data = maceTryAlloc(P.size);
+    }
+    if (P.data) {
+        memcpy(P.data, args.sizes, blocks * sizeof(uint64_t));
+        unsigned char *p = P.data + blocks * sizeof(uint64_t);
+        for (int b = 0; b < blocks; b++) {
+            memcpy(p, args.out[b], args.sizes[b] & ~STORED);
+            p += args.sizes[b] & ~STORED;
+        }
+    } else {
+        P = (Packed){};
+    }
+    for (int b = 0; args.out && b < blocks; b++)
+        maceFree(args.out[b]);
+
+    maceFree(args.out);
+    maceFree(args.sizes);
+    maceFree(gathered);
+    return P;
+}
+
+static void unpackRange(void *arg, int begin, int end) {
+    Blocks *args = arg;
+
+    for (int b = begin; b < end; b++) {
+        size_t len = blockLength(args, b);
+        double *x = (double *)args->x + (size_t)b * BLOCK;
+        const unsigned char *in = args->in + args->offsets[b];
+        uint64_t size = args->sizes[b];
+
+        if (size & STORED) {
+            if ((size & ~STORED) == len * sizeof(double))
+                memcpy(x, in, len * sizeof(double));
+            else
+                atomic_store(&args->failed, 1);
+        } else if (unpackDoubles(in, size, x, len)) {
+            atomic_store(&args->failed, 1);
+        }
+    }
+}
+
+Matrix unpackMat(const Packed *P) {
+    size_t count = (size_t)P->m * P->n;
+    int blocks = (count + BLOCK - 1) / BLOCK;
+
+    // Return early on truncated block sizes
+    if (P->size < blocks * sizeof(uint64_t))
+        return NULL_MATRIX;
+
+    // Locate blocks, checking they lie within the packed data
+    Blocks args = {.count = count, .in = P->data};
+    uint64_t *sizes = maceAlloc(blocks * sizeof(uint64_t));
+    uint64_t *offsets = maceAlloc(blocks * sizeof(uint64_t));
+    if (!sizes || !offsets) {
+        maceFree(sizes);
+        maceFree(offsets);
+        return NULL_MATRIX;
+    }
+    memcpy(sizes, P->data, blocks * sizeof(uint64_t));
+    uint64_t offset = blocks * sizeof(uint64_t);
+    for (int b = 0; b < blocks; b++) {
+        offsets[b] = offset;
+        offset += sizes[b] & ~STORED;
+    }
+    args.sizes = sizes;
+    args.offsets = offsets;
+    atomic_init(&args.failed, offset != P->size);
+
+    // Rows of new matrices are contiguous
+    Matrix A = emptyMat(P->m, P->n);
+    if (isNull(A))
+        atomic_store(&args.failed, 1);
+    else
+        args.x = A.data[0];
+    if (!atomic_load(&args.failed))
+        parallelFor(currentPool(), blocks, 1, unpackRange, &args);
+    if (atomic_load(&args.failed))
+        deleteMat(&A);
+
+    maceFree(sizes);
+    maceFree(offsets);
+    return A;
+}
+
+void deletePacked(Packed *P) {
+    maceFree(P->data);
+
+    // Reset fields
+    *P = (Packed){};
+}
+
+// -- Checkpoints --
+int saveCheckpoint(const char *path, const Matrix mats[], const int slots[], int count,
+                   int compress) {
+    char tmp[PATH_MAX];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp))
+        return -1;
+    int fd = open(tmp, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (fd < 0)
+        return -1;
+
+    Record *records = maceAlloc((count + 1) * sizeof(Record));
+    if (!records) {
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    uint64_t offset = align(HEADER_SIZE + count * sizeof(Record));
+    uint64_t end = HEADER_SIZE + count * sizeof(Record);
+    int status = 0;
+
+    for (int k = 0; k < count && !status; k++) {
+        Matrix A = mats[k];
+        uint64_t raw = (uint64_t)A.m * A.n * sizeof(double);
+        records[k] = (Record){slots[k], A.m, A.n, CODEC_RAW, offset, raw};
+
+        // Keep compressed form only if smaller, and written raw if refused
+        Packed P = compress ? packMat(A) : (Packed){};
+        if (P.data && P.size < raw) {
+            records[k].codec = CODEC_PACKED;
+            records[k].size = P.size;
+            status = writeAll(fd, P.data, P.size, offset);
+        } else {
+            for (int i = 0; i < A.m && !status; i++)
+                status = writeAll(fd, A.data[i], A.n * sizeof(double),
+                                  offset + (uint64_t)i * A.n * sizeof(double));
+        }
+        deletePacked(&P);
+        end = offset + records[k].size;
+        offset = align(end);
+    }
+
+    // Write index once every matrix is written
+    Header header = {CHECKPOINT_MAGIC, count};
+    if (!status)
+        status = writeAll(fd, &header, sizeof(header), 0);
+    if (!status)
+        status = writeAll(fd, records, count * sizeof(Record), HEADER_SIZE);
+    if (!status)
+        status = ftruncate(fd, end);
+    maceFree(records);
+
+    // Replace destination only once complete
+    if (close(fd) || status || rename(tmp, path)) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// Restore a matrix described by a validated record
+static int restore(int fd, const Record *record, Restored *R) {
+    *R = (Restored){.slot = record->slot};
+
+    if (record->codec == CODEC_PACKED) {
+        R->packed = (Packed){record->m, record->n, maceTryAlloc(record->size), record->size};
+        if (!R->packed.data || readAll(fd, R->packed.data, record->size, record->offset)) {
+            deletePacked(&R->packed);
+            return -1;
+        }
+        return 0;
+    }
+
+    // Map privately, so writes never reach the checkpoint
+    void *addr = mmap(NULL, record->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                      record->offset);
+    if (addr == MAP_FAILED)
+        return -1;
+
+    // Point rows into mapping
+    Matrix A = {record->m, record->n, maceAlloc(record->m * sizeof(double *))};
+    if (!A.data) {
+        munmap(addr, record->size);
+        return -1;
+    }
+    for (int i = 0; i < A.m; i++)
+        A.data[i] = (double *)addr + (size_t)i * A.n;
+    R->mat = A;
+    R->map = (Mapping){addr, record->size};
+    return 0;
+}
+
+int loadCheckpoint(const char *path, Restored out[], int max) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    // Validate header
+    struct stat info;
+    Header header;
+    if (fstat(fd, &info) || readAll(fd, &header, sizeof(header), 0) ||
+        header.magic != CHECKPOINT_MAGIC || header.count < 0 || header.count > max) {
+        close(fd);
+        return -1;
+    }
+
+    // Validate records against the file
+    int count = header.count;
+    Record *records = maceAlloc((count + 1) * sizeof(Record));
+    int status = !records || readAll(fd, records, count * sizeof(Record), HEADER_SIZE);
+    for (int k = 0; k < count && !status; k++) {
+        Record *r = &records[k];
+        uint64_t raw = (uint64_t)r->m * r->n * sizeof(double);
+        status = r->m < 1 || r->n < 1 || r->offset % ALIGN || r->offset > (uint64_t)info.st_size ||
+                 r->size > (uint64_t)info.st_size - r->offset ||
+                 (r->codec == CODEC_RAW && r->size != raw) ||
+                 (r->codec != CODEC_RAW && r->codec != CODEC_PACKED);
+    }
+
+    // Restore every matrix, or none
+    int restored = 0;
+    while (!status && restored < count) {
+        if (!(status = restore(fd, &records[restored], &out[restored])))
+            restored++;
+    }
+    if (status) {
+        for (int k = 0; k < restored; k++) {
+            if (!isNull(out[k].mat))
+                deleteMat(&out[k].mat);
+            unmapMat(&out[k].map);
+            deletePacked(&out[k].packed);
+        }
+    }
+
+    maceFree(records);
+    close(fd);
+    return status ? -1 : count;
+}
@@ -0,0 +1,197 @@
+// File:        compress.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include "mace/compress.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mace/runtime.h"
+
+// Doubles are packed by grouping their bytes by significance, so that
+// signs and exponents, which vary slowly, form long runs, and then
+// compressed in the LZ4 block format: a greedy match finder over a hash of
+// four byte sequences, favouring speed over ratio. Runs of misses skip
+// ahead faster, so incompressible input costs little.
+
+#define MIN_MATCH 4
+#define LAST_LITERALS 5 // final bytes always literal
+#define MATCH_LIMIT 12  // final bytes never starting a match
+#define MAX_OFFSET 65535
+#define HASH_BITS 14
+
+static uint32_t read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Write the remainder of a length exceeding its token
+static unsigned char *putLength(unsigned char *op, size_t len) {
+    for (; len >= 255; len -= 255)
+        *op++ = 255;
+    *op++ = len;
+    return op;
+}
+
+// Read the remainder of a length exceeding its token, or fail
+static int getLength(const unsigned char **ip, const unsigned char *end, size_t *len) {
+    unsigned char byte;
+    do {
+        if (*ip >= end)
+            return -1;
+        byte = *(*ip)++;
+        *len += byte;
+    } while (byte == 255);
+
+    return 0;
+}
+
+// -- Block format --
+static size_t compressBlock(const unsigned char *src, size_t n, unsigned char *dst,
+                            size_t cap) {
+    uint32_t table[1 << HASH_BITS] = {};
+    const unsigned char *ip = src, *anchor = src, *end = src + n;
+    const unsigned char *limit = (n > MATCH_LIMIT) ? end - MATCH_LIMIT : src;
+    unsigned char *op = dst, *cend = dst + cap;
+    unsigned misses = 0;
+
+    while (ip < limit) {
+        // Find a previous occurrence of the next four bytes
+        uint32_t h = hash(read32(ip));
+        const unsigned char *ref = src + table[h];
+        table[h] = ip - src;
+        if (ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != read32(ip)) {
+            ip += 1 + (misses++ >> 6);
+            continue;
+        }
+        misses = 0;
+
+        // Extend match, leaving final bytes as literals
+        size_t len = MIN_MATCH;
+        while (ip + len < end - LAST_LITERALS && ip[len] == ref[len])
+            len++;
+
+        // Emit literals since the last match, then the match
+        size_t lit = ip - anchor;
+        if ((size_t)(cend - op) < lit + lit / 255 + len / 255 + 8)
+            return 0;
+        unsigned char *token = op++;
+        *token = ((lit < 15) ? lit : 15) << 4;
+        if (lit >= 15)
+            op = putLength(op, lit - 15);
+        memcpy(op, anchor, lit);
+        op += lit;
+        *op++ = (ip - ref) & 0xff;
+        *op++ = (ip - ref) >> 8;
+        *token |= (len - MIN_MATCH < 15) ? len - MIN_MATCH : 15;
+        if (len - MIN_MATCH >= 15)
+            op = putLength(op, len - MIN_MATCH - 15);
+
+        ip += len;
+        anchor = ip;
+    }
+
+    // Emit final literals
+    size_t lit = end - anchor;
+    if ((size_t)(cend - op) < lit + lit / 255 + 2)
+        return 0;
+    *op++ = ((lit < 15) ? lit : 15) << 4;
+    if (lit >= 15)
+        op = putLength(op, lit - 15);
+    memcpy(op, anchor, lit);
+    op += lit;
+
+    return op - dst;
+}
+
+static int decompressBlock(const unsigned char *src, size_t n, unsigned char *dst,
+                           size_t size) {
+    const unsigned char *ip = src, *end = src + n;
+    unsigned char *op = dst, *oend = dst + size;
+
+    while (ip < end) {
+        unsigned token = *ip++;
+
+        // Copy literals
+        size_t lit = token >> 4;
+        if (lit == 15 && getLength(&ip, end, &lit))
+            return -1;
+        if (lit > (size_t)(end - ip) || lit > (size_t)(oend - op))
+            return -1;
+        memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+
+        // Final sequence has no match
+        if (ip == end)
+            break;
+
+        // Copy match, which may overlap its output
+        if (end - ip < 2)
+            return -1;
+        size_t offset = ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        size_t len = token & 15;
+        if (len == 15 && getLength(&ip, end, &len))
+            return -1;
+        len += MIN_MATCH;
+        if (!offset || offset > (size_t)(op - dst) || len > (size_t)(oend - op))
+            return -1;
+        const unsigned char *ref = op - offset;
+        for (size_t k = 0; k < len; k++)
+            op[k] = ref[k];
+        op += len;
+    }
+
+    return (op == oend) ? 0 : -1;
+}
+
+// -- Packing --
+size_t packBound(size_t count) {
+    size_t n = count * sizeof(double);
+    return n + n / 255 + 16;
+}
+
+size_t packDoubles(const double *x, size_t count, unsigned char *out, size_t cap) {
+    size_t n = count * sizeof(double);
+    unsigned char *shuffled = maceTryAlloc(n);
+    const unsigned char *bytes = (const unsigned char *)x;
+
+    // Refused blocks are left to be stored as is
+    if (!shuffled)
+        return 0;
+
+    // Group bytes of equal significance
+    for (size_t i = 0; i < count; i++) {
+        for (size_t b = 0; b < sizeof(double); b++)
+            shuffled[b * count + i] = bytes[i * sizeof(double) + b];
+    }
+
+    size_t size = compressBlock(shuffled, n, out, cap);
+    maceFree(shuffled);
+    return size;
+}
+
+int unpackDoubles(const unsigned char *in, size_t size, double *x, size_t count) {
+    size_t n = count * sizeof(double);
+    unsigned char *shuffled = maceTryAlloc(n);
+    unsigned char *bytes = (unsigned char *)x;
+    if (!shuffled)
+        return -1;
+
+    int status = decompressBlock(in, size, shuffled, n);
+    for (size_t i = 0; !status && i < count; i++) {
+        for (size_t b = 0; b < sizeof(double); b++)
+            bytes[i * sizeof(double) + b] = shuffled[b * count + i];
+    }
+
+    maceFree(shuffled);
+    return status;
+}
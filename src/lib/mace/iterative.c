@@ -0,0 +1,415 @@
+// File:        iterative.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "mace/iterative.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "mace/pool.h"
+#include "mace/profile.h"
+#include "mace/runtime.h"
+#include "mace/sum.h"
+#include "mace/target.h"
+
+// Iterative solvers touch the matrix only through products with vectors,
+// which run across the current thread pool within the band of the matrix,
+// so banded matrices cost time in proportion to their band. Dot products
+// are compensated in compensated precision. Columns of the right-hand side
+// are solved one at a time, from a zero initial guess.
+//
+// Preconditioners are applied on the right in GMRES, so the residuals it
+// minimizes are those of the original system. Incomplete LU factors keep
+// the nonzero entries of the matrix within its band, dropping any fill,
+// and are unpivoted, failing on a zero pivot as Jacobi does on a zero
+// diagonal. On symmetric matrices they are symmetric, as CG requires.
+
+#define GRAIN 16384 // entries per chunk
+
+#define NULL_MATRIX \
+    (Matrix) {      \
+        0, 0, 0     \
+    }
+
+// Declare operator structure, applying a matrix and its preconditioner
+typedef struct operator {
+    Matrix A;
+    Structure s;
+    Preconditioner kind;
+    double *diagonal; // inverse diagonal, for Jacobi
+    Matrix LU;        // incomplete factors, for ILU
+} Operator;
+
+// Declare product structure, for the rows of y = Ax
+typedef struct product {
+    const Operator *op;
+    const double *x;
+    double *y;
+} Product;
+
+static int isPrecise(void) {
+    return currentPrecision() == PRECISION_COMPENSATED;
+}
+
+// First and last column within the band of row i, plus one
+static int first(const Operator *op, int i) {
+    return (i - op->s.lower > 0) ? i - op->s.lower : 0;
+}
+
+static int last(const Operator *op, int i) {
+    return (i + op->s.upper + 1 < op->A.n) ? i + op->s.upper + 1 : op->A.n;
+}
+
+// -- Vectors --
+CLONES static double dot(const double *x, const double *y, int n) {
+    if (isPrecise())
+        return dotCompensated(x, y, n);
+
+    double sum = 0;
+    for (int k = 0; k < n; k++)
+        sum += x[k] * y[k];
+    return sum;
+}
+
+static double norm(const double *x, int n) {
+    return sqrt(dot(x, x, n));
+}
+
+// Add a multiple of x to y
+CLONES static void axpy(double a, const double *x, double *y, int n) {
+    for (int k = 0; k < n; k++)
+        y[k] += a * x[k];
+}
+
+static void productRows(void *arg, int begin, int end) {
+    const Product *p = arg;
+    for (int i = begin; i < end; i++) {
+        int lo = first(p->op, i);
+        p->y[i] = dot(p->op->A.data[i] + lo, p->x + lo, last(p->op, i) - lo);
+    }
+}
+
+// Find y = Ax, within the band of A
+static void apply(const Operator *op, const double *x, double *y) {
+    Product p = {op, x, y};
+    int band = op->s.lower + op->s.upper + 1;
+    parallelFor(currentPool(), op->A.m, 1 + GRAIN / ((band < op->A.n) ? band : op->A.n),
+                productRows, &p);
+}
+
+// -- Preconditioners --
+static double *jacobi(Matrix A) {
+    double *diagonal = maceAlloc(A.n * sizeof(double));
+    if (!diagonal)
+        return NULL;
+    for (int i = 0; i < A.n; i++) {
+        // Fail on a zero diagonal
+        if (A.data[i][i] == 0) {
+            maceFree(diagonal);
+            return NULL;
+        }
+        diagonal[i] = 1 / A.data[i][i];
+    }
+    return diagonal;
+}
+
+static Matrix ilu(const Operator *op) {
+    Matrix A = op->A, LU = copyMat(A);
+    if (isNull(LU))
+        return LU;
+
+    // Eliminate below the diagonal, on the nonzeros of A only
+    for (int i = 1; i < A.n; i++) {
+        for (int k = first(op, i); k < i; k++) {
+            if (A.data[i][k] == 0)
+                continue;
+            if (LU.data[k][k] == 0) {
+                deleteMat(&LU);
+                return NULL_MATRIX;
+            }
+
+            double l = (LU.data[i][k] /= LU.data[k][k]);
+            for (int j = k + 1; j < last(op, k); j++) {
+                if (A.data[i][j] != 0)
+                    LU.data[i][j] -= l * LU.data[k][j];
+            }
+        }
+    }
+
+    // Fail on any zero pivot, including those no later row eliminated with
+    for (int k = 0; k < A.n; k++) {
+        if (LU.data[k][k] == 0) {
+            deleteMat(&LU);
+            break;
+        }
+    }
+    return LU;
+}
+
+// Find z = M^-1 r
+static void precondition(const Operator *op, const double *r, double *z) {
+    int n = op->A.n;
+    switch (op->kind) {
+        case PRECONDITIONER_JACOBI:
+            for (int i = 0; i < n; i++)
+                z[i] = op->diagonal[i] * r[i];
+            break;
+
+        case PRECONDITIONER_ILU:
+            // Forward substitution with unit L, then backward with U
+            for (int i = 0; i < n; i++) {
+                int lo = first(op, i);
+                z[i] = r[i] - dot(op->LU.data[i] + lo, z + lo, i - lo);
+            }
+            for (int i = n - 1; i >= 0; i--) {
+                int hi = last(op, i);
+                z[i] = (z[i] - dot(op->LU.data[i] + i + 1, z + i + 1, hi - i - 1)) /
+                       op->LU.data[i][i];
+            }
+            break;
+
+        default:
+            memcpy(z, r, n * sizeof(double));
+            break;
+    }
+}
+
+// -- Methods --
+// Each solves Ax = b for one column, into x, returning the iterations
+// taken, or -1 if cancelled or refused scratch space
+static int cg(const Operator *op, const double *b, double *x, double tolerance, int limit) {
+    int n = op->A.n, it = 0;
+    double *r = maceAlloc(n * sizeof(double)), *z = maceAlloc(n * sizeof(double));
+    double *p = maceAlloc(n * sizeof(double)), *q = maceAlloc(n * sizeof(double));
+    if (!r || !z || !p || !q) {
+        maceFree(r);
+        maceFree(z);
+        maceFree(p);
+        maceFree(q);
+        return -1;
+    }
+
+    // Start from zero, so the residual is b
+    double bnorm = norm(b, n);
+    memcpy(r, b, n * sizeof(double));
+    precondition(op, r, z);
+    memcpy(p, z, n * sizeof(double));
+    double rz = dot(r, z, n);
+
+    while (bnorm > 0 && it < limit && norm(r, n) > tolerance * bnorm) {
+        if (isCancelled()) {
+            it = -1;
+            break;
+        }
+        it++;
+
+        // Stop on matrices found not to be positive definite
+        apply(op, p, q);
+        double pq = dot(p, q, n);
+        if (!(pq > 0))
+            break;
+
+        double alpha = rz / pq;
+        axpy(alpha, p, x, n);
+        axpy(-alpha, q, r, n);
+
+        // Take next direction, conjugate to the others
+        precondition(op, r, z);
+        double next = dot(r, z, n), beta = next / rz;
+        rz = next;
+        for (int k = 0; k < n; k++)
+            p[k] = z[k] + beta * p[k];
+    }
+
+    maceFree(r);
+    maceFree(z);
+    maceFree(p);
+    maceFree(q);
+    return it;
+}
+
+static int gmres(const Operator *op, const double *b, double *x, double tolerance, int limit,
+                 int restart) {
+    int n = op->A.n, it = 0, m = (restart < limit) ? restart : limit;
+    Matrix V = emptyMat(m + 1, n), H = emptyMat(m + 1, m);
+    double *g = maceAlloc((m + 1) * sizeof(double)), *y = maceAlloc(m * sizeof(double));
+    double *cs = maceAlloc(m * sizeof(double)), *sn = maceAlloc(m * sizeof(double));
+    double *w = maceAlloc(n * sizeof(double)), *z = maceAlloc(n * sizeof(double));
+    if (isNull(V) || isNull(H) || !g || !y || !cs || !sn || !w || !z)
+        it = -1;
+
+    double bnorm = norm(b, n);
+    while (it >= 0 && bnorm > 0 && it < limit) {
+        // Restart from the residual of x
+        apply(op, x, w);
+        for (int k = 0; k < n; k++)
+            w[k] = b[k] - w[k];
+        double beta = norm(w, n);
+        if (beta <= tolerance * bnorm)
+            break;
+        for (int k = 0; k < n; k++)
+            V.data[0][k] = w[k] / beta;
+        memset(g, 0, (m + 1) * sizeof(double));
+        g[0] = beta;
+
+        // Extend the Krylov basis by Arnoldi, with modified Gram-Schmidt
+        int j = 0;
+        while (j < m && it < limit) {
+            if (isCancelled()) {
+                it = -1;
+                break;
+            }
+            it++;
+
+            precondition(op, V.data[j], z);
+            apply(op, z, w);
+            for (int i = 0; i <= j; i++) {
+                H.data[i][j] = dot(w, V.data[i], n);
+                axpy(-H.data[i][j], V.data[i], w, n);
+            }
+            H.data[j + 1][j] = norm(w, n);
+            if (H.data[j + 1][j] > 0) {
+                for (int k = 0; k < n; k++)
+                    V.data[j + 1][k] = w[k] / H.data[j + 1][j];
+            }
+
+            // Rotate the Hessenberg column onto the triangle
+            for (int i = 0; i < j; i++) {
+                double h = H.data[i][j];
+                H.data[i][j] = cs[i] * h + sn[i] * H.data[i + 1][j];
+                H.data[i + 1][j] = -sn[i] * h + cs[i] * H.data[i + 1][j];
+            }
+            double r = hypot(H.data[j][j], H.data[j + 1][j]);
+            cs[j] = (r > 0) ? H.data[j][j] / r : 1;
+            sn[j] = (r > 0) ? H.data[j + 1][j] / r : 0;
+            H.data[j][j] = r;
+            H.data[j + 1][j] = 0;
+            g[j + 1] = -sn[j] * g[j];
+            g[j] *= cs[j];
+
+            // Stop once converged, broken down, or the basis stops growing
+            int done = fabs(g[j + 1]) <= tolerance * bnorm || !isfinite(g[j + 1]) || r == 0;
+            j++;
+            if (done)
+                break;
+        }
+        if (it < 0)
+            break;
+
+        // Solve the triangle, then update x by M^-1 V y
+        for (int i = j - 1; i >= 0; i--) {
+            double sum = g[i];
+            for (int k = i + 1; k < j; k++)
+                sum -= H.data[i][k] * y[k];
+            y[i] = (H.data[i][i] != 0) ? sum / H.data[i][i] : 0;
+        }
+        memset(w, 0, n * sizeof(double));
+        for (int i = 0; i < j; i++)
+            axpy(y[i], V.data[i], w, n);
+        precondition(op, w, z);
+        axpy(1, z, x, n);
+
+        // Stop on a basis that stopped growing, which no restart will fix
+        if (j > 0 && H.data[j - 1][j - 1] == 0)
+            break;
+    }
+
+    if (!isNull(V))
+        deleteMat(&V);
+    if (!isNull(H))
+        deleteMat(&H);
+    maceFree(g);
+    maceFree(y);
+    maceFree(cs);
+    maceFree(sn);
+    maceFree(w);
+    maceFree(z);
+    return it;
+}
+
+static Matrix iterativeKernel(Method method, Matrix A, Structure s, Matrix B, Iteration *it) {
+    // Return early on bad dimensions
+    if (!isSquare(A) || A.n != B.m)
+        return NULL_MATRIX;
+
+    // Prepare preconditioner, failing on zero pivots
+    Operator op = {A, s, it->preconditioner};
+    it->iterations = 0;
+    it->residual = 0;
+    if (op.kind == PRECONDITIONER_JACOBI && !(op.diagonal = jacobi(A)))
+        return NULL_MATRIX;
+    if (op.kind == PRECONDITIONER_ILU && isNull(op.LU = ilu(&op)))
+        return NULL_MATRIX;
+
+    Matrix X = emptyMat(A.n, B.n);
+    double *b = maceAlloc(A.n * sizeof(double)), *x = maceAlloc(A.n * sizeof(double));
+    double *r = maceAlloc(A.n * sizeof(double));
+    if (!isNull(X) && (!b || !x || !r))
+        deleteMat(&X);
+    for (int col = 0; col < B.n && !isNull(X); col++) {
+        for (int i = 0; i < A.n; i++) {
+            b[i] = B.data[i][col];
+            x[i] = 0;
+        }
+
+        int taken = (method == METHOD_CG) ? cg(&op, b, x, it->tolerance, it->limit)
+                                          : gmres(&op, b, x, it->tolerance, it->limit, it->restart);
+        if (taken < 0) {
+            deleteMat(&X);
+            break;
+        }
+
+        // Measure the true residual, rather than the recurrence
+        apply(&op, x, r);
+        for (int i = 0; i < A.n; i++)
+            r[i] = b[i] - r[i];
+        double bnorm = norm(b, A.n), residual = bnorm ? norm(r, A.n) / bnorm : 0;
+        if (taken > it->iterations)
+            it->iterations = taken;
+        if (residual > it->residual)
+            it->residual = residual;
+
+        // Fail on iterates that overflowed, leaving an infinite residual
+        int finite = isfinite(residual);
+        for (int i = 0; finite && i < A.n; i++)
+            finite = isfinite(x[i]);
+        if (!finite) {
+            it->residual = INFINITY;
+            deleteMat(&X);
+            break;
+        }
+
+        for (int i = 0; i < A.n; i++)
+            X.data[i][col] = x[i];
+    }
+
+    maceFree(b);
+    maceFree(x);
+    maceFree(r);
+    maceFree(op.diagonal);
+    if (!isNull(op.LU))
+        deleteMat(&op.LU);
+    return X; // must be freed
+}
+
+// -- Profiled kernels --
+// Operations are counted for products with the matrix, within its band.
+Matrix iterativeSolve(Method method, Matrix A, Structure s, Matrix B, Iteration *it) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    Probe probe = beginProbe();
+    Matrix X = iterativeKernel(method, A, s, B, it);
+    uint64_t band = (uint64_t)s.lower + s.upper + 1;
+    endProbe(&probe, KERNEL_ITERATE,
+             2 * (uint64_t)it->iterations * B.n * A.n * ((band < (uint64_t)A.n) ? band : A.n));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    it->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+    return X;
+}
@@ -5,1123 +5,1026 @@
 
 #include "mace/mace.h"
 
-#include <ctype.h>
-#include <stdio.h>
+#include <math.h>
+#include <stdatomic.h>
 #include <stdlib.h>
-#include <string.h>
+#include <unistd.h>
 
+#include "mace/batch.h"
+#include "mace/cache.h"
+#include "mace/checkpoint.h"
+#include "mace/iterative.h"
+#include "mace/map.h"
 #include "mace/matrix.h"
+#include "mace/parse.h"
+#include "mace/pool.h"
+#include "mace/reduce.h"
+#include "mace/runtime.h"
+#include "mace/share.h"
+#include "mace/structure.h"
+#include "mace/tensor.h"
+
+// Bind the context runtime around kernel calls, discarding stale refusals
+#define ENTER(ctx)                                  \
+    const Runtime *saved = useRuntime(&(ctx)->runtime); \
+    maceRefused()
+#define LEAVE() useRuntime(saved)
+
+// Define context structure
+struct context {
+    int size; // number of workspace entries
+    Entry workspace[WORKSPACE_SIZE];
+    Entry ans;
+    unsigned answers; // number of times ans was replaced
+    int base;         // size of workspace when forked
+    Allocator allocator;
+    Runtime runtime;
+    Profile *profile; // owned, unlike the runtime's
+    Budget budget;    // shared by forks through the runtime
+    atomic_int cancel;
+    void *user;
+};
+
+// Unpack a restored matrix on first use
+static Status unpack(Context *ctx, Entry *E) {
+    ENTER(ctx);
+    Matrix A = unpackMat(&E->packed);
+    int refused = maceRefused();
+    LEAVE();
+    if (isNull(A))
+        return refused ? MACE_ENOMEM : MACE_EIO;
+
+    E->mat = A;
+    deletePacked(&E->packed);
+    return MACE_OK;
+}
 
-// TODO: Add "ans" as input
-// TODO: Prompt for invalid user function inputs
-
-void mace(void) {
-    printf("---------------------------------------------------------------\n");
-    printf("Welcome to the Matrix Arithmetic C-language Environment (Mace).\n");
-    printf("Copyright © 2019 Zakhary Kaplan. All rights reserved.\n");
-    printf("---------------------------------------------------------------\n\n");
-    printf("Mace is a matrix arithmetic environment programmed in C.\n"
-           "It uses bash-like syntax to perform matrix operations.\n\n");
-    printf("Type \"help\" to see a list of commands.\n");
-
-    // Allocate memory for for workspace, user input
-    int size = 0;
-    Matrix workspace[WORKSPACE_SIZE] = {};
-    Matrix ans = NULL_MATRIX;
-
-    // Begin running program
-    while (1) {
-        printf(">>> ");
-
-        // Get user input
-        char userInput[MAX] = {};
-        fgets(userInput, MAX, stdin);
-        strtok(userInput, "\n"); // remove newline from input
-
-        // Store user input as token to be processed
-        char *token = userInput;
-
-        // Validate input type
-        char commandType = validateInput(&token);
-        if (commandType != -1) {
-            Matrix output; // reserve space for output of command
-
-            switch (commandType) {
-                case 0:       // "\n"
-                    continue; // do nothing on blank input
-
-                case 1: // "help"
-                    help(token);
-                    continue;
-
-                case 2: // "bye"
-                    clr(&size, workspace, &ans);
-                    break; // quit program
-
-                case 3: // "print"
-                    print(token, size, workspace, ans);
-                    continue;
-
-                case 4: // "clr"
-                    clr(&size, workspace, &ans);
-                    continue;
-
-                case 5: // "mat"
-                    output = mat(token, ans);
-                    if (!isNull(output)) {
-                        addToWorkspace(&size, workspace, output);
-                    }
-                    continue;
-
-                case 6: // "ident"
-                    output = ident(token);
-                    if (!isNull(output)) {
-                        addToWorkspace(&size, workspace, output);
-                    }
-                    continue;
-
-                case 7: // "zeros"
-                    output = zeros(token);
-                    if (!isNull(output)) {
-                        addToWorkspace(&size, workspace, output);
-                    }
-                    continue;
-
-                case 8: // "add"
-                    output = add(token, workspace, ans);
-                    if (!isNull(output)) {
-                        deleteMat(&ans); // delete previous answer
-                        ans = output;    // overwrite answer
-                        printAns(ans);
-                    }
-                    continue;
-
-                case 9: // "sub"
-                    output = sub(token, workspace, ans);
-                    if (!isNull(output)) {
-                        deleteMat(&ans); // delete previous answer
-                        ans = output;    // overwrite answer
-                        printAns(ans);
-                    }
-                    continue;
-
-                case 10: // "mul"
-                    output = mul(token, workspace, ans);
-                    if (!isNull(output)) {
-                        deleteMat(&ans); // delete previous answer
-                        ans = output;    // overwrite answer
-                        printAns(ans);
-                    }
-                    continue;
-
-                case 11: // "scl"
-                    output = scl(token, workspace, ans);
-                    if (!isNull(output)) {
-                        deleteMat(&ans); // delete previous answer
-                        ans = output;    // overwrite answer
-                        printAns(ans);
-                    }
-                    continue;
-
-                case 12: // "trnsp"
-                    output = trnsp(token, workspace, ans);
-                    if (!isNull(output)) {
-                        deleteMat(&ans); // delete previous answer
-                        ans = output;    // overwrite answer
-                        printAns(ans);
-                    }
-                    continue;
-
-                case 13: // "inv"
-                    output = inv(token, workspace, ans);
-                    if (!isNull(output)) {
-                        deleteMat(&ans); // delete previous answer
-                        ans = output;    // overwrite answer
-                        printAns(ans);
-                    }
-                    continue;
-
-                case 14: // "det"
-                    output = det(token, workspace, ans);
-                    if (!isNull(output)) {
-                        deleteMat(&ans); // delete previous answer
-                        ans = output;    // overwrite answer
-                        printAns(ans);
-                    }
-                    continue;
-
-                case 15: // "trc"
-                    output = trc(token, workspace, ans);
-                    if (!isNull(output)) {
-                        deleteMat(&ans); // delete previous answer
-                        ans = output;    // overwrite answer
-                        printAns(ans);
-                    }
-                    continue;
-
-                default:
-                    printf("Error: unknown command.\n");
-                    break; // quit program
-            }
-
-            // Break out of program
-            break;
-        } else {
-            printf("Invalid command.\n");
-        }
-    }
+// Resolve an identifier to a workspace entry, or ans
+static Status lookup(Context *ctx, int id, Entry **E) {
+    // Return early on identifiers outside the workspace
+    if (id != ANS && (id < 0 || id >= ctx->size))
+        return MACE_EEMPTY;
+
+    *E = (id == ANS) ? &ctx->ans : &ctx->workspace[id];
+    Status status;
+    if ((*E)->packed.data && (status = unpack(ctx, *E)))
+        return status;
+
+    return isNull((*E)->mat) ? MACE_ENOANS : MACE_OK;
 }
 
-// -- Secondary functions --
-int validateInput(char *input[]) {
-    // Constant array of valid commands
-    const char *commands[] = {
-        "\n",
-        "help",
-        "bye",
-        "print",
-        "clr",
-        "mat",
-        "ident",
-        "zeros",
-        "add",
-        "sub",
-        "mul",
-        "scl",
-        "trnsp",
-        "inv",
-        "det",
-        "trc",
-    };
-    const int NUM_COMMANDS = sizeof(commands) / sizeof(char *); // number of valid commands
-
-    // Create command token
-    char *token = strtok(*input, " "); // " ("
-
-    // Search commands for match with token
-    int commandType = -1;
-    for (int i = 0; i < NUM_COMMANDS; i++) {
-        if (strcmp(token, commands[i]) == 0) {
-            commandType = i; // set command type (0 reserved for base)
-            break;
-        }
+// Replace ans with the result of an operation
+static Status setAns(Context *ctx, Matrix A, Status failure) {
+    // Discard results of cancelled operations
+    if (atomic_load(&ctx->cancel)) {
+        if (!isNull(A))
+            deleteMat(&A);
+        return MACE_ECANCELED;
     }
 
-    // Get arguments token
-    token = strtok(NULL, "\0"); // ")"
-    *input = token;
+    // Null results report the failure of the operation, unless refused
+    if (isNull(A))
+        return maceRefused() ? MACE_ENOMEM : failure;
 
-    // Return input type
-    return commandType;
+    deleteEntry(&ctx->ans);
+    ctx->ans = newEntry(A);
+    ctx->answers++;
+    return MACE_OK;
 }
 
-void printEntry(int size, Matrix workspace[], int index) {
-    printf("\n");
-    printf("Mat%c (%dx%d) = \n", index + 'A', workspace[index].m, workspace[index].n);
-    printMat(workspace[index]);
-    printf("\n");
+// Replace ans with the result of an operation, of known structure
+static Status setAnsAs(Context *ctx, Matrix A, Status failure, Structure s) {
+    Status status = setAns(ctx, A, failure);
+    if (!status)
+        setStructure(&ctx->ans, s);
+    return status;
 }
 
-void printAns(Matrix ans) {
-    printf("\n");
-    printf("MatAns (%dx%d) = \n", ans.m, ans.n);
-    printMat(ans);
-    printf("\n");
-}
+Context *newContext(const Allocator *allocator, Pool *pool) {
+    Context *ctx = calloc(1, sizeof(Context));
+    if (!ctx)
+        return NULL;
 
-void addToWorkspace(int *size, Matrix workspace[], Matrix object) {
-    if (*size < WORKSPACE_SIZE) {
-        // Add object to workspace
-        workspace[*size] = object;
+    // Default allocator and pool are used when unspecified
+    if (allocator)
+        ctx->allocator = *allocator;
+    ctx->runtime.allocator = allocator ? &ctx->allocator : NULL;
+    ctx->runtime.pool = pool;
+    ctx->runtime.cancel = &ctx->cancel;
 
-        // Incriment workspace size
-        (*size)++;
+    // Budget defaults to physical memory
+    long pages = sysconf(_SC_PHYS_PAGES), size = sysconf(_SC_PAGESIZE);
+    ctx->budget.limit = (pages > 0 && size > 0) ? (size_t)pages * size : 0;
+    ctx->runtime.budget = &ctx->budget;
 
-        // Print added item
-        printEntry(*size, workspace, *size - 1);
-    } else {
-        printf("Error: could not save new object to workspace. Clear the "
-               "workspace with clr and try again.\n");
-    }
+    return ctx;
 }
 
-int tagExists(int *size, char *tags[], char tag[]) {
-    for (int i = 0; i < *size; i++) {
-        if (strcmp(tags[i], tag) == 0) {
-            return 1;
-        }
-    }
+Context *maceFork(Context *ctx) {
+    Context *fork = calloc(1, sizeof(Context));
+    if (!fork)
+        return NULL;
+
+    // Allocate from the parent, so results may be adopted by it
+    fork->runtime = ctx->runtime;
+    fork->runtime.cancel = &fork->cancel;
+
+    // Snapshot workspace without copying matrices
+    ENTER(ctx);
+    for (int i = 0; i < ctx->size; i++)
+        fork->workspace[i] = borrowEntry(&ctx->workspace[i]);
+    fork->size = fork->base = ctx->size;
+    fork->ans = borrowEntry(&ctx->ans);
+    LEAVE();
 
-    return 0;
+    return fork;
 }
 
-// -- Commands --
-void help(char input[]) {
-    char argv[MAX];      // create copy of argument input
-    int helpCommandType; // get command type of input
-    // Check if input is not null
-    if (input != NULL) {
-        strcpy(argv, input);
-        helpCommandType = validateInput(&input);
-    } else { // No parameters entered
-        helpCommandType = 0;
+Status maceAdopt(Context *ctx, Context *fork) {
+    // Return early if entries added by fork no longer fit
+    int added = fork->size - fork->base;
+    if (ctx->size + added > WORKSPACE_SIZE)
+        return MACE_EFULL;
+    maceAdoptCaches(ctx, fork);
+
+    // Move added entries across
+    for (int i = fork->base; i < fork->size; i++) {
+        ctx->workspace[ctx->size++] = fork->workspace[i];
+        fork->workspace[i] = (Entry){};
     }
-
-    if (helpCommandType == -1) {
-        printf("\nNo help entry found for: %s\n", argv);
-        printf("Use \"help\" to see a list of available commands.\n\n");
-        return;
-    } else if (helpCommandType) {
-        printf("\nHelp menu: %s\n\n", argv);
+    fork->size = fork->base;
+
+    // Move ans across, if fork replaced it
+    if (fork->answers) {
+        deleteEntry(&ctx->ans);
+        ctx->ans = fork->ans;
+        ctx->answers++;
+        fork->ans = (Entry){};
+        fork->answers = 0;
     }
 
-    switch (helpCommandType) {
-        case 1: // "help"
-            printf("Description:\n");
-            printf("\t- Display help menu for Mace commands.\n");
-            printf("\t- Call without parameters for quick help menu.\n");
-            printf("\t- Command name parameters specify individual command help "
-                   "menu.\n");
-
-            printf("Parameters: string command (optional)\n");
+    return MACE_OK;
+}
 
-            printf("Example: help mat\n");
-            break;
+void maceAdoptCaches(Context *ctx, Context *fork) {
+    // Entries since replaced on either side hold other matrices
+    for (int i = 0; i < fork->base && i < ctx->size; i++)
+        mergeEntry(&ctx->workspace[i], &fork->workspace[i]);
+}
 
-        case 2: // "bye"
-            printf("Description: Quit the current Mace session. Closes "
-                   "program.\n");
-            break;
+Status maceBorrowAns(Context *ctx, Context *src) {
+    // Return early if source has no ans
+    if (isNull(src->ans.mat))
+        return MACE_ENOANS;
 
-        case 3: // "print"
-            printf("Description: Print all or some matricies from the "
-                   "workspace.\n");
+    ENTER(ctx);
+    Entry ans = borrowEntry(&src->ans);
+    LEAVE();
 
-            printf("Parameters: string matrix identifier(s) (optional)\n");
+    deleteEntry(&ctx->ans);
+    ctx->ans = ans;
+    return MACE_OK;
+}
 
-            printf("Note: Identifiers are the letter associated with "
-                   "a matrix in the workspace.\n");
-            printf("\t- They can be written in either capital, or "
-                   "lowercase,\n");
-            printf("\t  and may be proceeded by Mat (e.g. MatA).\n");
-            printf("\t- The ans matrix can be written as MatAns, or ans.\n");
+void maceCancel(Context *ctx) {
+    atomic_store(&ctx->cancel, 1);
+}
 
-            printf("Examples:\n");
-            printf("\t>>> print A B\n");
-            printf("\t>>> print c ans\n");
-            break;
+void *maceUserData(Context *ctx) {
+    return ctx->user;
+}
 
-        case 4: // "clr"
-            printf("Description: Clear all saved variables (including ans) "
-                   "from the workspace.\n");
-            break;
+void maceSetUserData(Context *ctx, void *user) {
+    ctx->user = user;
+}
 
-        case 5: // "mat"
-            printf("Description: Save a matrix to the "
-                   "workspace.\n");
-            printf("\t- Dimensions are "
-                   "inferred from data.\n");
-            printf("\t- Individual "
-                   "items sepeerated by space, semicolons as "
-                   "row-terminators.\n");
-            printf("\t- Save the most recent output with parameter ans.\n");
-
-            printf("Parameters: decimal data (or ans)\n");
-
-            printf("Examples:\n");
-            printf("\t>>> mat 1 2; 3 4\n");
-            printf("\t>>> mat ans\n");
-            break;
+Precision macePrecision(Context *ctx) {
+    return ctx->runtime.precision;
+}
 
-        case 6: // "ident"
-            printf("Description: Save the identity matrix sized "
-                   "nxn to the workspace.\n");
+void maceSetPrecision(Context *ctx, Precision precision) {
+    if (precision == ctx->runtime.precision)
+        return;
+    ctx->runtime.precision = precision;
 
-            printf("Parameters: integer n\n");
+    // Derived quantities were computed in the previous precision
+    for (int i = 0; i < ctx->size; i++)
+        touchEntry(&ctx->workspace[i]);
+    touchEntry(&ctx->ans);
+}
 
-            printf("Example: ident 3\n");
-            break;
+Placement macePlacement(Context *ctx) {
+    return ctx->runtime.placement;
+}
 
-        case 7: // "zeros"
-            printf("Description: Save an empty matrix of zeros sized "
-                   "mxn to the workspace.\n");
+void maceSetPlacement(Context *ctx, Placement placement) {
+    // Applies to matrices allocated from now on
+    ctx->runtime.placement = placement;
+}
 
-            printf("Parameters: integer m, n\n");
+Profile *maceProfile(Context *ctx) {
+    return ctx->runtime.profile;
+}
 
-            printf("Example: zeros 3 4\n");
-            break;
+Status maceSetProfiling(Context *ctx, int enabled) {
+    // Create profile on first use
+    if (!ctx->runtime.profile) {
+        if (!enabled)
+            return MACE_OK;
+        if (!(ctx->profile = newProfile()))
+            return MACE_EARG;
+        ctx->runtime.profile = ctx->profile;
+    }
 
-        case 8: // "add"
-            printf("Description: Perform matrix addition on two "
-                   "matricies from the workspace.\n");
+    enableProfile(ctx->runtime.profile, enabled);
+    return MACE_OK;
+}
 
-            printf("Parameters: 2 string matrix identifiers\n");
+void maceSetBudget(Context *ctx, size_t limit) {
+    // Applies to later allocations only, so may be set below current use
+    ctx->budget.limit = limit;
+}
 
-            printf("Note: Identifiers are the letter associated with "
-                   "a matrix in the workspace.\n");
-            printf("\t- They can be written in either capital, or "
-                   "lowercase,\n");
-            printf("\t  and may be proceeded by Mat (e.g. MatA).\n");
-            printf("\t- The ans matrix can be written as MatAns, or ans.\n");
+void maceMemory(Context *ctx, size_t *used, size_t *peak, size_t *limit) {
+    *used = atomic_load(&ctx->budget.used);
+    *peak = atomic_load(&ctx->budget.peak);
+    *limit = ctx->budget.limit;
+}
 
-            printf("Examples:\n");
-            printf("\t>>> add MatA MatB\n");
-            printf("\t>>> add ans C\n");
-            break;
+void deleteContext(Context *ctx) {
+    if (!ctx)
+        return;
 
-        case 9: // "sub"
-            printf("Description: Perform matrix subtraction on two "
-                   "matricies from the workspace.\n");
+    maceClear(ctx);
+    deleteProfile(ctx->profile);
+    free(ctx);
+}
 
-            printf("Parameters: 2 string matrix identifiers\n");
+const char *maceStrerror(Status status) {
+    switch (status) {
+        case MACE_OK:
+            return "success";
+        case MACE_EARG:
+            return "invalid argument";
+        case MACE_EDIM:
+            return "incompatible dimensions";
+        case MACE_ESQUARE:
+            return "input is non-square matrix";
+        case MACE_ESINGULAR:
+            return "input is not invertible";
+        case MACE_EFULL:
+            return "workspace is full";
+        case MACE_EEMPTY:
+            return "operand not recognized";
+        case MACE_ENOANS:
+            return "ans used before any operation";
+        case MACE_ESHARED:
+            return "shared matrix unavailable";
+        case MACE_ECANCELED:
+            return "operation cancelled";
+        case MACE_EILLCOND:
+            return "input is ill-conditioned";
+        case MACE_EIO:
+            return "file could not be read or written";
+        case MACE_ENOMEM:
+            return "memory budget exceeded";
+        default:
+            return "unknown error";
+    }
+}
 
-            printf("Note: Identifiers are the letter associated with "
-                   "a matrix in the workspace.\n");
-            printf("\t- They can be written in either capital, or "
-                   "lowercase,\n");
-            printf("\t  and may be proceeded by Mat (e.g. MatA).\n");
-            printf("\t- The ans matrix can be written as MatAns, or ans.\n");
+// -- Workspace --
+int maceSize(Context *ctx) {
+    return ctx->size;
+}
 
-            printf("Examples:\n");
-            printf("\t>>> sub d e\n");
-            printf("\t>>> sub MatF MatAns\n");
-            break;
+Status maceGet(Context *ctx, int id, Matrix *A) {
+    Entry *E;
+    Status status = lookup(ctx, id, &E);
 
-        case 10: // "mul"
-            printf("Description: Perform matrix multiplication on two "
-                   "matricies from the workspace.\n");
+    // Matrix remains owned by the context
+    if (!status)
+        *A = E->mat;
+    return status;
+}
 
-            printf("Parameters: 2 string matrix identifiers\n");
+Status maceStructure(Context *ctx, int id, Structure *s) {
+    Entry *E;
+    Status status = lookup(ctx, id, &E);
 
-            printf("Note: Identifiers are the letter associated with "
-                   "a matrix in the workspace.\n");
-            printf("\t- They can be written in either capital, or "
-                   "lowercase,\n");
-            printf("\t  and may be proceeded by Mat (e.g. MatA).\n");
-            printf("\t- The ans matrix can be written as MatAns, or ans.\n");
+    // Structure is found on first use
+    if (!status)
+        *s = cachedStructure(E);
+    return status;
+}
 
-            printf("Examples:\n");
-            printf("\t>>> mul a b\n");
-            printf("\t>>> mul C ans\n");
-            break;
+Status maceFootprint(Context *ctx, int id, Footprint *f) {
+    // Return early on identifiers outside the workspace
+    if (id != ANS && (id < 0 || id >= ctx->size))
+        return MACE_EEMPTY;
+
+    // Packed entries are measured without unpacking them
+    Entry *E = (id == ANS) ? &ctx->ans : &ctx->workspace[id];
+    if (isNull(E->mat) && !E->packed.data)
+        return MACE_ENOANS;
+    *f = entryFootprint(E);
+    return MACE_OK;
+}
 
-        case 11: // "scl"
-            printf("Description: Perform scalar multiplication on a "
-                   "matrix the workspace.\n");
+Status maceStore(Context *ctx, Matrix A, int *slot) {
+    // Return early on null or refused matrix, or full workspace
+    if (isNull(A))
+        return maceRefused() ? MACE_ENOMEM : MACE_EARG;
+    if (ctx->size >= WORKSPACE_SIZE)
+        return MACE_EFULL;
 
-            printf("Parameters: double scalar, string matrix identifier\n");
+    // Take ownership of matrix
+    if (slot)
+        *slot = ctx->size;
+    ctx->workspace[ctx->size++] = newEntry(A);
 
-            printf("Note: Identifiers are the letter associated with "
-                   "a matrix in the workspace.\n");
-            printf("\t- They can be written in either capital, or "
-                   "lowercase,\n");
-            printf("\t  and may be proceeded by Mat (e.g. MatA).\n");
-            printf("\t- The ans matrix can be written as MatAns, or ans.\n");
+    return MACE_OK;
+}
 
-            printf("Examples:\n");
-            printf("\t>>> scl -1.2 MatB\n");
-            printf("\t>>> mul 5 ans\n");
-            break;
+Status maceCopy(Context *ctx, int id, int *slot) {
+    Entry *E;
+    Status status = lookup(ctx, id, &E);
+    if (status)
+        return status;
+    if (ctx->size >= WORKSPACE_SIZE)
+        return MACE_EFULL;
 
-        case 12: // "trnsp"
-            printf("Description: Calculate the trnspose of a matrix "
-                   "from the workspace.\n");
+    ENTER(ctx);
+    Matrix A = copyMat(E->mat);
+    LEAVE();
 
-            printf("Parameters: string matrix identifier\n");
+    return maceStore(ctx, A, slot);
+}
 
-            printf("Note: Identifiers are the letter associated with "
-                   "a matrix in the workspace.\n");
-            printf("\t- They can be written in either capital, or "
-                   "lowercase,\n");
-            printf("\t  and may be proceeded by Mat (e.g. MatA).\n");
-            printf("\t- The ans matrix can be written as MatAns, or ans.\n");
+void maceClear(Context *ctx) {
+    for (int i = 0; i < ctx->size; i++) {
+        deleteEntry(&ctx->workspace[i]); // delete individual items
+    }
 
-            printf("Examples:\n");
-            printf("\t>>> trnsp c\n");
-            printf("\t>>> trnsp ans\n");
-            break;
+    // Reset workspace size
+    ctx->size = 0;
 
-        case 13: // "inv"
-            printf("Description: Calculate the inverse of a matrix "
-                   "from the workspace.\n");
+    // Reset ans
+    deleteEntry(&ctx->ans);
+}
 
-            printf("Parameters: string matrix identifier\n");
+// -- Sharing --
+Status maceShare(Context *ctx, int id, const char *name) {
+    Entry *E;
+    Status status = lookup(ctx, id, &E);
+    if (status)
+        return status;
+
+    ENTER(ctx);
+    Mapping map;
+    Matrix A = NULL_MATRIX;
+    if (shareMat(E->mat, name) == 0)
+        A = attachMat(name, &map);
+
+    // Back entry by the segment, releasing its private copy
+    if (!isNull(A)) {
+        deleteMat(&E->mat);
+        unmapMat(&E->map);
+        E->mat = A;
+        E->map = map;
+    }
+    LEAVE();
 
-            printf("Note: Identifiers are the letter associated with "
-                   "a matrix in the workspace.\n");
-            printf("\t- They can be written in either capital, or "
-                   "lowercase,\n");
-            printf("\t  and may be proceeded by Mat (e.g. MatA).\n");
-            printf("\t- The ans matrix can be written as MatAns, or ans.\n");
+    return isNull(A) ? MACE_ESHARED : MACE_OK;
+}
 
-            printf("Examples:\n");
-            printf("\t>>> inv D\n");
-            printf("\t>>> inv ans\n");
-            break;
+Status maceAttach(Context *ctx, const char *name, int *slot) {
+    // Return early on full workspace
+    if (ctx->size >= WORKSPACE_SIZE)
+        return MACE_EFULL;
+
+    ENTER(ctx);
+    Mapping map;
+    Matrix A = attachMat(name, &map);
+    LEAVE();
+    if (isNull(A))
+        return MACE_ESHARED;
+
+    // Entry unmaps the segment when deleted
+    if (slot)
+        *slot = ctx->size;
+    Entry *E = &ctx->workspace[ctx->size++];
+    *E = newEntry(A);
+    E->map = map;
+
+    return MACE_OK;
+}
 
-        case 14: // "det"
-            printf("Description: Calculate the determinant of a matrix "
-                   "from the workspace.\n");
+Status maceUnshare(Context *ctx, const char *name) {
+    return unshareMat(name) ? MACE_ESHARED : MACE_OK;
+}
 
-            printf("Parameters: string matrix identifier\n");
+// -- Checkpoints --
+Status maceCheckpoint(Context *ctx, const char *path, int compress) {
+    Matrix mats[WORKSPACE_SIZE + 1];
+    int slots[WORKSPACE_SIZE + 1], count = 0;
+
+    // Collect workspace in order, then ans if any
+    for (int id = 0; id <= ctx->size; id++) {
+        Entry *E;
+        int slot = (id < ctx->size) ? id : ANS;
+        Status status = lookup(ctx, slot, &E);
+        if (status == MACE_ENOANS)
+            break;
+        if (status)
+            return status;
+        mats[count] = E->mat;
+        slots[count++] = (slot == ANS) ? CHECKPOINT_ANS : slot;
+    }
 
-            printf("Note: Identifiers are the letter associated with "
-                   "a matrix in the workspace.\n");
-            printf("\t- They can be written in either capital, or "
-                   "lowercase,\n");
-            printf("\t  and may be proceeded by Mat (e.g. MatA).\n");
-            printf("\t- The ans matrix can be written as MatAns, or ans.\n");
+    ENTER(ctx);
+    int failed = saveCheckpoint(path, mats, slots, count, compress);
+    LEAVE();
 
-            printf("Examples:\n");
-            printf("\t>>> det A\n");
-            printf("\t>>> det ans\n");
-            break;
+    return failed ? MACE_EIO : MACE_OK;
+}
 
-        case 15: // "trc"
-            printf("Description: Calculate the trace of a matrix "
-                   "from the workspace.\n");
+Status maceRestore(Context *ctx, const char *path) {
+    Restored restored[WORKSPACE_SIZE + 1];
+
+    // Leave workspace untouched on failure
+    ENTER(ctx);
+    int count = loadCheckpoint(path, restored, WORKSPACE_SIZE + 1);
+    int refused = maceRefused();
+    LEAVE();
+    if (count < 0)
+        return refused ? MACE_ENOMEM : MACE_EIO;
+
+    // Replace workspace and ans, in order
+    maceClear(ctx);
+    for (int k = 0; k < count; k++) {
+        Entry E = newEntry(restored[k].mat);
+        E.map = restored[k].map;
+        E.packed = restored[k].packed;
+
+        if (restored[k].slot == CHECKPOINT_ANS) {
+            deleteEntry(&ctx->ans);
+            ctx->ans = E;
+            ctx->answers++;
+        } else if (ctx->size < WORKSPACE_SIZE) {
+            ctx->workspace[ctx->size++] = E;
+        } else {
+            deleteEntry(&E);
+        }
+    }
 
-            printf("Parameters: string matrix identifier\n");
+    return MACE_OK;
+}
 
-            printf("Note: Identifiers are the letter associated with "
-                   "a matrix in the workspace.\n");
-            printf("\t- They can be written in either capital, or "
-                   "lowercase,\n");
-            printf("\t  and may be proceeded by Mat (e.g. MatA).\n");
-            printf("\t- The ans matrix can be written as MatAns, or ans.\n");
+// -- Constructors --
+Status maceIdent(Context *ctx, int n, int *slot) {
+    // Return early on invalid dimension or full workspace
+    if (n < 1)
+        return MACE_EARG;
+    if (ctx->size >= WORKSPACE_SIZE)
+        return MACE_EFULL;
+
+    ENTER(ctx);
+    Matrix I = identityMat(n);
+    LEAVE();
+
+    // Identity matrices are known to be diagonal
+    Status status = maceStore(ctx, I, slot);
+    if (!status)
+        setStructure(&ctx->workspace[ctx->size - 1], (Structure){0, 0, 1});
+    return status;
+}
 
-            printf("Examples:\n");
-            printf("\t>>> trc b\n");
-            printf("\t>>> trc ans\n");
-            break;
+Status maceZeros(Context *ctx, int m, int n, int *slot) {
+    // Return early on invalid dimensions or full workspace
+    if (m < 1 || n < 1)
+        return MACE_EARG;
+    if (ctx->size >= WORKSPACE_SIZE)
+        return MACE_EFULL;
 
-        default:
-            // Print general help menu
-            printf("\nQuick Help Menu:\n");
-
-            printf("help\t- Get help using Mace.\n");
-            printf("bye\t- Quit program.\n");
-            printf("print\t- Print a matrix in the workspace.\n");
-            printf("clr\t- Clear the workspace.\n");
-            printf("mat\t- Make a new matrix.\n");
-            printf("ident\t- Make an identity matrix.\n");
-            printf("zeros\t- Make an empty matrix of zeros.\n");
-            printf("add\t- Add two matricies.\n");
-            printf("sub\t- Subtract two matricies.\n");
-            printf("mul\t- Multiply two matricies.\n");
-            printf("scl\t- Multiply a matrix by a scalar coefficient.\n");
-            printf("trnsp\t- Find the transpose of a matrix.\n");
-            printf("inv\t- Find the inverse of a matrix.\n");
-            printf("det\t- Find the determinant of a matrix.\n");
-            printf("trc\t- Find the trace of a matrix.\n");
-            break;
-    }
+    ENTER(ctx);
+    Matrix A = emptyMat(m, n);
+    LEAVE();
 
-    printf("\n");
+    return maceStore(ctx, A, slot);
 }
 
-void print(char input[], int size, Matrix workspace[], Matrix ans) {
-    int argc = 0;
-    char argv[MAX];
+Status maceParse(Context *ctx, const char *text, size_t len, int *slot) {
+    // Return early on full workspace
+    if (ctx->size >= WORKSPACE_SIZE)
+        return MACE_EFULL;
 
-    // Split input
-    for (char *token = strtok(input, " "); token; token = strtok(NULL, " ")) { // " ,"
-
-        // Get matrix identifier
-        if (strlen(token) == 1)
-            argv[argc++] = toupper(token[0]) - 'A';
-        // Determine if "Mat" prefix is used
-        else if (strncmp(token, "Mat", 3) == 0 && strlen(token) == 4)
-            argv[argc++] = toupper(token[3]) - 'A';
-        // Check for "ans" input
-        else if (strcmp(token, "ans") == 0 || strcmp(token, "MatAns") == 0)
-            argv[argc++] = ANS;
-    }
+    ENTER(ctx);
+    Matrix A = parseMat(text, len);
+    LEAVE();
+    if (isNull(A) && atomic_load(&ctx->cancel))
+        return MACE_ECANCELED;
 
-    // Count parameters
-    if (argc == 0) {                    // Print entire workspace
-        if (size > 0 || !isNull(ans)) { // Check if workspace is empty
-            printf("\nWorkspace (%d/%d):\n", size, WORKSPACE_SIZE);
+    return maceStore(ctx, A, slot);
+}
 
-            for (int i = 0; i < size; i++) {
-                printEntry(size, workspace, i); // iteratively print each item
-            }
+Status maceLoad(Context *ctx, const char *path, int *slot) {
+    // Return early on full workspace
+    if (ctx->size >= WORKSPACE_SIZE)
+        return MACE_EFULL;
+
+    Matrix A;
+    ENTER(ctx);
+    int failed = loadMat(path, &A);
+    LEAVE();
+    if (failed)
+        return MACE_EIO;
+    if (isNull(A) && atomic_load(&ctx->cancel))
+        return MACE_ECANCELED;
+
+    return maceStore(ctx, A, slot);
+}
 
-            if (!isNull(ans))
-                printAns(ans);
-        } else { // If empty, alert user
-            printf("\nWorkspace is empty.\n\n");
+// -- Updates --
+// Overwrite an element (i, j), row i (j < 0), or column j (i < 0) of an
+// entry in place, as a rank-one update
+static Status assign(Entry *E, int i, int j, const double x[]) {
+    // Return early if a shared matrix could not be copied
+    if (ownEntry(E))
+        return MACE_ENOMEM;
+
+    double *u = maceAlloc(E->mat.m * sizeof(double));
+    double *v = maceAlloc(E->mat.n * sizeof(double));
+    if (!u || !v) {
+        maceFree(u);
+        maceFree(v);
+        return MACE_ENOMEM;
+    }
+    Matrix A = E->mat;
+    if (j < 0) {
+        // Row i of A + e_i (x - A(i,:))^T
+        u[i] = 1;
+        for (int k = 0; k < A.n; k++) {
+            v[k] = x[k] - A.data[i][k];
+            A.data[i][k] = x[k];
         }
     } else {
-        // Print each operand
-        for (int i = 0; i < argc; i++) {
-            // Determine operand
-            Matrix operand = (argv[i] == ANS) ? ans : workspace[(unsigned)argv[i]];
-
-            // Print non null operands
-            if (!isNull(operand)) {
-                // Determine whether operand is in workspace, or is ans
-                if (argv[i] == ANS) {
-                    printAns(ans);
-                } else {
-                    printEntry(size, workspace, argv[i]);
-                }
-            } else { // Display error message for null operands
-                // Check if ans was used while null
-                if (isNull(ans) && (argv[i] == ANS)) {
-                    printf("Error: perform an operation before attempting to use "
-                           "ans.\n");
-                } else {
-                    printf("Error: operand #%d not recognized.\n", i + 1);
-                }
-            }
+        // Column j of A + (x - A(:,j)) e_j^T, or one of its elements
+        v[j] = 1;
+        for (int k = (i < 0) ? 0 : i; k < ((i < 0) ? A.m : i + 1); k++) {
+            double value = x[(i < 0) ? k : 0];
+            u[k] = value - A.data[k][j];
+            A.data[k][j] = value;
         }
     }
+    updateEntry(E, u, v);
+
+    maceFree(u);
+    maceFree(v);
+    return MACE_OK;
 }
 
-void clr(int *size, Matrix workspace[], Matrix *ans) {
-    for (int i = 0; i < *size; i++) {
-        deleteMat(&workspace[i]); // delete individual items
-    }
+// Check that a matrix is a row or column vector of the given length
+static int isVector(Matrix B, int length) {
+    return (B.m == 1 || B.n == 1) && B.m * B.n == length;
+}
 
-    // Reset workspace size
-    *size = 0;
+// Copy the entries of a vector, in order
+static double *gather(Matrix B) {
+    int length = B.m * B.n;
+    double *x = maceAlloc(length * sizeof(double));
+    if (!x)
+        return NULL;
+    for (int k = 0; k < length; k++)
+        x[k] = B.data[k / B.n][k % B.n];
+    return x;
+}
 
-    // Reset ans
-    *ans = NULL_MATRIX;
-}
-
-Matrix mat(char input[], Matrix ans) {
-    int argc = 0, rows = 0;
-    double data[MAX] = {};
-
-    char argv[MAX]; // create copy of argument input
-    // Check if input is null
-    if (input != NULL) {
-        strcpy(argv, input);
-    } else { // No data entered
-        printf("Error: no matrix data entered. For help using mat, type "
-               "\"help "
-               "mat\".\n");
-        return NULL_MATRIX;
-    }
+Status maceSet(Context *ctx, int a, int i, int j, double x) {
+    Entry *A;
+    Status status;
+    if ((status = lookup(ctx, a, &A)))
+        return status;
+    if (i < 0 || i >= A->mat.m || j < 0 || j >= A->mat.n)
+        return MACE_EARG;
 
-    // Poplate array of linear data
-    for (char *token = strtok(argv, " ;"); token; // " ,;"
-         token = strtok(NULL, " ;")) {            // " ,;"
-        data[argc++] = atof(token);               // extract value from singular data token
-    }
+    ENTER(ctx);
+    status = assign(A, i, j, &x);
+    LEAVE();
 
-    // Count row terminating semicolons in argument
-    for (char *token = strtok(input, ";"); token; token = strtok(NULL, ";"))
-        rows++;
-
-    if (strcmp(input, "ans") == 0) { // Use ans matrix as input
-        if (!isNull(ans)) {          // Check if ans is not null
-            return copyMat(ans);
-        } else { // Alert user
-            printf("Error: perform an operation before attempting to use "
-                   "ans.\n");
-            return NULL_MATRIX;
-        }
-    } else if (argc % rows == 0) { // Only create matrix if no mismatch
-        int cols = argc / rows;
-        Matrix output = emptyMat(rows,
-                                 cols); // create empty matrix of correct size
-
-        // Delineate data, and populate matrix
-        for (int i = 0; i < argc; i++) {
-            int row = i / cols;
-            int col = i % cols;
-            output.data[row][col] = data[i];
-        }
-
-        return output;
-    } else { // On mismatch, return NULL_MATRIX
-        printf("Error: could not infer dimensions from data.");
-        return NULL_MATRIX;
-    }
+    return status;
 }
 
-Matrix ident(char input[]) {
-    int argc = 0;
-    int argv[MAX];
+Status maceSetRow(Context *ctx, int a, int i, int b) {
+    Entry *A, *B;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (status = lookup(ctx, b, &B)))
+        return status;
+    if (i < 0 || i >= A->mat.m)
+        return MACE_EARG;
+    if (!isVector(B->mat, A->mat.n))
+        return MACE_EDIM;
+
+    ENTER(ctx);
+    double *x = gather(B->mat);
+    status = x ? assign(A, i, -1, x) : MACE_ENOMEM;
+    maceFree(x);
+    LEAVE();
+
+    return status;
+}
 
-    // Split input
-    for (char *token = strtok(input, " "); token; token = strtok(NULL, " ")) { // " ,"
-        argv[argc++] = atoi(token);
-    }
+Status maceSetCol(Context *ctx, int a, int j, int b) {
+    Entry *A, *B;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (status = lookup(ctx, b, &B)))
+        return status;
+    if (j < 0 || j >= A->mat.n)
+        return MACE_EARG;
+    if (!isVector(B->mat, A->mat.m))
+        return MACE_EDIM;
+
+    ENTER(ctx);
+    double *x = gather(B->mat);
+    status = x ? assign(A, -1, j, x) : MACE_ENOMEM;
+    maceFree(x);
+    LEAVE();
+
+    return status;
+}
 
-    // Count parameters
-    if (argc == 1) {
-        Matrix output = identityMat(argv[0]);
-        // Check if output is not null
-        if (isNull(output)) {
-            printf("Error: invalid dimensions. Try again with a positive "
-                   "integer.\n");
+Status maceUpdate(Context *ctx, int a, int b, int c) {
+    Entry *A, *B, *C;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (status = lookup(ctx, b, &B)) ||
+        (status = lookup(ctx, c, &C)))
+        return status;
+    if (!isVector(B->mat, A->mat.m) || !isVector(C->mat, A->mat.n))
+        return MACE_EDIM;
+
+    ENTER(ctx);
+    double *u = gather(B->mat);
+    double *v = gather(C->mat);
+
+    // Add outer product of u and v in place, once owned
+    status = (u && v && !ownEntry(A)) ? MACE_OK : MACE_ENOMEM;
+    if (!status) {
+        for (int i = 0; i < A->mat.m; i++) {
+            for (int j = 0; u[i] && j < A->mat.n; j++)
+                A->mat.data[i][j] += u[i] * v[j];
         }
-        // Return result of operation
-        return output;
-    } else {
-        printf("Error: incorrect number of parameters. (%d/1)\n", argc);
-        return NULL_MATRIX;
+        updateEntry(A, u, v);
     }
+    maceFree(u);
+    maceFree(v);
+    LEAVE();
+
+    return status;
 }
 
-Matrix zeros(char input[]) {
-    int argc = 0;
-    int argv[MAX];
+// -- Operations --
+Status maceAdd(Context *ctx, int a, int b) {
+    Entry *A, *B;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (status = lookup(ctx, b, &B)))
+        return status;
 
-    // Split input
-    for (char *token = strtok(input, " "); token; token = strtok(NULL, " ")) { // " ,"
-        argv[argc++] = atoi(token);
-    }
+    ENTER(ctx);
+    Matrix C = addMat(A->mat, B->mat);
+    Structure s = sumStructure(cachedStructure(A), cachedStructure(B));
+    LEAVE();
 
-    // Count parameters
-    if (argc == 2) {
-        Matrix output = emptyMat(argv[0], argv[1]);
-
-        // Check if output is not null
-        if (isNull(output)) {
-            printf("Error: invalid dimensions. Try again with two positive "
-                   "integers.\n");
-        }
-        // Return result of operation
-        return output;
-    } else {
-        printf("Error: incorrect number of parameters. (%d/2)\n", argc);
-        return NULL_MATRIX;
-    }
+    return setAnsAs(ctx, C, MACE_EDIM, s);
 }
 
-Matrix add(char input[], Matrix workspace[], Matrix ans) {
-    int argc = 0;
-    char argv[MAX];
+Status maceSub(Context *ctx, int a, int b) {
+    Entry *A, *B;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (status = lookup(ctx, b, &B)))
+        return status;
 
-    // Split input
-    for (char *token = strtok(input, " "); token; token = strtok(NULL, " ")) { // " ,"
+    // Return early on mismatched dimensions, which maps would broadcast
+    if (A->mat.m != B->mat.m || A->mat.n != B->mat.n)
+        return MACE_EDIM;
 
-        // Get matrix identifier
-        if (strlen(token) == 1)
-            argv[argc++] = toupper(token[0]) - 'A';
-        // Determine if "Mat" prefix is used
-        else if (strncmp(token, "Mat", 3) == 0 && strlen(token) == 4)
-            argv[argc++] = toupper(token[3]) - 'A';
-        // Check for "ans" input
-        else if (strcmp(token, "ans") == 0 || strcmp(token, "MatAns") == 0)
-            argv[argc++] = ANS;
-    }
+    // Subtract in one pass, without negating first
+    Map map = {};
+    mapLoad(&map, 0);
+    mapLoad(&map, 1);
+    mapOp(&map, OP_SUB);
 
-    // Count parameters
-    if (argc == 2) {
-        Matrix operands[2]; // determine operands
-        operands[0] = (argv[0] == ANS) ? ans : workspace[(unsigned)argv[0]];
-        operands[1] = (argv[1] == ANS) ? ans : workspace[(unsigned)argv[1]];
-
-        // Calculate output
-        Matrix output = addMat(operands[0], operands[1]);
-
-        // Check if output is null
-        if (isNull(output)) {
-            // Check if ans was used while null
-            if (isNull(ans) && (argv[0] == ANS || argv[1] == ANS)) {
-                printf("Error: perform an operation before attempting to use "
-                       "ans.\n");
-            } else if (isNull(operands[0]) || isNull(operands[1])) { // Operand is null
-                printf("Error: operand not recognized.\n");
-            } else {
-                printf("Error: incompatible operands. Try again with "
-                       "matricies of "
-                       "same dimensions.\n");
-            }
-        }
+    ENTER(ctx);
+    Matrix C = evalMap(&map, (Matrix[]){A->mat, B->mat});
+    Structure s = sumStructure(cachedStructure(A), cachedStructure(B));
+    LEAVE();
 
-        // Return result of operation
-        return output;
-    } else {
-        printf("Error: incorrect number of parameters. (%d/2)\n", argc);
-        return NULL_MATRIX;
-    }
+    return setAnsAs(ctx, C, MACE_EDIM, s);
 }
 
-Matrix sub(char input[], Matrix workspace[], Matrix ans) {
-    int argc = 0;
-    char argv[MAX];
+Status maceMap(Context *ctx, const Map *map, const int ids[]) {
+    // Resolve every operand
+    Matrix operands[MAP_OPERANDS];
+    for (int k = 0; k < map->operands; k++) {
+        Entry *E;
+        Status status;
+        if ((status = lookup(ctx, ids[k], &E)))
+            return status;
+        operands[k] = E->mat;
+    }
 
-    // Split input
-    for (char *token = strtok(input, " "); token; token = strtok(NULL, " ")) { // " ,"
+    ENTER(ctx);
+    Matrix C = evalMap(map, operands);
+    LEAVE();
 
-        // Get matrix identifier
-        if (strlen(token) == 1)
-            argv[argc++] = toupper(token[0]) - 'A';
-        // Determine if "Mat" prefix is used
-        else if (strncmp(token, "Mat", 3) == 0 && strlen(token) == 4)
-            argv[argc++] = toupper(token[3]) - 'A';
-        // Check for "ans" input
-        else if (strcmp(token, "ans") == 0 || strcmp(token, "MatAns") == 0)
-            argv[argc++] = ANS;
-    }
+    return setAns(ctx, C, MACE_EDIM);
+}
 
-    // Count parameters
-    if (argc == 2) {
-        Matrix operands[2]; // determine operands
-        operands[0] = (argv[0] == ANS) ? ans : workspace[(unsigned)argv[0]];
-        operands[1] = (argv[1] == ANS) ? ans : workspace[(unsigned)argv[1]];
-
-        // Calculate output
-        Matrix output = addMat(operands[0], coeffMat(-1, operands[1]));
-
-        // Check if output is null
-        if (isNull(output)) {
-            // Check if ans was used while null
-            if (isNull(ans) && (argv[0] == ANS || argv[1] == ANS)) {
-                printf("Error: perform an operation before attempting to use "
-                       "ans.\n");
-            } else if (isNull(operands[0]) || isNull(operands[1])) { // Operand is null
-                printf("Error: operand not recognized.\n");
-            } else {
-                printf("Error: incompatible operands. Try again with "
-                       "matricies of "
-                       "same dimensions.\n");
-            }
-        }
+Status maceMul(Context *ctx, int a, int b) {
+    Entry *A, *B;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (status = lookup(ctx, b, &B)))
+        return status;
 
-        // Return result of operation
-        return output;
-    } else {
-        printf("Error: incorrect number of parameters. (%d/2)\n", argc);
-        return NULL_MATRIX;
-    }
+    // Multiply within the bands of structured operands
+    ENTER(ctx);
+    Structure sa = cachedStructure(A), sb = cachedStructure(B);
+    Matrix C = structuredMul(A->mat, sa, B->mat, sb);
+    LEAVE();
+
+    return setAnsAs(ctx, C, MACE_EDIM, productStructure(sa, sb, C));
 }
 
-Matrix mul(char input[], Matrix workspace[], Matrix ans) {
-    int argc = 0;
-    char argv[MAX];
+Status maceKron(Context *ctx, int a, int b) {
+    Entry *A, *B;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (status = lookup(ctx, b, &B)))
+        return status;
 
-    // Split input
-    for (char *token = strtok(input, " "); token; token = strtok(NULL, " ")) { // " ,"
+    ENTER(ctx);
+    Matrix C = kronMat(A->mat, B->mat);
+    LEAVE();
 
-        // Get matrix identifier
-        if (strlen(token) == 1)
-            argv[argc++] = toupper(token[0]) - 'A';
-        // Determine if "Mat" prefix is used
-        else if (strncmp(token, "Mat", 3) == 0 && strlen(token) == 4)
-            argv[argc++] = toupper(token[3]) - 'A';
-        // Check for "ans" input
-        else if (strcmp(token, "ans") == 0 || strcmp(token, "MatAns") == 0)
-            argv[argc++] = ANS;
-    }
+    return setAns(ctx, C, MACE_EARG);
+}
 
-    // Count parameters
-    if (argc == 2) {
-        Matrix operands[2]; // determine operands
-        operands[0] = (argv[0] == ANS) ? ans : workspace[(unsigned)argv[0]];
-        operands[1] = (argv[1] == ANS) ? ans : workspace[(unsigned)argv[1]];
-
-        // Calculate output
-        Matrix output = mulMat(operands[0], operands[1]);
-
-        // Check if output is null
-        if (isNull(output)) {
-            // Check if ans was used while null
-            if (isNull(ans) && (argv[0] == ANS || argv[1] == ANS)) {
-                printf("Error: perform an operation before attempting to use "
-                       "ans.\n");
-            } else if (isNull(operands[0]) || isNull(operands[1])) { // Operand is null
-                printf("Error: operand not recognized.\n");
-            } else {
-                printf("Error: incompatible operands. Try again with "
-                       "matricies of "
-                       "valid dimensions to perform this operation.\n");
-            }
-        }
+Status maceKronMul(Context *ctx, int a, int b, int x) {
+    Entry *A, *B, *X;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (status = lookup(ctx, b, &B)) ||
+        (status = lookup(ctx, x, &X)))
+        return status;
 
-        // Return result of operation
-        return output;
-    } else {
-        printf("Error: incorrect number of parameters. (%d/2)\n", argc);
-        return NULL_MATRIX;
-    }
+    // Multiply without forming the Kronecker product
+    ENTER(ctx);
+    Matrix C = kronMulMat(A->mat, B->mat, X->mat);
+    LEAVE();
+
+    return setAns(ctx, C, MACE_EDIM);
 }
 
-Matrix scl(char input[], Matrix workspace[], Matrix ans) {
-    int argc = 0;
-    double argv[MAX];
+Status maceHadamard(Context *ctx, int a, int b) {
+    Entry *A, *B;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (status = lookup(ctx, b, &B)))
+        return status;
 
-    // Get scalar from first input
-    char *token = strtok(input, " ");
-    argv[argc++] = atof(token);
-    // Set first input to value of "ans" if defined
-    if (strcmp(token, "ans") == 0 || strcmp(token, "MatAns") == 0) {
-        if (ans.m == 1 && isSquare(ans)) {
-            argv[argc - 1] = ans.data[0][0];
-        } else {
-            printf("Error: perform an operation before attempting to use "
-                   "ans.\n");
-            return NULL_MATRIX;
-        }
-    }
+    ENTER(ctx);
+    Matrix C = hadamardMat(A->mat, B->mat);
+    LEAVE();
 
-    // Split further input
-    for (char *token = strtok(NULL, " "); token; token = strtok(NULL, " ")) { // " ,"
-
-        // Get matrix identifier
-        if (strlen(token) == 1)
-            argv[argc++] = toupper(token[0]) - 'A';
-        // Determine if "Mat" prefix is used
-        else if (strncmp(token, "Mat", 3) == 0 && strlen(token) == 4)
-            argv[argc++] = toupper(token[3]) - 'A';
-        // Check for "ans" input
-        else if (strcmp(token, "ans") == 0 || strcmp(token, "MatAns") == 0)
-            argv[argc++] = ANS;
-    }
+    return setAns(ctx, C, MACE_EDIM);
+}
 
-    // Count parameters
-    if (argc == 2) {
-        // Determine matrix operand
-        Matrix operand = (argv[1] == ANS) ? ans : workspace[(int)argv[1]];
-
-        // Calculate output
-        Matrix output = coeffMat(argv[0], operand);
-
-        // Check if output is null
-        if (isNull(output)) {
-            // Check if ans was used while null
-            if (isNull(ans) && (argv[0] == ANS || argv[1] == ANS)) {
-                printf("Error: perform an operation before attempting to use "
-                       "ans.\n");
-            } else if (isNull(operand)) { // Operand is null
-                printf("Error: operand not recognized.\n");
-            } else {
-                printf("Error: could not perform operation.\n");
-            }
-        }
+Status maceOuter(Context *ctx, int u, int v) {
+    Entry *U, *V;
+    Status status;
+    if ((status = lookup(ctx, u, &U)) || (status = lookup(ctx, v, &V)))
+        return status;
 
-        // Return result of operation
-        return output;
-    } else {
-        printf("Error: incorrect number of parameters. (%d/2)\n", argc);
-        return NULL_MATRIX;
-    }
+    ENTER(ctx);
+    Matrix C = outerMat(U->mat, V->mat);
+    LEAVE();
+
+    return setAns(ctx, C, MACE_EDIM);
 }
 
-Matrix trnsp(char input[], Matrix workspace[], Matrix ans) {
-    int argc = 0;
-    char argv[MAX];
+Status maceScl(Context *ctx, double coeff, int a) {
+    Entry *A;
+    Status status;
+    if ((status = lookup(ctx, a, &A)))
+        return status;
 
-    // Split input
-    for (char *token = strtok(input, " "); token; token = strtok(NULL, " ")) { // " ,"
+    ENTER(ctx);
+    Matrix C = coeffMat(coeff, A->mat);
+    Structure s = cachedStructure(A);
+    LEAVE();
 
-        // Get matrix identifier
-        if (strlen(token) == 1)
-            argv[argc++] = toupper(token[0]) - 'A';
-        // Determine if "Mat" prefix is used
-        else if (strncmp(token, "Mat", 3) == 0 && strlen(token) == 4)
-            argv[argc++] = toupper(token[3]) - 'A';
-        // Check for "ans" input
-        else if (strcmp(token, "ans") == 0 || strcmp(token, "MatAns") == 0)
-            argv[argc++] = ANS;
-    }
+    return setAnsAs(ctx, C, MACE_EARG, s);
+}
 
-    // Count parameters
-    if (argc == 1) {
-        // Determine operand
-        Matrix operand = (argv[0] == ANS) ? ans : workspace[(unsigned)argv[0]];
-
-        // Calculate output
-        Matrix output = transpose(operand);
-
-        // Check if output is null
-        if (isNull(output)) {
-            // Check if ans was used while null
-            if (isNull(ans) && (argv[0] == ANS || argv[1] == ANS)) {
-                printf("Error: perform an operation before attempting to use "
-                       "ans.\n");
-            } else if (isNull(operand)) {
-                printf("Error: operand not recognized.\n");
-            } else {
-                printf("Error: could not perform operation.\n");
-            }
-        }
+Status maceTrnsp(Context *ctx, int a) {
+    Entry *A;
+    Status status;
+    if ((status = lookup(ctx, a, &A)))
+        return status;
 
-        // Return result of operation
-        return output;
-    } else {
-        printf("Error: incorrect number of parameters. (%d/1)\n", argc);
-        return NULL_MATRIX;
-    }
+    ENTER(ctx);
+    Matrix C = cachedTranspose(A);
+    Structure s = transposeStructure(cachedStructure(A));
+    LEAVE();
+
+    return setAnsAs(ctx, C, MACE_EARG, s);
 }
 
-Matrix inv(char input[], Matrix workspace[], Matrix ans) {
-    int argc = 0;
-    char argv[MAX];
+Status maceInv(Context *ctx, int a) {
+    Entry *A;
+    Status status;
+    if ((status = lookup(ctx, a, &A)))
+        return status;
+    if (!isSquare(A->mat))
+        return MACE_ESQUARE;
+
+    ENTER(ctx);
+    Matrix C = cachedInverse(A);
+    double rcond = cachedRcond(A);
+    Structure s = inverseStructure(cachedStructure(A), A->mat);
+    LEAVE();
+
+    // Distinguish exactly singular matrices from ill-conditioned ones
+    return setAnsAs(ctx, C, (rcond > 0) ? MACE_EILLCOND : MACE_ESINGULAR, s);
+}
 
-    // Split input
-    for (char *token = strtok(input, " "); token; token = strtok(NULL, " ")) { // " ,"
+Status maceSolve(Context *ctx, int a, int b) {
+    Entry *A, *B;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (status = lookup(ctx, b, &B)))
+        return status;
+    if (!isSquare(A->mat))
+        return MACE_ESQUARE;
+    if (A->mat.n != B->mat.m)
+        return MACE_EDIM;
+
+    // Reject matrices singular to working precision, as when inverting
+    ENTER(ctx);
+    double rcond = cachedRcond(A);
+    int *perm, sign;
+    Matrix LU = cachedLU(A, &perm, &sign);
+    Matrix X = (rcond < RCOND_MIN || isNull(LU)) ? NULL_MATRIX : structuredSolve(LU, perm, B->mat);
+    LEAVE();
+
+    return setAns(ctx, X, (rcond > 0) ? MACE_EILLCOND : MACE_ESINGULAR);
+}
 
-        // Get matrix identifier
-        if (strlen(token) == 1)
-            argv[argc++] = toupper(token[0]) - 'A';
-        // Determine if "Mat" prefix is used
-        else if (strncmp(token, "Mat", 3) == 0 && strlen(token) == 4)
-            argv[argc++] = toupper(token[3]) - 'A';
-        // Check for "ans" input
-        else if (strcmp(token, "ans") == 0 || strcmp(token, "MatAns") == 0)
-            argv[argc++] = ANS;
-    }
+Status maceIterate(Context *ctx, Method method, int a, int b, Iteration *it) {
+    Entry *A, *B;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (status = lookup(ctx, b, &B)))
+        return status;
+    if (!isSquare(A->mat))
+        return MACE_ESQUARE;
+    if (A->mat.n != B->mat.m)
+        return MACE_EDIM;
+    if (!(it->tolerance > 0) || it->limit < 1 || it->restart < 1)
+        return MACE_EARG;
+
+    // Conjugate gradients need symmetric matrices
+    ENTER(ctx);
+    Structure s = cachedStructure(A);
+    Matrix X = (method == METHOD_CG && !s.symmetric)
+                   ? NULL_MATRIX
+                   : iterativeSolve(method, A->mat, s, B->mat, it);
+    LEAVE();
+    if (method == METHOD_CG && !s.symmetric)
+        return MACE_EARG;
+
+    // Null results are due to zero pivots in the preconditioner, or to
+    // iterates that broke down
+    return setAns(ctx, X, isfinite(it->residual) ? MACE_ESINGULAR : MACE_EILLCOND);
+}
 
-    // Count parameters
-    if (argc == 1) {
-        // Determine operand
-        Matrix operand = (argv[0] == ANS) ? ans : workspace[(unsigned)argv[0]];
-
-        if (isSquare(operand)) {
-            // Calculate output
-            Matrix output = inverse(operand);
-
-            // Check if output is null
-            if (isNull(output)) {
-                // Check if ans was used while null
-                if (isNull(ans) && (argv[0] == ANS)) {
-                    printf("Error: perform an operation before attempting to "
-                           "use "
-                           "ans.\n");
-                } else if (isNull(operand)) {
-                    printf("Error: operand not recognized.\n");
-                } else {
-                    printf("Error: input is not invertible.\n");
-                }
-            }
-
-            // Return result of operation
-            return output;
-        } else {
-            printf("Error: input is non-square matrix.\n");
-            return NULL_MATRIX;
-        }
-    } else {
-        printf("Error: incorrect number of parameters. (%d/q)\n", argc);
-        return NULL_MATRIX;
-    }
+Status maceDet(Context *ctx, int a) {
+    Entry *A;
+    Status status;
+    if ((status = lookup(ctx, a, &A)))
+        return status;
+    if (!isSquare(A->mat))
+        return MACE_ESQUARE;
+
+    // Refused factors leave no determinant
+    ENTER(ctx);
+    double det = cachedDeterminant(A);
+    Matrix C = isRefused() ? NULL_MATRIX : doubleToMat(det);
+    LEAVE();
+
+    return setAns(ctx, C, MACE_EARG);
 }
 
-Matrix det(char input[], Matrix workspace[], Matrix ans) {
-    int argc = 0;
-    char argv[MAX];
+Status maceTrc(Context *ctx, int a) {
+    Entry *A;
+    Status status;
+    if ((status = lookup(ctx, a, &A)))
+        return status;
+    if (!isSquare(A->mat))
+        return MACE_ESQUARE;
 
-    // Split input
-    for (char *token = strtok(input, " "); token; token = strtok(NULL, " ")) { // " ,"
+    ENTER(ctx);
+    double trc = cachedTrace(A);
+    Matrix C = isRefused() ? NULL_MATRIX : doubleToMat(trc);
+    LEAVE();
 
-        // Get matrix identifier
-        if (strlen(token) == 1)
-            argv[argc++] = toupper(token[0]) - 'A';
-        // Determine if "Mat" prefix is used
-        else if (strncmp(token, "Mat", 3) == 0 && strlen(token) == 4)
-            argv[argc++] = toupper(token[3]) - 'A';
-        // Check for "ans" input
-        else if (strcmp(token, "ans") == 0 || strcmp(token, "MatAns") == 0)
-            argv[argc++] = ANS;
-    }
+    return setAns(ctx, C, MACE_EARG);
+}
 
-    // Count parameters
-    if (argc == 1) {
-        // Determine operand
-        Matrix operand = (argv[0] == ANS) ? ans : workspace[(unsigned)argv[0]];
-
-        if (isSquare(operand)) {
-            // Calculate output
-            Matrix output = doubleToMat(determinant(operand));
-
-            // Check if output is null
-            if (isNull(output)) {
-                printf("Error: could not perform operation.\n");
-            }
-
-            // Check if input is incorrectly zero
-            if ((output.m == 1) && (output.n == 1) && (output.data[0][0] == 0)) {
-                // Check if ans was used while null
-                if (isNull(ans) && (argv[0] == ANS)) {
-                    printf("Error: perform an operation before attempting to "
-                           "use ans.\n");
-                } else if (isNull(operand)) {
-                    printf("Error: operand not recognized.\n");
-                } else { // Return output if zero determinant is correct
-                    return output;
-                }
-
-                // Return null on false zero determinant
-                return NULL_MATRIX;
-            }
-
-            // Return result of operation
-            return output;
-        } else {
-            printf("Error: input is non-square matrix.\n");
-            return NULL_MATRIX;
-        }
-    } else {
-        printf("Error: incorrect number of parameters. (%d/1)\n", argc);
-        return NULL_MATRIX;
-    }
+Status maceCond(Context *ctx, int a) {
+    Entry *A;
+    Status status;
+    if ((status = lookup(ctx, a, &A)))
+        return status;
+    if (!isSquare(A->mat))
+        return MACE_ESQUARE;
+
+    // Singular matrices have infinite condition, unlike refused factors
+    ENTER(ctx);
+    double rcond = cachedRcond(A);
+    Matrix C = isRefused() ? NULL_MATRIX : doubleToMat(1 / rcond);
+    LEAVE();
+
+    return setAns(ctx, C, MACE_EARG);
 }
 
-Matrix trc(char input[], Matrix workspace[], Matrix ans) {
-    int argc = 0;
-    char argv[MAX];
+Status maceReduce(Context *ctx, unsigned mask, Axis axis, int a) {
+    Entry *A;
+    Status status;
+    if ((status = lookup(ctx, a, &A)))
+        return status;
 
-    // Split input
-    for (char *token = strtok(input, " "); token; token = strtok(NULL, " ")) { // " ,"
+    ENTER(ctx);
+    Matrix C = reduceMat(A->mat, axis, mask);
+    LEAVE();
 
-        // Get matrix identifier
-        if (strlen(token) == 1)
-            argv[argc++] = toupper(token[0]) - 'A';
-        // Determine if "Mat" prefix is used
-        else if (strncmp(token, "Mat", 3) == 0 && strlen(token) == 4)
-            argv[argc++] = toupper(token[3]) - 'A';
-        // Check for "ans" input
-        else if (strcmp(token, "ans") == 0 || strcmp(token, "MatAns") == 0)
-            argv[argc++] = ANS;
-    }
+    return setAns(ctx, C, MACE_EARG);
+}
 
-    // Count parameters
-    if (argc == 1) {
-        // Determine operand
-        Matrix operand = (argv[0] == ANS) ? ans : workspace[(unsigned)argv[0]];
-
-        if (isSquare(operand)) {
-            // Calculate output
-            Matrix output = doubleToMat(trace(operand));
-
-            // Check if output is null
-            if (isNull(output)) {
-                printf("Error: could not perform operation.\n");
-            }
-
-            // Check if input is incorrectly zero
-            if ((output.m == 1) && (output.n == 1) && (output.data[0][0] == 0)) {
-                // Check if ans was used while null
-                if (isNull(ans) && (argv[0] == ANS)) {
-                    printf("Error: perform an operation before attempting to "
-                           "use "
-                           "ans.\n");
-                } else if (isNull(operand)) {
-                    printf("Error: operand not recognized.\n");
-                } else { // Return output if zero determinant is correct
-                    return output;
-                }
-
-                // Return null on false zero determinant
-                return NULL_MATRIX;
-            }
-
-            // Return result of operation
-            return output;
-        } else {
-            printf("Error: input is non-square matrix.\n");
-            return NULL_MATRIX;
+Status maceNorm(Context *ctx, unsigned mask, Axis axis, int a) {
+    Entry *A;
+    Status status;
+    if ((status = lookup(ctx, a, &A)))
+        return status;
+
+    ENTER(ctx);
+    Matrix C = NULL_MATRIX;
+    mask &= (1u << NORMS) - 1;
+    if (axis != AXIS_ALL || !mask) {
+        C = normsMat(A->mat, axis, mask);
+    } else {
+        // Matrix norms are memoized together, unless refused
+        C = emptyMat(1, __builtin_popcount(mask));
+        for (int k = 0, r = 0; !isNull(C) && r < NORMS; r++) {
+            if (mask & (1u << r))
+                C.data[0][k++] = cachedNorm(A, r);
         }
+        if (!isNull(C) && isRefused())
+            deleteMat(&C);
+    }
+    LEAVE();
+
+    return setAns(ctx, C, MACE_EARG);
+}
+
+Status maceBatch(Context *ctx, BatchOp op, int a, int b) {
+    Entry *A, *B = NULL;
+    Status status;
+    if ((status = lookup(ctx, a, &A)) || (op == BATCH_MUL && (status = lookup(ctx, b, &B))))
+        return status;
+
+    ENTER(ctx);
+    // Split operands into stacks of square blocks
+    Batch stackA = matToBatch(A->mat, A->mat.n);
+    Batch stackB = B ? matToBatch(B->mat, B->mat.n) : NULL_BATCH;
+
+    // Calculate result
+    Batch result = NULL_BATCH;
+    if (isNullBatch(stackA) || (B && isNullBatch(stackB))) {
+        status = maceRefused() ? MACE_ENOMEM : MACE_EARG;
     } else {
-        printf("Error: incorrect number of parameters. (%d/1)\n", argc);
-        return NULL_MATRIX;
+        if (op == BATCH_MUL)
+            result = mulMatBatched(stackA, stackB);
+        else if (op == BATCH_INV)
+            result = inverseBatched(stackA);
+        else
+            result = detBatched(stackA);
+        status = !isNullBatch(result) ? MACE_OK
+                 : isCancelled()      ? MACE_ECANCELED
+                 : maceRefused()      ? MACE_ENOMEM
+                                      : MACE_EDIM;
     }
+    Matrix C = isNullBatch(result) ? NULL_MATRIX : batchToMat(result);
+
+    // Delete intermediate stacks
+    deleteBatch(&stackA);
+    deleteBatch(&stackB);
+    deleteBatch(&result);
+    LEAVE();
+
+    return status ? status : setAns(ctx, C, MACE_EDIM);
 }
@@ -0,0 +1,281 @@
+// File:        map.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include "mace/map.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mace/pool.h"
+#include "mace/profile.h"
+#include "mace/runtime.h"
+#include "mace/target.h"
+
+// Maps run their whole program over a block of each row at a time, so
+// intermediate values stay in cache and every operand is read once. Loads
+// point into operands without copying, broadcast columns and constants are
+// held as scalars, and the final operation writes into the result. Rows
+// are split across the current thread pool in chunks of about GRAIN
+// entries.
+
+#define GRAIN 16384 // entries per chunk
+#define BLOCK 256   // entries per block
+
+// Elementwise operations, as expressions of a and b
+#define UNARY(X)       \
+    X(OP_NEG, -a)      \
+    X(OP_ABS, fabs(a)) \
+    X(OP_EXP, exp(a))  \
+    X(OP_LOG, log(a))  \
+    X(OP_SQRT, sqrt(a))
+#define BINARY(X)              \
+    X(OP_ADD, a + b)           \
+    X(OP_SUB, a - b)           \
+    X(OP_MUL, a * b)           \
+    X(OP_DIV, a / b)           \
+    X(OP_MIN, (b < a) ? b : a) \
+    X(OP_MAX, (b > a) ? b : a) \
+    X(OP_LT, a < b)            \
+    X(OP_GT, a > b)            \
+    X(OP_EQ, a == b)
+
+// Declare value structure, a scalar when x is null
+typedef struct value {
+    const double *x;
+    double s;
+} Value;
+
+// Declare kernel arguments structure
+typedef struct args {
+    const Map *map;
+    const Matrix *operands;
+    Matrix C;
+    int grain; // rows per chunk
+} Args;
+
+static int isUnary(Op op) {
+    return op >= OP_NEG && op < OP_ADD;
+}
+
+static int isBinary(Op op) {
+    return op >= OP_ADD && op <= OP_EQ;
+}
+
+// -- Building --
+static int append(Map *map, Instr instr) {
+    // Return early on full map
+    if (map->length == MAP_LENGTH)
+        return -1;
+
+    map->code[map->length++] = instr;
+    return 0;
+}
+
+int mapLoad(Map *map, int operand) {
+    // Return early on operands out of range
+    if (operand < 0 || operand >= MAP_OPERANDS)
+        return -1;
+
+    if (operand >= map->operands)
+        map->operands = operand + 1;
+    return append(map, (Instr){.op = OP_LOAD, .operand = operand});
+}
+
+int mapConst(Map *map, double value) {
+    return append(map, (Instr){.op = OP_CONST, .value = value});
+}
+
+int mapOp(Map *map, Op op) {
+    // Return early on values
+    if (!isUnary(op) && !isBinary(op))
+        return -1;
+
+    return append(map, (Instr){.op = op});
+}
+
+int mapShape(const Map *map, const Matrix operands[], int *m, int *n) {
+    *m = *n = 1;
+
+    // Check program leaves a single value without overflowing the stack
+    int depth = 0;
+    for (int pc = 0; pc < map->length; pc++) {
+        Op op = map->code[pc].op;
+        depth += (op == OP_LOAD || op == OP_CONST) ? 1 : isBinary(op) ? -1 : 0;
+        if (depth < 1 || depth > MAP_DEPTH)
+            return -1;
+    }
+    if (depth != 1)
+        return -1;
+
+    // Result takes the largest dimensions
+    for (int k = 0; k < map->operands; k++) {
+        if (isNull(operands[k]))
+            return -1;
+        *m = (operands[k].m > *m) ? operands[k].m : *m;
+        *n = (operands[k].n > *n) ? operands[k].n : *n;
+    }
+
+    // Other dimensions must be broadcast
+    for (int k = 0; k < map->operands; k++) {
+        if ((operands[k].m != 1 && operands[k].m != *m) ||
+            (operands[k].n != 1 && operands[k].n != *n))
+            return -1;
+    }
+
+    return 0;
+}
+
+// -- Evaluation --
+static double apply(Op op, double a, double b) {
+#define CASE(op, f) \
+    case op:        \
+        return f;
+    switch (op) {
+        UNARY(CASE)
+        BINARY(CASE)
+        default:
+            return a;
+    }
+#undef CASE
+}
+
+// Apply a unary operation to a block
+CLONES static void unary(Op op, double *out, const double *x, int len) {
+#define LOOP(op, f)                     \
+    case op:                            \
+        for (int k = 0; k < len; k++) { \
+            double a = x[k];            \
+            out[k] = f;                 \
+        }                               \
+        break;
+    switch (op) {
+        UNARY(LOOP)
+        default:
+            break;
+    }
+#undef LOOP
+}
+
+// Apply a binary operation to a block, with either side possibly scalar
+CLONES static void binary(Op op, double *out, Value x, Value y, int len) {
+#define LOOP(op, f)                                \
+    case op:                                       \
+        if (!y.x) {                                \
+            double b = y.s;                        \
+            for (int k = 0; k < len; k++) {        \
+                double a = x.x[k];                 \
+                out[k] = f;                        \
+            }                                      \
+        } else if (!x.x) {                         \
+            double a = x.s;                        \
+            for (int k = 0; k < len; k++) {        \
+                double b = y.x[k];                 \
+                out[k] = f;                        \
+            }                                      \
+        } else {                                   \
+            for (int k = 0; k < len; k++) {        \
+                double a = x.x[k], b = y.x[k];     \
+                out[k] = f;                        \
+            }                                      \
+        }                                          \
+        break;
+    switch (op) {
+        BINARY(LOOP)
+        default:
+            break;
+    }
+#undef LOOP
+}
+
+// Run a map over a block of a row
+static void runBlock(const Args *args, int i, int j, int len, double scratch[][BLOCK]) {
+    const Map *map = args->map;
+    double *result = &args->C.data[i][j];
+    Value stack[MAP_DEPTH];
+    int depth = 0;
+
+    for (int pc = 0; pc < map->length; pc++) {
+        const Instr *instr = &map->code[pc];
+
+        if (instr->op == OP_LOAD) {
+            // Point into the operand, broadcasting rows and columns
+            Matrix A = args->operands[instr->operand];
+            const double *row = A.data[(A.m == 1) ? 0 : i];
+            stack[depth++] = (A.n == 1) ? (Value){NULL, row[0]} : (Value){&row[j], 0};
+            continue;
+        }
+        if (instr->op == OP_CONST) {
+            stack[depth++] = (Value){NULL, instr->value};
+            continue;
+        }
+
+        // Write the final operation into the result
+        Value *x = &stack[isBinary(instr->op) ? depth - 2 : depth - 1];
+        Value *y = isBinary(instr->op) ? &stack[depth - 1] : x;
+        double *out = (pc == map->length - 1) ? result : scratch[x - stack];
+        if (!x->x && !y->x) {
+            *x = (Value){NULL, apply(instr->op, x->s, y->s)};
+        } else {
+            if (isBinary(instr->op))
+                binary(instr->op, out, *x, *y, len);
+            else
+                unary(instr->op, out, x->x, len);
+            *x = (Value){out, 0};
+        }
+        depth = (x - stack) + 1;
+    }
+
+    // Store values not already written
+    if (!stack[0].x) {
+        for (int k = 0; k < len; k++)
+            result[k] = stack[0].s;
+    } else if (stack[0].x != result) {
+        memcpy(result, stack[0].x, len * sizeof(double));
+    }
+}
+
+static void runRows(void *arg, int begin, int end) {
+    const Args *args = arg;
+    double scratch[MAP_DEPTH][BLOCK];
+
+    // Skip remaining chunks once cancelled
+    if (isCancelled())
+        return;
+
+    for (int i = begin; i < end; i++) {
+        for (int j = 0; j < args->C.n; j += BLOCK) {
+            int len = (args->C.n - j < BLOCK) ? args->C.n - j : BLOCK;
+            runBlock(args, i, j, len, scratch);
+        }
+    }
+}
+
+Matrix evalMap(const Map *map, const Matrix operands[]) {
+    int m, n;
+
+    // Return early on invalid program or incompatible operands
+    if (mapShape(map, operands, &m, &n))
+        return NULL_MATRIX;
+
+    Args args = {map, operands, emptyMat(m, n), (GRAIN / n > 0) ? GRAIN / n : 1};
+    if (isNull(args.C))
+        return args.C;
+
+    // Count operations, as loads and constants are free
+    uint64_t ops = 0;
+    for (int pc = 0; pc < map->length; pc++)
+        ops += isUnary(map->code[pc].op) || isBinary(map->code[pc].op);
+
+    Probe probe = beginProbe();
+    parallelFor(currentPool(), m, args.grain, runRows, &args);
+    endProbe(&probe, KERNEL_MAP, ops * m * n);
+
+    // Never return a partial result
+    if (isCancelled())
+        deleteMat(&args.C);
+
+    return args.C;
+}
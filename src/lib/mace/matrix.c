@@ -5,8 +5,23 @@
 
 #include "mace/matrix.h"
 
-#include <stdio.h>
-#include <stdlib.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mace/map.h"
+#include "mace/pool.h"
+#include "mace/profile.h"
+#include "mace/reduce.h"
+#include "mace/runtime.h"
+#include "mace/small.h"
+#include "mace/sum.h"
+#include "mace/target.h"
+#include "mace/topology.h"
+
+#define FIRST_TOUCH (2 << 20) // bytes above which rows are touched in parallel
+#define GRAIN 16384           // entries per chunk, when touching or copying rows
+#define MUL_GRAIN 65536       // multiply-adds per chunk, when multiplying
 
 #define NULL_MATRIX \
     (Matrix) {      \
@@ -16,38 +31,58 @@
 // TODO: Function descriptions
 // TODO: Fix memory leaks on all functions that return a matrix
 
+// Compensated precision replaces running sums with compensated dot
+// products over contiguous rows, and cofactor expansion with pivoted
+// factorization. Fixed-size kernels are used by both.
+static int isPrecise(void) {
+    return currentPrecision() == PRECISION_COMPENSATED;
+}
+
+// Subtract a dot product from b, in the current precision
+static double residual(double b, const double *x, const double *y, int n) {
+    if (isPrecise())
+        return b - dotCompensated(x, y, n);
+
+    for (int k = 0; k < n; k++)
+        b -= x[k] * y[k];
+    return b;
+}
+
 Matrix identityMat(int n) {
     // Return NULL for invalid dimension
     if (n < 1)
         return NULL_MATRIX;
 
-    Matrix I;
-    // Initialize dimensions of matrix
-    I.m = I.n = n;
-
-    // Create data pointer
-    double **data = malloc(n * sizeof(double *));
-    // Assign rows pointed to by each column
-    for (int i = 0; i < n; i++) {
-        data[i] = malloc(n * sizeof(double));
-
-        // Set value of each element in row to zero
-        for (int j = 0; j < n; j++) {
-            if (i == j)
-                data[i][j] = 1;
-            else
-                data[i][j] = 0;
-        }
-    }
+    Matrix I = emptyMat(n, n);
+    if (isNull(I))
+        return I;
 
-    // Initialize data of matrix
-    I.data = data;
+    // Set value of each element on diagonal to one
+    for (int i = 0; i < n; i++)
+        I.data[i][i] = 1;
 
     // Return matrix
     return I;
 }
 
-Matrix emptyMat(int m, int n) {
+// Rows of large matrices are first written by the pool, split between
+// nodes as later row-parallel kernels will be, so pages are placed on the
+// node that processes them. Matrices are otherwise zeroed lazily by the
+// allocator, and touched by whichever thread writes them first.
+static void touchRows(void *arg, int begin, int end) {
+    const Matrix *A = arg;
+    for (int i = begin; i < end; i++)
+        memset(A->data[i], 0, A->n * sizeof(double));
+}
+
+static void copyRows(void *arg, int begin, int end) {
+    const Matrix *pair = arg;
+    for (int i = begin; i < end; i++)
+        memcpy(pair[1].data[i], pair[0].data[i], pair[0].n * sizeof(double));
+}
+
+// Allocate a zeroed matrix without touching its rows
+static Matrix allocMat(int m, int n) {
     // Return NULL for invalid dimensions
     if (m < 1 || n < 1)
         return NULL_MATRIX;
@@ -57,16 +92,15 @@ Matrix emptyMat(int m, int n) {
     A.m = m;
     A.n = n;
 
-    // Create data pointer
-    double **data = malloc(m * sizeof(double *));
+    // Create data pointer, with zeroed rows in the same allocation, unless
+    // over budget
+    double **data = maceTryAlloc(sizeMat(m, n));
+    if (!data)
+        return NULL_MATRIX;
+    double *rows = (double *)(data + m);
     // Assign rows pointed to by each column
-    for (int i = 0; i < m; i++) {
-        data[i] = malloc(n * sizeof(double));
-
-        // Set value of each element in row to zero
-        for (int j = 0; j < n; data[i][j++] = 0)
-            ;
-    }
+    for (int i = 0; i < m; i++)
+        data[i] = rows + (size_t)i * n;
 
     // Initialize data of matrix
     A.data = data;
@@ -75,48 +109,59 @@ Matrix emptyMat(int m, int n) {
     return A;
 }
 
+Matrix emptyMat(int m, int n) {
+    Matrix A = allocMat(m, n);
+
+    // Place pages of large matrices by first touch, on multiple nodes
+    if (!isNull(A) && sizeMat(m, n) >= FIRST_TOUCH && currentTopology()->nodes > 1 &&
+        currentPlacement() == PLACEMENT_LOCAL)
+        parallelFor(currentPool(), m, 1 + GRAIN / n, touchRows, &A);
+
+    return A;
+}
+
+size_t sizeMat(int m, int n) {
+    return m * sizeof(double *) + (size_t)m * n * sizeof(double);
+}
+
 Matrix doubleToMat(double x) {
     Matrix A = emptyMat(1, 1);
-    A.data[0][0] = x; // set value of data field to input
+    if (!isNull(A))
+        A.data[0][0] = x; // set value of data field to input
     return A;
 }
 
 Matrix copyMat(Matrix A) {
-    Matrix copyA = emptyMat(A.m, A.n);
-
-    for (int i = 0; i < A.m; i++) {
-        for (int j = 0; j < A.n; j++) {
-            copyA.data[i][j] = A.data[i][j];
-        }
-    }
+    Matrix copyA = allocMat(A.m, A.n);
+    if (isNull(copyA))
+        return copyA;
+
+    // Copy row by row, as rows may have been permuted, touching large
+    // matrices in parallel
+    Matrix pair[] = {A, copyA};
+    if (sizeMat(A.m, A.n) >= FIRST_TOUCH)
+        parallelFor(currentPool(), A.m, 1 + GRAIN / A.n, copyRows, pair);
+    else
+        copyRows(pair, 0, A.m);
 
     return copyA;
 }
 
+Matrix retainMat(Matrix A) {
+    // Share storage with the original, which must no longer be mutated
+    maceRetain(A.data);
+    return A;
+}
+
 void deleteMat(Matrix *A) {
-    // Free memory allocated by malloc
-    for (int i = 0; i < A->m; free(A->data[i++]))
-        ;
-    free(A->data);
+    // Release memory allocated by emptyMat (rows share the allocation)
+    maceFree(A->data);
 
     // Reset fields
     A->m = A->n = 0;
     A->data = NULL;
 }
 
-void printMat(Matrix A) {
-    // Iterate through rows and columns
-    for (int i = 0; i < A.m; i++) {
-        for (int j = 0; j < A.n; j++) {
-            printf("% 6.3g", A.data[i][j]);
-
-            if (j + 1 < A.n)
-                printf(" ");
-        }
-        printf("\n");
-    }
-}
-
 int isNull(Matrix A) {
     return (A.m == 0) && (A.n == 0) && (A.data == 0);
 }
@@ -126,8 +171,18 @@ int isSquare(Matrix A) {
 }
 
 // -- Unary operations --
-Matrix transpose(Matrix A) {
+CLONES static Matrix transposeKernel(Matrix A) {
     Matrix transpA = emptyMat(A.n, A.m);
+    if (isNull(transpA))
+        return transpA;
+
+    // Dispatch to fixed-size kernel
+    if (isSmall(A)) {
+        Small S = toSmall(A), T;
+        trnspSmall(&S, &T);
+        fromSmall(&T, transpA);
+        return transpA;
+    }
 
     for (int i = 0; i < A.m; i++) {
         for (int j = 0; j < A.n; j++) {
@@ -139,37 +194,32 @@ Matrix transpose(Matrix A) {
 }
 
 Matrix inverse(Matrix A) {
-    double detA = determinant(A); // calculate determinant of matrix
-
-    // Return early on non-invertible matricies
-    if (!detA)
-        return NULL_MATRIX;
-
-    // Calculate cofactor matrix
-    Matrix cofactorA = copyMat(A);
-    for (int i = 0; i < A.m; i++) {
-        for (int j = 0; j < A.n; j++) {
-            int sign = ((i + j) % 2) ? -1 : 1; // determine sign of term
-            Matrix minorA = minor(A, i, j);    // create minor at index
-
-            // Add determinant of minor to total
-            cofactorA.data[i][j] = sign * determinant(minorA);
-
-            deleteMat(&minorA); // delete minor
-        }
+    // Dispatch to fixed-size kernel
+    if (isSmall(A) && isSquare(A)) {
+        Small S = toSmall(A), I;
+        if (!invSmall(&S, &I))
+            return NULL_MATRIX;
+
+        Matrix inverseA = emptyMat(A.m, A.n);
+        if (!isNull(inverseA))
+            fromSmall(&I, inverseA);
+        return inverseA;
     }
 
-    // Calculate adjugate matrix
-    Matrix adjugateA = transpose(cofactorA);
-
-    // Calculate inverse matrix
-    Matrix inverseA = coeffMat((1 / detA), adjugateA);
+    // Factorize, rejecting matrices singular to working precision
+    int *perm = maceAlloc(A.m * sizeof(int)), sign;
+    if (!perm)
+        return NULL_MATRIX;
+    Matrix LU = luDecomp(A, perm, &sign);
+    Matrix inverseA = NULL_MATRIX;
+    if (!isNull(LU) && luRcond(LU, perm, normMat(A, NORM_ONE)) >= RCOND_MIN)
+        inverseA = luInverse(LU, perm);
 
     // Delete intermediate matricies
-    deleteMat(&cofactorA);
-    deleteMat(&adjugateA);
+    if (!isNull(LU))
+        deleteMat(&LU);
+    maceFree(perm);
 
-    // Return inverse matrix
     return inverseA;
 }
 
@@ -183,6 +233,8 @@ Matrix minor(Matrix A, int row, int col) {
         return doubleToMat(1);
 
     Matrix minorA = emptyMat(A.m - 1, A.n - 1);
+    if (isNull(minorA))
+        return minorA;
 
     // Copy data to minor
     for (int i = 0; i < minorA.m; i++) {
@@ -196,44 +248,463 @@ Matrix minor(Matrix A, int row, int col) {
     return minorA;
 }
 
-// -- Binary operations --
-Matrix coeffMat(double coeff, Matrix A) {
-    Matrix coeffA = copyMat(A);
+// -- Factorizations --
+// Crout's ordering computes each factor entry as a single dot product, so
+// it is accumulated once with compensation rather than updated k times.
+// Columns of U are mirrored in a transposed buffer to keep them contiguous.
+CLONES static Matrix luCrout(Matrix LU, int perm[], int *sign) {
+    int n = LU.m;
+    double *cols = maceTryAlloc((size_t)n * n * sizeof(double));
+    if (!cols) {
+        deleteMat(&LU);
+        return NULL_MATRIX;
+    }
+
+    for (int k = 0; k < n; k++) {
+        // Stop at cancellation point
+        if (isCancelled()) {
+            maceFree(cols);
+            deleteMat(&LU);
+            return NULL_MATRIX;
+        }
+
+        // Complete column k of the remaining rows
+        double *colK = &cols[(size_t)k * n];
+        for (int i = k; i < n; i++)
+            LU.data[i][k] = residual(LU.data[i][k], LU.data[i], colK, k);
+
+        // Partial pivoting: select largest magnitude in column
+        int pivot = k;
+        for (int i = k + 1; i < n; i++) {
+            if (fabs(LU.data[i][k]) > fabs(LU.data[pivot][k]))
+                pivot = i;
+        }
+
+        // Swap rows by exchanging row pointers
+        if (pivot != k) {
+            double *row = LU.data[k];
+            LU.data[k] = LU.data[pivot];
+            LU.data[pivot] = row;
+
+            int index = perm[k];
+            perm[k] = perm[pivot];
+            perm[pivot] = index;
+
+            *sign = -*sign;
+        }
 
-    for (int i = 0; i < coeffA.m; i++) {
-        for (int j = 0; j < coeffA.n; j++) {
-            coeffA.data[i][j] *= coeff;
+        // Complete row k of the upper triangle
+        colK[k] = LU.data[k][k];
+        for (int j = k + 1; j < n; j++) {
+            double *colJ = &cols[(size_t)j * n];
+            colJ[k] = LU.data[k][j] = residual(LU.data[k][j], LU.data[k], colJ, k);
         }
+
+        // Skip scaling on singular column
+        if (!LU.data[k][k]) {
+            *sign = 0;
+            continue;
+        }
+
+        // Scale multipliers below pivot
+        for (int i = k + 1; i < n; i++)
+            LU.data[i][k] /= LU.data[k][k];
     }
 
-    return coeffA;
+    maceFree(cols);
+    return LU; // must be freed
 }
 
-Matrix addMat(Matrix A, Matrix B) {
-    // Return early on mismatched dimensions
-    if ((A.m != B.m) || (A.n != B.n))
+CLONES static Matrix luDecompKernel(Matrix A, int perm[], int *sign) {
+    // Return early on bad dimensions
+    if (isNull(A) || !isSquare(A))
         return NULL_MATRIX;
 
-    Matrix C = emptyMat(A.m, A.n);
+    Matrix LU = copyMat(A);
+    *sign = 1;
+    if (isNull(LU))
+        return LU;
 
-    for (int i = 0; i < A.m; i++) {
-        for (int j = 0; j < A.n; j++) {
-            C.data[i][j] = A.data[i][j] + B.data[i][j];
+    // Start from the identity permutation
+    for (int i = 0; i < LU.m; i++)
+        perm[i] = i;
+
+    if (isPrecise())
+        return luCrout(LU, perm, sign);
+
+    for (int k = 0; k < LU.m; k++) {
+        // Stop at cancellation point
+        if (isCancelled()) {
+            deleteMat(&LU);
+            return NULL_MATRIX;
+        }
+
+        // Partial pivoting: select largest magnitude in column
+        int pivot = k;
+        for (int i = k + 1; i < LU.m; i++) {
+            if (fabs(LU.data[i][k]) > fabs(LU.data[pivot][k]))
+                pivot = i;
+        }
+
+        // Swap rows by exchanging row pointers
+        if (pivot != k) {
+            double *row = LU.data[k];
+            LU.data[k] = LU.data[pivot];
+            LU.data[pivot] = row;
+
+            int index = perm[k];
+            perm[k] = perm[pivot];
+            perm[pivot] = index;
+
+            *sign = -*sign;
+        }
+
+        // Skip elimination on singular column
+        if (!LU.data[k][k]) {
+            *sign = 0;
+            continue;
+        }
+
+        // Eliminate entries below pivot, storing multipliers in place
+        for (int i = k + 1; i < LU.m; i++) {
+            double factor = LU.data[i][k] /= LU.data[k][k];
+            for (int j = k + 1; j < LU.n; j++) {
+                LU.data[i][j] -= factor * LU.data[k][j];
+            }
         }
     }
 
-    return C; // must be freed
+    return LU; // must be freed
 }
 
-Matrix mulMat(Matrix A, Matrix B) {
-    // Return early on mismatched dimensions
-    if (A.n != B.m)
+// Solve A x = b from the factors of PA
+static void luSolve(Matrix LU, const int perm[], const double b[], double x[]) {
+    // Forward substitution with unit lower triangle
+    for (int i = 0; i < LU.m; i++)
+        x[i] = residual(b[perm[i]], LU.data[i], x, i);
+
+    // Back substitution with upper triangle
+    for (int i = LU.m - 1; i >= 0; i--) {
+        double sum = residual(x[i], &LU.data[i][i + 1], &x[i + 1], LU.n - i - 1);
+        x[i] = sum / LU.data[i][i];
+    }
+}
+
+// Solve A^T x = b from the factors of PA, failing without scratch space
+static int luSolveTranspose(Matrix LU, const int perm[], const double b[], double x[]) {
+    double *w = maceAlloc(LU.n * sizeof(double));
+    if (!w)
+        return -1;
+
+    // Forward substitution with transposed upper triangle
+    for (int i = 0; i < LU.n; i++) {
+        double sum = b[i];
+        for (int k = 0; k < i; k++)
+            sum -= LU.data[k][i] * w[k];
+        w[i] = sum / LU.data[i][i];
+    }
+
+    // Back substitution with transposed unit lower triangle
+    for (int i = LU.n - 1; i >= 0; i--) {
+        for (int k = i + 1; k < LU.n; k++)
+            w[i] -= LU.data[k][i] * w[k];
+    }
+
+    // Undo row permutation
+    for (int i = 0; i < LU.n; i++)
+        x[perm[i]] = w[i];
+
+    maceFree(w);
+    return 0;
+}
+
+CLONES static Matrix luInverseKernel(Matrix LU, int perm[]) {
+    Matrix inverseA = emptyMat(LU.m, LU.n);
+    if (isNull(inverseA))
+        return inverseA;
+
+    // Solve columns in contiguous buffers
+    double *e = maceAlloc(LU.n * sizeof(double));
+    double *x = maceAlloc(LU.n * sizeof(double));
+    if (!e || !x) {
+        maceFree(e);
+        maceFree(x);
+        deleteMat(&inverseA);
         return NULL_MATRIX;
+    }
+    memset(e, 0, LU.n * sizeof(double));
+
+    // Solve for each column of the inverse
+    for (int j = 0; j < LU.n; j++) {
+        // Stop at cancellation point
+        if (isCancelled()) {
+            maceFree(e);
+            maceFree(x);
+            deleteMat(&inverseA);
+            return NULL_MATRIX;
+        }
 
-    Matrix C = emptyMat(A.m, B.n);
+        e[j] = 1;
+        luSolve(LU, perm, e, x);
+        e[j] = 0;
+
+        for (int i = 0; i < LU.m; i++)
+            inverseA.data[i][j] = x[i];
+    }
+
+    maceFree(e);
+    maceFree(x);
+    return inverseA; // must be freed
+}
+
+double luDeterminant(Matrix LU, int sign) {
+    double detA = sign;
+
+    // Determinant is the signed product of the pivots
+    for (int i = 0; i < LU.m; i++)
+        detA *= LU.data[i][i];
+
+    return detA;
+}
+
+// Estimates the reciprocal of the 1-norm condition number from the factors
+// of A, given its norm. The norm of the inverse is estimated with Hager's
+// method, as refined by Higham, in O(n^2) operations per iteration.
+double luRcond(Matrix LU, int perm[], double norm) {
+    int n = LU.n;
+
+    // Return early on exactly singular factors
+    for (int i = 0; i < n; i++) {
+        if (!LU.data[i][i])
+            return 0;
+    }
+    if (!norm)
+        return 0;
+
+    double *x = maceAlloc(n * sizeof(double));
+    double *y = maceAlloc(n * sizeof(double));
+    double *z = maceAlloc(n * sizeof(double));
+    if (!x || !y || !z) {
+        maceFree(x);
+        maceFree(y);
+        maceFree(z);
+        return 0;
+    }
+
+    // Ascend the norm of A^-1 x over the unit ball, from its centre
+    double est = 0;
+    int last = -1; // previous vertex, or -1 for the centre
+    int failed = 0;
+    for (int i = 0; i < n; i++)
+        x[i] = 1.0 / n;
+    for (int iter = 0; iter < 5; iter++) {
+        luSolve(LU, perm, x, y);
+        double sum = 0;
+        for (int i = 0; i < n; i++)
+            sum += fabs(y[i]);
+
+        // Stop once the estimate no longer increases
+        if (iter && sum <= est)
+            break;
+        est = sum;
+
+        // Gradient of the norm at x
+        for (int i = 0; i < n; i++)
+            x[i] = (y[i] >= 0) ? 1 : -1;
+        if ((failed = luSolveTranspose(LU, perm, x, z)))
+            break;
+
+        // Move to the vertex of steepest ascent, unless at a local maximum
+        int j = 0;
+        for (int i = 1; i < n; i++) {
+            if (fabs(z[i]) > fabs(z[j]))
+                j = i;
+        }
+        double slope = 0; // directional derivative along x
+        if (last < 0) {
+            for (int i = 0; i < n; i++)
+                slope += z[i] / n;
+        } else {
+            slope = z[last];
+        }
+        if (iter && fabs(z[j]) <= slope)
+            break;
+
+        for (int i = 0; i < n; i++)
+            x[i] = (i == j);
+        last = j;
+    }
+
+    // Guard against stalling with an alternating test vector
+    for (int i = 0; i < n; i++)
+        x[i] = ((i % 2) ? -1 : 1) * (1 + (n > 1 ? (double)i / (n - 1) : 0));
+    luSolve(LU, perm, x, y);
+    double alt = 0;
+    for (int i = 0; i < n; i++)
+        alt += fabs(y[i]);
+    alt = 2 * alt / (3 * n);
+    if (alt > est)
+        est = alt;
+
+    maceFree(x);
+    maceFree(y);
+    maceFree(z);
+
+    // Refused scratch space leaves no estimate
+    return failed ? 0 : 1 / (norm * est);
+}
+
+// -- Updates --
+// Rank-one updates A + uv^T refresh derived quantities in O(n^2). Bennett's
+// algorithm updates the factors of PA in place, but cannot pivot, so
+// updates that cancel a pivot or let multipliers grow fail instead,
+// leaving the factors unusable.
+#define MULTIPLIER_MAX 1e3
+
+CLONES static int luUpdateKernel(Matrix LU, const int perm[], const double u[],
+                                 const double v[]) {
+    int n = LU.n, status = 0;
+    double *w = maceAlloc(n * sizeof(double));
+    double *z = maceAlloc(n * sizeof(double));
+    if (!w || !z) {
+        maceFree(w);
+        maceFree(z);
+        return -1;
+    }
+
+    // Permute u to match the rows of the factors
+    for (int i = 0; i < n; i++) {
+        w[i] = u[perm[i]];
+        z[i] = v[i];
+    }
+
+    for (int j = 0; j < n && !status; j++) {
+        // Update pivot, failing on cancellation
+        double pivot = LU.data[j][j] + w[j] * z[j];
+        if (!(fabs(pivot) > DBL_EPSILON * (fabs(LU.data[j][j]) + fabs(w[j] * z[j])))) {
+            status = -1;
+            break;
+        }
+        double a = z[j] / pivot;
+        LU.data[j][j] = pivot;
+
+        // Update row j of the upper triangle, leaving the remaining update
+        for (int k = j + 1; k < n; k++) {
+            LU.data[j][k] += w[j] * z[k];
+            z[k] -= a * LU.data[j][k];
+        }
+
+        // Update multipliers below pivot
+        for (int i = j + 1; i < n; i++) {
+            w[i] -= w[j] * LU.data[i][j];
+            LU.data[i][j] += a * w[i];
+            if (fabs(LU.data[i][j]) > MULTIPLIER_MAX)
+                status = -1;
+        }
+    }
+
+    maceFree(w);
+    maceFree(z);
+    return status;
+}
+
+// Sherman-Morrison: (A + uv^T)^-1 = B - (Bu)(v^T B) / (1 + v^T Bu), where
+// B = A^-1. The denominator is the ratio of the updated determinant to the
+// original, and updates that leave the matrix singular fail.
+CLONES static int inverseUpdateKernel(Matrix B, const double u[], const double v[],
+                                      double *ratio) {
+    int n = B.n;
+    double *y = maceAlloc(n * sizeof(double));
+    double *x = maceAlloc(n * sizeof(double));
+    int *nonzero = maceAlloc(n * sizeof(int));
+    if (!y || !x || !nonzero) {
+        maceFree(y);
+        maceFree(x);
+        maceFree(nonzero);
+        return -1;
+    }
+
+    // Skip zero entries of u, which is often a unit vector
+    int count = 0;
+    for (int k = 0; k < n; k++) {
+        if (u[k])
+            nonzero[count++] = k;
+    }
+    for (int i = 0; i < n; i++) {
+        for (int c = 0; c < count; c++)
+            y[i] += B.data[i][nonzero[c]] * u[nonzero[c]];
+    }
+
+    // Accumulate rows of B weighted by v
+    double s = 1;
+    for (int k = 0; k < n; k++) {
+        if (!v[k])
+            continue;
+        for (int j = 0; j < n; j++)
+            x[j] += v[k] * B.data[k][j];
+        s += v[k] * y[k];
+    }
+    *ratio = s;
+
+    // Fail on cancellation of the denominator
+    int status = (fabs(s) > DBL_EPSILON * fabs(s - 1)) ? 0 : -1;
+    for (int i = 0; i < n && !status; i++) {
+        double c = y[i] / s;
+        for (int j = 0; c && j < n; j++)
+            B.data[i][j] -= c * x[j];
+    }
+
+    maceFree(y);
+    maceFree(x);
+    maceFree(nonzero);
+    return status;
+}
+
+// -- Binary operations --
+static Matrix coeffMatKernel(double coeff, Matrix A) {
+    Map map = {};
+    mapLoad(&map, 0);
+    mapConst(&map, coeff);
+    mapOp(&map, OP_MUL);
+
+    return evalMap(&map, &A);
+}
+
+static Matrix addMatKernel(Matrix A, Matrix B) {
+    // Return early on mismatched dimensions, which maps would broadcast
+    if ((A.m != B.m) || (A.n != B.n))
+        return NULL_MATRIX;
+
+    Map map = {};
+    mapLoad(&map, 0);
+    mapLoad(&map, 1);
+    mapOp(&map, OP_ADD);
+
+    return evalMap(&map, (Matrix[]){A, B}); // must be freed
+}
+
+// Declare product structure, shared by the rows of a multiplication
+typedef struct product {
+    Matrix A, B, C;
+    Matrix transpB; // contiguous columns, when compensated
+} Product;
+
+CLONES static void mulRows(void *arg, int begin, int end) {
+    const Product *p = arg;
+    Matrix A = p->A, B = p->B, C = p->C;
+
+    // Skip remaining chunks once cancelled
+    if (isCancelled())
+        return;
+
+    for (int row = begin; row < end; row++) {
+        // Take dot products against contiguous columns
+        if (!isNull(p->transpB)) {
+            for (int col = 0; col < B.n; col++)
+                C.data[row][col] = dotCompensated(A.data[row], p->transpB.data[col], A.n);
+            continue;
+        }
 
-    // Iterate through rows and cols of new matrix
-    for (int row = 0; row < A.m; row++) {
         for (int col = 0; col < B.n; col++) {
             // Calculate product
             for (int i = 0; i < A.n; i++) {
@@ -241,6 +712,39 @@ Matrix mulMat(Matrix A, Matrix B) {
             }
         }
     }
+}
+
+static Matrix mulMatKernel(Matrix A, Matrix B) {
+    // Return early on mismatched dimensions
+    if (A.n != B.m)
+        return NULL_MATRIX;
+
+    Matrix C = emptyMat(A.m, B.n);
+    if (isNull(C))
+        return C;
+
+    // Dispatch to fixed-size kernel
+    if (isSmall(A) && isSquare(A) && isSquare(B)) {
+        Small S = toSmall(A), T = toSmall(B), U;
+        mulSmall(&S, &T, &U);
+        fromSmall(&U, C);
+        return C;
+    }
+
+    // Split rows of new matrix across the pool, as they were placed
+    Product p = {A, B, C, isPrecise() ? transpose(B) : NULL_MATRIX};
+    if (isPrecise() && isNull(p.transpB)) {
+        deleteMat(&C);
+        return C;
+    }
+    int grain = 1 + MUL_GRAIN / ((long long)A.n * B.n);
+    parallelFor(currentPool(), A.m, grain, mulRows, &p);
+    if (!isNull(p.transpB))
+        deleteMat(&p.transpB);
+
+    // Never return a partial result
+    if (isCancelled())
+        deleteMat(&C);
 
     return C; // must be freed
 }
@@ -251,18 +755,31 @@ double determinant(Matrix A) {
     if (!isSquare(A))
         return 0;
 
-    // Base cases (1x1 or 2x2)
-    if (A.m == 1) { // Determinant of 1x1 is itself
-        return A.data[0][0];
-    } else if (A.m == 2) { // Determinant of 2x2 is "ad - bc"
-        return (A.data[0][0] * A.data[1][1]) - (A.data[0][1] * A.data[1][0]);
+    // Base cases (up to 4x4)
+    if (isSmall(A)) {
+        Small S = toSmall(A);
+        return detSmall(&S);
     }
 
-    // Recursive case (nxn, n > 2)
+    // Product of pivots
+    if (isPrecise()) {
+        int *perm = maceAlloc(A.m * sizeof(int)), sign;
+        if (!perm)
+            return 0;
+        Matrix LU = luDecomp(A, perm, &sign);
+        double detA = isNull(LU) ? 0 : luDeterminant(LU, sign);
+
+        if (!isNull(LU))
+            deleteMat(&LU);
+        maceFree(perm);
+        return detA;
+    }
+
+    // Recursive case (nxn, n > 4)
     double detA = 0;
 
     // Uses first row for determinant
-    for (int i = 0; i < A.n; i++) {
+    for (int i = 0; i < A.n && !isCancelled(); i++) {
         int sign = (i % 2) ? -1 : 1;    // determine sign of term
         Matrix minorA = minor(A, 0, i); // create minor at index
 
@@ -275,11 +792,24 @@ double determinant(Matrix A) {
     return detA;
 }
 
-double trace(Matrix A) {
+static double traceKernel(Matrix A) {
     // Return early on bad dimensions
     if (!isSquare(A))
         return 0;
 
+    // Gather diagonal for compensated sum
+    if (isPrecise()) {
+        double *diag = maceAlloc(A.m * sizeof(double));
+        if (!diag)
+            return 0;
+        for (int i = 0; i < A.m; i++)
+            diag[i] = A.data[i][i];
+
+        double traceA = sumCompensated(diag, A.m);
+        maceFree(diag);
+        return traceA;
+    }
+
     double traceA = 0;
 
     for (int i = 0; i < A.m; i++)
@@ -287,3 +817,69 @@ double trace(Matrix A) {
 
     return traceA;
 }
+
+// -- Profiled kernels --
+// Kernels record counters around their implementations, counting
+// floating-point operations from their dimensions.
+Matrix transpose(Matrix A) {
+    Probe probe = beginProbe();
+    Matrix transpA = transposeKernel(A);
+    endProbe(&probe, KERNEL_TRNSP, 0);
+    return transpA;
+}
+
+Matrix luDecomp(Matrix A, int perm[], int *sign) {
+    Probe probe = beginProbe();
+    Matrix LU = luDecompKernel(A, perm, sign);
+    endProbe(&probe, KERNEL_LU, 2 * (uint64_t)A.m * A.m * A.m / 3);
+    return LU;
+}
+
+Matrix luInverse(Matrix LU, int perm[]) {
+    Probe probe = beginProbe();
+    Matrix inverseA = luInverseKernel(LU, perm);
+    endProbe(&probe, KERNEL_LUINV, 2 * (uint64_t)LU.m * LU.m * LU.m);
+    return inverseA;
+}
+
+int luUpdate(Matrix LU, const int perm[], const double u[], const double v[]) {
+    Probe probe = beginProbe();
+    int status = luUpdateKernel(LU, perm, u, v);
+    endProbe(&probe, KERNEL_UPDATE, 2 * (uint64_t)LU.n * LU.n);
+    return status;
+}
+
+int inverseUpdate(Matrix B, const double u[], const double v[], double *ratio) {
+    Probe probe = beginProbe();
+    int status = inverseUpdateKernel(B, u, v, ratio);
+    endProbe(&probe, KERNEL_UPDATE, 2 * (uint64_t)B.n * B.n);
+    return status;
+}
+
+Matrix coeffMat(double coeff, Matrix A) {
+    Probe probe = beginProbe();
+    Matrix coeffA = coeffMatKernel(coeff, A);
+    endProbe(&probe, KERNEL_SCL, (uint64_t)A.m * A.n);
+    return coeffA;
+}
+
+Matrix addMat(Matrix A, Matrix B) {
+    Probe probe = beginProbe();
+    Matrix C = addMatKernel(A, B);
+    endProbe(&probe, KERNEL_ADD, (uint64_t)A.m * A.n);
+    return C;
+}
+
+Matrix mulMat(Matrix A, Matrix B) {
+    Probe probe = beginProbe();
+    Matrix C = mulMatKernel(A, B);
+    endProbe(&probe, KERNEL_MUL, 2 * (uint64_t)A.m * A.n * B.n);
+    return C;
+}
+
+double trace(Matrix A) {
+    Probe probe = beginProbe();
+    double traceA = traceKernel(A);
+    endProbe(&probe, KERNEL_TRC, A.m);
+    return traceA;
+}
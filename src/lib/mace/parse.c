@@ -0,0 +1,382 @@
+// File:        parse.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "mace/parse.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mace/pool.h"
+#include "mace/runtime.h"
+
+// Text is split into rows at semicolons and newlines, found with memchr,
+// which scans many bytes at a time. Blank rows are dropped, and entries
+// within a row are separated by spaces, tabs or commas. Rows are then
+// converted in parallel, straight into the matrix, in chunks of about GRAIN
+// bytes. Numbers of at most 53 bits with a small decimal exponent are exact
+// in a double, so a single multiplication or division by an exact power of
+// ten rounds them correctly. Others of at most 19 digits are multiplied by a
+// 128 bit approximation of their power of ten (the Eisel-Lemire algorithm),
+// which rounds correctly unless the product is too close to a tie. The few
+// left are converted with strtod.
+
+#define GRAIN 65536    // bytes of text per chunk
+#define FAST_DIGITS 19 // significant digits which fit in 64 bits
+#define FAST_MANTISSA (1ULL << 53)
+#define FAST_EXPONENT 22 // largest power of ten exact in a double
+#define TOKEN_SIZE 64    // bytes of tokens copied on the stack
+#define POWER_MIN -342   // powers of ten approximated in 128 bits
+#define POWER_MAX 308
+#define LIMBS 32 // 32 bit limbs of numbers used to find approximations
+
+static const double powers[FAST_EXPONENT + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Powers of ten truncated to their leading 128 bits, high half first
+static uint64_t mantissas[POWER_MAX - POWER_MIN + 1][2];
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+// Declare row span structure
+typedef struct span {
+    const char *begin, *end;
+} Span;
+
+// Declare row arguments structure
+typedef struct rows {
+    const Span *spans;
+    Matrix A;
+    atomic_int failed;
+} Rows;
+
+static int isSeparator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == ',';
+}
+
+static const char *skip(const char *p, const char *end) {
+    while (p < end && isSeparator(*p))
+        p++;
+    return p;
+}
+
+static const char *find(const char *p, const char *end, char c) {
+    const char *q = memchr(p, c, end - p);
+    return q ? q : end;
+}
+
+// -- Powers of ten --
+// Keep the leading 128 bits of a number
+static void truncateLimbs(const uint32_t x[], uint64_t out[2]) {
+    int top = LIMBS * 32 - 1;
+    while (!(x[top / 32] >> (top % 32) & 1))
+        top--;
+
+    out[0] = out[1] = 0;
+    for (int b = top; b > top - 128; b--) {
+        uint64_t bit = (b >= 0) ? x[b / 32] >> (b % 32) & 1 : 0;
+        out[0] = out[0] << 1 | out[1] >> 63;
+        out[1] = out[1] << 1 | bit;
+    }
+}
+
+static void createPowers(void) {
+    // Multiply up from 1 to find 5^q
+    uint32_t x[LIMBS] = {1};
+    for (int q = 0; q <= POWER_MAX; q++) {
+        truncateLimbs(x, mantissas[q - POWER_MIN]);
+        uint64_t carry = 0;
+        for (int k = 0; k < LIMBS; k++) {
+            carry += (uint64_t)x[k] * 5;
+            x[k] = carry;
+            carry >>= 32;
+        }
+    }
+
+    // Divide down from 2^1023 to find 2^1023 / 5^-q, where truncating each
+    // quotient in turn truncates the last
+    memset(x, 0, sizeof(x));
+    x[LIMBS - 1] = 1u << 31;
+    for (int q = -1; q >= POWER_MIN; q--) {
+        uint64_t rem = 0;
+        for (int k = LIMBS - 1; k >= 0; k--) {
+            rem = rem << 32 | x[k];
+            x[k] = rem / 5;
+            rem %= 5;
+        }
+        truncateLimbs(x, mantissas[q - POWER_MIN]);
+    }
+}
+
+// -- Numbers --
+// Convert a nonzero mantissa scaled by a power of ten, or fail when its
+// rounding cannot be decided
+static int eiselLemire(uint64_t mantissa, int exponent, int negative, double *x) {
+    if (exponent < POWER_MIN || exponent > POWER_MAX)
+        return -1;
+    pthread_once(&once, createPowers);
+
+    // Normalize mantissa, estimating the biased binary exponent
+    int clz = __builtin_clzll(mantissa);
+    mantissa <<= clz;
+    int64_t exp2 = ((217706 * (int64_t)exponent) >> 16) + 64 + 1023 - clz;
+
+    // Multiply by the high half of the power
+    const uint64_t *power = mantissas[exponent - POWER_MIN];
+    unsigned __int128 product = (unsigned __int128)mantissa * power[0];
+    uint64_t hi = product >> 64, lo = product;
+
+    // Add the low half when the truncated bits could carry
+    if ((hi & 0x1ff) == 0x1ff && lo + mantissa < mantissa) {
+        unsigned __int128 wide = (unsigned __int128)mantissa * power[1];
+        uint64_t carry = wide >> 64, rest = wide;
+        uint64_t wideHi = hi, wideLo = lo + carry;
+        wideHi += wideLo < lo;
+        if ((wideHi & 0x1ff) == 0x1ff && wideLo + 1 == 0 && rest + mantissa < mantissa)
+            return -1;
+        hi = wideHi;
+        lo = wideLo;
+    }
+
+    // Shift to 54 bits, failing on possible ties
+    uint64_t msb = hi >> 63;
+    uint64_t bits = hi >> (msb + 9);
+    exp2 -= 1 ^ msb;
+    if (!lo && !(hi & 0x1ff) && (bits & 3) == 1)
+        return -1;
+
+    // Round to 53 bits, leaving subnormal and infinite results to strtod
+    bits += bits & 1;
+    bits >>= 1;
+    if (bits >> 53) {
+        bits >>= 1;
+        exp2++;
+    }
+    if (exp2 <= 0 || exp2 >= 0x7ff)
+        return -1;
+
+    bits = (uint64_t)negative << 63 | (uint64_t)exp2 << 52 | (bits & ((1ULL << 52) - 1));
+    memcpy(x, &bits, sizeof(*x));
+    return 0;
+}
+
+// Convert a token with strtod, which must consume all of it
+static int slowNumber(const char *p, const char *end, double *x) {
+    size_t len = end - p;
+    char buf[TOKEN_SIZE];
+    char *token = (len < TOKEN_SIZE) ? buf : maceAlloc(len + 1);
+    if (!token)
+        return -1;
+    memcpy(token, p, len);
+    token[len] = '\0';
+
+    char *stop;
+    *x = strtod(token, &stop);
+    int status = (stop == token + len) ? 0 : -1;
+
+    if (token != buf)
+        maceFree(token);
+    return status;
+}
+
+static int parseNumber(const char *p, const char *end, double *x) {
+    const char *begin = p;
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    // Accumulate significant digits, and the exponent of the last
+    uint64_t mantissa = 0;
+    int digits = 0, any = 0, exponent = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, any = 1) {
+        digits += mantissa || *p != '0';
+        mantissa = mantissa * 10 + (*p - '0');
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, any = 1) {
+            digits += mantissa || *p != '0';
+            mantissa = mantissa * 10 + (*p - '0');
+            exponent--;
+        }
+    }
+    if (any && p < end && (*p == 'e' || *p == 'E')) {
+        const char *mark = p++;
+        int sign = 1, scale = 0;
+        if (p < end && (*p == '-' || *p == '+'))
+            sign = (*p++ == '-') ? -1 : 1;
+        if (p == end || *p < '0' || *p > '9')
+            p = mark; // leave malformed exponents to strtod
+        for (; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (scale < 10000)
+                scale = scale * 10 + (*p - '0');
+        }
+        exponent += sign * scale;
+    }
+
+    // Convert exactly representable numbers directly
+    if (any && p == end && digits <= FAST_DIGITS) {
+        if (!mantissa) {
+            *x = negative ? -0.0 : 0.0;
+            return 0;
+        }
+        if (mantissa <= FAST_MANTISSA && exponent >= -FAST_EXPONENT &&
+            exponent <= FAST_EXPONENT) {
+            double value = mantissa;
+            value = (exponent < 0) ? value / powers[-exponent] : value * powers[exponent];
+            *x = negative ? -value : value;
+            return 0;
+        }
+        if (!eiselLemire(mantissa, exponent, negative, x))
+            return 0;
+    }
+
+    return slowNumber(begin, end, x);
+}
+
+// -- Rows --
+// Convert a row into exactly n entries
+static int parseRow(Span span, double row[], int n) {
+    int count = 0;
+    for (const char *p = skip(span.begin, span.end); p < span.end;
+         p = skip(p, span.end)) {
+        const char *token = p;
+        while (p < span.end && !isSeparator(*p))
+            p++;
+        if (count == n || parseNumber(token, p, &row[count++]))
+            return -1;
+    }
+
+    return (count == n) ? 0 : -1;
+}
+
+static int countEntries(Span span) {
+    int count = 0;
+    for (const char *p = skip(span.begin, span.end); p < span.end;
+         p = skip(p, span.end)) {
+        while (p < span.end && !isSeparator(*p))
+            p++;
+        count++;
+    }
+
+    return count;
+}
+
+static void parseRows(void *arg, int begin, int end) {
+    Rows *args = arg;
+
+    // Skip remaining chunks once cancelled or failed
+    if (isCancelled() || atomic_load(&args->failed))
+        return;
+
+    for (int i = begin; i < end; i++) {
+        if (parseRow(args->spans[i], args->A.data[i], args->A.n)) {
+            atomic_store(&args->failed, 1);
+            return;
+        }
+    }
+}
+
+// Find the bounds of every non-blank row, or return NULL if out of memory
+static Span *findRows(const char *text, size_t len, int *rows) {
+    const char *p = text, *end = text + len;
+    const char *semi = find(p, end, ';'), *line = find(p, end, '\n');
+    Span *spans = NULL;
+    int capacity = 0;
+
+    for (*rows = 0; *rows < INT32_MAX;) {
+        const char *stop = (semi < line) ? semi : line;
+        if (skip(p, stop) < stop) {
+            if (*rows == capacity) {
+                capacity = capacity ? 2 * capacity : 64;
+                Span *grown = maceTryAlloc(capacity * sizeof(Span));
+                if (!grown) {
+                    maceFree(spans);
+                    *rows = 0;
+                    return NULL;
+                }
+                if (spans)
+                    memcpy(grown, spans, *rows * sizeof(Span));
+                maceFree(spans);
+                spans = grown;
+            }
+            spans[(*rows)++] = (Span){p, stop};
+        }
+        if (stop == end)
+            break;
+
+        // Find the next of whichever delimiter ended the row
+        p = stop + 1;
+        if (semi < p)
+            semi = find(p, end, ';');
+        if (line < p)
+            line = find(p, end, '\n');
+    }
+
+    return spans;
+}
+
+// -- Matrices --
+Matrix parseMat(const char *text, size_t len) {
+    int rows;
+    Span *spans = findRows(text, len, &rows);
+    int cols = rows ? countEntries(spans[0]) : 0;
+
+    // Return NULL on empty data, or if rows could not be found
+    Matrix A = emptyMat(rows, cols);
+    if (isNull(A)) {
+        maceFree(spans);
+        return A;
+    }
+
+    // Convert rows in chunks of similar length
+    Rows args = {.spans = spans, .A = A};
+    atomic_init(&args.failed, 0);
+    size_t width = len / rows + 1;
+    int grain = (width < GRAIN) ? GRAIN / width : 1;
+    parallelFor(currentPool(), rows, grain, parseRows, &args);
+
+    // Never return a partial result
+    if (atomic_load(&args.failed) || isCancelled())
+        deleteMat(&A);
+
+    maceFree(spans);
+    return A;
+}
+
+int loadMat(const char *path, Matrix *A) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    // Map the whole file, parsing it in place
+    struct stat info;
+    if (fstat(fd, &info)) {
+        close(fd);
+        return -1;
+    }
+    *A = NULL_MATRIX;
+    if (!info.st_size) {
+        close(fd);
+        return 0;
+    }
+    void *addr = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return -1;
+
+    posix_madvise(addr, info.st_size, POSIX_MADV_SEQUENTIAL);
+    *A = parseMat(addr, info.st_size);
+    munmap(addr, info.st_size);
+    return 0;
+}
@@ -0,0 +1,264 @@
+// File:        pool.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "mace/pool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "mace/runtime.h"
+#include "mace/topology.h"
+
+// Workers are bound to NUMA nodes in contiguous blocks. Parallel ranges are
+// split into one contiguous part per node, in proportion to its length, so
+// a range of the same length is always split the same way. Threads claim
+// chunks from the part of their own node first, then take from the others
+// once it is exhausted. Matrices initialized by a parallel range are thus
+// first touched, and so placed, on the nodes that later process them.
+
+// Declare task structure
+typedef struct task {
+    void (*fn)(void *);
+    void *arg;
+    struct task *next;
+} Task;
+
+// Define thread pool structure
+struct pool {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    Task *head, *tail; // pending tasks
+    int size, stop;
+    pthread_t *threads;
+};
+
+// Declare worker structure, passed to each thread on creation
+typedef struct worker {
+    Pool *pool;
+    int node;
+} Worker;
+
+// Declare node part structure, on its own cache line
+typedef struct part {
+    _Alignas(64) atomic_int next; // first unclaimed index
+    int end;
+} Part;
+
+// Declare parallel range structure
+typedef struct range {
+    void (*fn)(void *, int, int);
+    void *arg;
+    const Runtime *runtime; // runtime of the caller
+    int n, grain, nodes;
+    atomic_int done; // number of completed indices
+    atomic_int refs; // caller and pending helpers
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+    Part parts[]; // one per node
+} Range;
+
+static void *worker(void *arg) {
+    Worker *self = arg;
+    Pool *pool = self->pool;
+    bindNode(self->node);
+    free(self);
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        // Wait for work or shutdown
+        while (!pool->head && !pool->stop)
+            pthread_cond_wait(&pool->ready, &pool->lock);
+        if (!pool->head)
+            break;
+
+        // Dequeue task
+        Task *task = pool->head;
+        pool->head = task->next;
+        if (!pool->head)
+            pool->tail = NULL;
+
+        // Run task unlocked
+        pthread_mutex_unlock(&pool->lock);
+        task->fn(task->arg);
+        free(task);
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+Pool *newPool(int size) {
+    // Default to one thread per processor, simulated or online
+    const Topology *topology = currentTopology();
+    if (size < 1)
+        size = topology->simulated ? topology->cpus : sysconf(_SC_NPROCESSORS_ONLN);
+    if (size < 1)
+        size = 1;
+
+    Pool *pool = calloc(1, sizeof(Pool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->ready, NULL);
+    pool->threads = malloc(size * sizeof(pthread_t));
+
+    // Spawn workers
+    for (int i = 0; i < size; i++) {
+        Worker *self = malloc(sizeof(Worker));
+        *self = (Worker){pool, workerNode(i, size)};
+        if (pthread_create(&pool->threads[i], NULL, worker, self)) {
+            free(self);
+            break;
+        }
+        pool->size++;
+    }
+
+    return pool;
+}
+
+void deletePool(Pool *pool) {
+    if (!pool)
+        return;
+
+    // Drain pending tasks, then stop workers
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->size; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->ready);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+static Pool *shared;
+
+static void initShared(void) {
+    shared = newPool(0);
+}
+
+Pool *defaultPool(void) {
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+    // Lazily create shared pool
+    pthread_once(&once, initShared);
+
+    return shared;
+}
+
+int poolSize(Pool *pool) {
+    return pool ? pool->size : 1;
+}
+
+// -- Scheduling --
+void poolSubmit(Pool *pool, void (*fn)(void *), void *arg) {
+    Task *task = malloc(sizeof(Task));
+    *task = (Task){fn, arg, NULL};
+
+    // Enqueue task
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail)
+        pool->tail->next = task;
+    else
+        pool->head = task;
+    pool->tail = task;
+    pthread_cond_signal(&pool->ready);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void releaseRange(Range *range) {
+    // Last reference frees the range
+    if (atomic_fetch_sub(&range->refs, 1) == 1) {
+        pthread_cond_destroy(&range->finished);
+        pthread_mutex_destroy(&range->lock);
+        free(range);
+    }
+}
+
+static void runRange(Range *range) {
+    int home = (range->nodes > 1) ? currentNode() % range->nodes : 0;
+
+    // Claim chunks until the range is exhausted, starting at home
+    for (int k = 0; k < range->nodes; k++) {
+        Part *part = &range->parts[(home + k) % range->nodes];
+        int begin;
+        while ((begin = atomic_fetch_add(&part->next, range->grain)) < part->end) {
+            int end = (begin + range->grain < part->end) ? begin + range->grain : part->end;
+            range->fn(range->arg, begin, end);
+            if (range->nodes > 1)
+                countChunk(home, k > 0);
+
+            // Wake caller on completion of final chunk
+            if (atomic_fetch_add(&range->done, end - begin) + (end - begin) == range->n) {
+                pthread_mutex_lock(&range->lock);
+                pthread_cond_signal(&range->finished);
+                pthread_mutex_unlock(&range->lock);
+            }
+        }
+    }
+}
+
+static void helpRange(void *arg) {
+    Range *range = arg;
+
+    // Run on behalf of the caller's runtime
+    const Runtime *saved = useRuntime(range->runtime);
+    runRange(range);
+    useRuntime(saved);
+
+    releaseRange(range);
+}
+
+void parallelFor(Pool *pool, int n, int grain, void (*fn)(void *, int, int), void *arg) {
+    if (grain < 1)
+        grain = 1;
+
+    // Run inline when there is nothing to split
+    int chunks = (n + grain - 1) / grain;
+    int helpers = poolSize(pool) < chunks ? poolSize(pool) : chunks - 1;
+    if (!pool || helpers < 1) {
+        if (n > 0)
+            fn(arg, 0, n);
+        return;
+    }
+
+    // Split range between nodes
+    int nodes = currentTopology()->nodes;
+    Range *range = aligned_alloc(_Alignof(Range), sizeof(Range) + nodes * sizeof(Part));
+    range->fn = fn;
+    range->arg = arg;
+    range->runtime = currentRuntime();
+    range->n = n;
+    range->grain = grain;
+    range->nodes = nodes;
+    for (int k = 0; k < nodes; k++) {
+        atomic_init(&range->parts[k].next, (long long)n * k / nodes);
+        range->parts[k].end = (long long)n * (k + 1) / nodes;
+    }
+    atomic_init(&range->done, 0);
+    atomic_init(&range->refs, helpers + 1);
+    pthread_mutex_init(&range->lock, NULL);
+    pthread_cond_init(&range->finished, NULL);
+
+    // Helpers may start late; the caller never waits for them to start
+    for (int i = 0; i < helpers; i++)
+        poolSubmit(pool, helpRange, range);
+    runRange(range);
+
+    // Wait for chunks still running on helpers
+    pthread_mutex_lock(&range->lock);
+    while (atomic_load(&range->done) < n)
+        pthread_cond_wait(&range->finished, &range->lock);
+    pthread_mutex_unlock(&range->lock);
+
+    releaseRange(range);
+}
@@ -0,0 +1,228 @@
+// File:        profile.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _GNU_SOURCE
+
+#include "mace/profile.h"
+
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mace/runtime.h"
+
+// Hardware counters are opened as one group per thread on first use, so
+// a probe reads them all with a single system call. Threads without
+// access to counters (e.g. in virtual machines, or under a restrictive
+// perf_event_paranoid) record only time and operation counts.
+
+// Declare per-kernel fields
+enum field {
+    FIELD_CALLS,
+    FIELD_NANOSECONDS,
+    FIELD_CYCLES,
+    FIELD_INSTRUCTIONS,
+    FIELD_MISSES,
+    FIELD_REFS,
+    FIELD_FLOPS,
+    FIELD_COUNT,
+};
+
+// Hardware events, in group order
+static const uint64_t events[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_CACHE_REFERENCES,
+};
+#define EVENTS (sizeof(events) / sizeof(*events))
+
+// Define profile structure
+struct profile {
+    atomic_int enabled;
+    _Atomic uint64_t totals[KERNEL_COUNT][FIELD_COUNT];
+};
+
+// Declare counter group structure
+typedef struct group {
+    int fds[EVENTS];
+} Group;
+
+static const char *const names[] = {
+    [KERNEL_TRNSP] = "trnsp",
+    [KERNEL_ADD] = "add",
+    [KERNEL_SCL] = "scl",
+    [KERNEL_MUL] = "mul",
+    [KERNEL_LU] = "lu",
+    [KERNEL_LUINV] = "luinv",
+    [KERNEL_TRC] = "trc",
+    [KERNEL_REDUCE] = "reduce",
+    [KERNEL_MAP] = "map",
+    [KERNEL_UPDATE] = "update",
+    [KERNEL_SOLVE] = "solve",
+    [KERNEL_KRON] = "kron",
+    [KERNEL_HADAMARD] = "hadam",
+    [KERNEL_ITERATE] = "iter",
+};
+
+// -- Counters --
+static pthread_key_t key;
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static atomic_int available = -1; // unknown until a group is opened
+
+static void closeGroup(void *arg) {
+    Group *group = arg;
+    for (size_t i = 0; i < EVENTS; i++) {
+        if (group->fds[i] >= 0)
+            close(group->fds[i]);
+    }
+    free(group);
+}
+
+static void createKey(void) {
+    pthread_key_create(&key, closeGroup);
+}
+
+static int openEvent(uint64_t config, int leader) {
+    struct perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, leader, PERF_FLAG_FD_CLOEXEC);
+}
+
+// Open counters for the calling thread, or return null if unavailable
+static Group *threadGroup(void) {
+    pthread_once(&once, createKey);
+    Group *group = pthread_getspecific(key);
+
+    if (!group) {
+        group = malloc(sizeof(Group));
+        if (!group)
+            return NULL;
+
+        // Open events as one group, led by the first
+        int opened = 1;
+        for (size_t i = 0; i < EVENTS; i++) {
+            group->fds[i] = opened ? openEvent(events[i], i ? group->fds[0] : -1) : -1;
+            opened = opened && group->fds[i] >= 0;
+        }
+
+        // Use all counters or none, remembering failures rather than retrying
+        if (!opened) {
+            for (size_t i = 0; i < EVENTS; i++) {
+                if (group->fds[i] >= 0)
+                    close(group->fds[i]);
+                group->fds[i] = -1;
+            }
+        }
+        pthread_setspecific(key, group);
+        atomic_store(&available, opened);
+    }
+
+    return (group->fds[0] >= 0) ? group : NULL;
+}
+
+// Read counters for the calling thread
+static void readCounters(uint64_t values[]) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    values[0] = ts.tv_sec * 1000000000ull + ts.tv_nsec;
+
+    Group *group = threadGroup();
+    uint64_t buffer[1 + EVENTS] = {};
+    if (group && read(group->fds[0], buffer, sizeof(buffer)) < 0)
+        buffer[0] = 0;
+    for (size_t i = 0; i < EVENTS; i++)
+        values[1 + i] = (buffer[0] == EVENTS) ? buffer[1 + i] : 0;
+}
+
+int hasCounters(void) {
+    // Probe counters on the calling thread, if not yet known
+    if (atomic_load(&available) < 0)
+        threadGroup();
+    return atomic_load(&available) > 0;
+}
+
+const char *kernelName(Kernel kernel) {
+    return names[kernel];
+}
+
+// -- Profiles --
+Profile *newProfile(void) {
+    return calloc(1, sizeof(Profile));
+}
+
+void deleteProfile(Profile *profile) {
+    free(profile);
+}
+
+void enableProfile(Profile *profile, int enabled) {
+    atomic_store(&profile->enabled, enabled);
+}
+
+int isProfiling(Profile *profile) {
+    return profile && atomic_load_explicit(&profile->enabled, memory_order_relaxed);
+}
+
+void resetProfile(Profile *profile) {
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        for (int f = 0; f < FIELD_COUNT; f++)
+            atomic_store(&profile->totals[k][f], 0);
+    }
+}
+
+void readProfile(Profile *profile, Counters counters[KERNEL_COUNT]) {
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        _Atomic uint64_t *totals = profile->totals[k];
+        counters[k] = (Counters){
+            .calls = atomic_load(&totals[FIELD_CALLS]),
+            .nanoseconds = atomic_load(&totals[FIELD_NANOSECONDS]),
+            .cycles = atomic_load(&totals[FIELD_CYCLES]),
+            .instructions = atomic_load(&totals[FIELD_INSTRUCTIONS]),
+            .cacheMisses = atomic_load(&totals[FIELD_MISSES]),
+            .cacheRefs = atomic_load(&totals[FIELD_REFS]),
+            .flops = atomic_load(&totals[FIELD_FLOPS]),
+        };
+    }
+}
+
+// -- Instrumentation --
+Probe beginProbe(void) {
+    Probe probe = {};
+
+    // Return early unless the bound runtime is profiling
+    Profile *profile = currentRuntime()->profile;
+    if (!isProfiling(profile))
+        return probe;
+
+    probe.profile = profile;
+    readCounters(probe.start);
+    return probe;
+}
+
+void endProbe(Probe *probe, Kernel kernel, uint64_t flops) {
+    if (!probe->profile)
+        return;
+
+    uint64_t end[1 + EVENTS];
+    readCounters(end);
+
+    // Accumulate differences in field order
+    _Atomic uint64_t *totals = probe->profile->totals[kernel];
+    atomic_fetch_add_explicit(&totals[FIELD_CALLS], 1, memory_order_relaxed);
+    for (size_t i = 0; i < 1 + EVENTS; i++)
+        atomic_fetch_add_explicit(&totals[FIELD_NANOSECONDS + i], end[i] - probe->start[i],
+                                  memory_order_relaxed);
+    atomic_fetch_add_explicit(&totals[FIELD_FLOPS], flops, memory_order_relaxed);
+}
@@ -0,0 +1,507 @@
+// File:        reduce.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include "mace/reduce.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mace/pool.h"
+#include "mace/profile.h"
+#include "mace/runtime.h"
+#include "mace/sum.h"
+#include "mace/target.h"
+
+// Reductions scan the matrix once, whichever outputs are requested. Each
+// row is reduced in vector lanes to its statistics, which are merged into
+// running totals, and added elementwise into column accumulators when
+// columns are reduced. Rows are split across the current thread pool in
+// chunks of about GRAIN entries, each with its own accumulators, combined in
+// order once every chunk completes. Sums are compensated in compensated
+// precision.
+
+#define GRAIN 16384 // entries per chunk
+
+// Declare statistics, which also index column accumulators
+typedef enum stat {
+    STAT_SUM,
+    STAT_COMP, // rounding error of sum
+    STAT_MIN,
+    STAT_MAX,
+    STAT_ABS,     // sum of absolute values
+    STAT_SQUARES, // sum of squares of scaled entries
+    STATS,
+} Stat;
+
+// Declare statistics structure
+typedef struct stats {
+    double at[STATS];
+} Stats;
+
+// Declare chunk accumulators structure
+typedef struct partial {
+    Stats total;
+    double widest;       // largest absolute row sum
+    double *cols[STATS]; // column accumulators, where requested
+} Partial;
+
+// Declare scan structure
+typedef struct scan {
+    Matrix A;
+    unsigned cols; // bitmask of statistics accumulated by column
+    double scale;  // applied to entries before squaring
+    int precise;
+    int grain;      // rows per chunk
+    Stats *rows;    // statistics of each row, where requested
+    Partial *parts; // accumulators of each chunk
+} Scan;
+
+// Bits within lanes
+typedef int64_t Bits __attribute__((vector_size(LANES * sizeof(int64_t))));
+
+// Select lanes of x where mask is set, and of y elsewhere
+#define SELECT(mask, x, y) ((Lanes)(((Bits)(x) & (mask)) | ((Bits)(y) & ~(mask))))
+
+// Statistics of no entries
+static const Stats empty = {{[STAT_MIN] = INFINITY, [STAT_MAX] = -INFINITY}};
+
+// Statistics needed by each output, along an axis
+static const unsigned needs[REDUCTIONS] = {
+    [REDUCE_SUM] = 1 << STAT_SUM | 1 << STAT_COMP,
+    [REDUCE_MEAN] = 1 << STAT_SUM | 1 << STAT_COMP,
+    [REDUCE_MIN] = 1 << STAT_MIN,
+    [REDUCE_MAX] = 1 << STAT_MAX,
+};
+static const unsigned normNeeds[NORMS] = {
+    [NORM_ONE] = 1 << STAT_ABS,
+    [NORM_INF] = 1 << STAT_MIN | 1 << STAT_MAX,
+    [NORM_FRO] = 1 << STAT_SQUARES | 1 << STAT_MIN | 1 << STAT_MAX, // to check range
+    [NORM_MAX] = 1 << STAT_MIN | 1 << STAT_MAX,
+};
+
+static int isPrecise(void) {
+    return currentPrecision() == PRECISION_COMPENSATED;
+}
+
+// -- Kernels --
+// Reduce a row to its statistics
+CLONES static Stats rowStats(const double *x, int n, double scale, int precise) {
+    Lanes vs = {}, va = {}, vq = {}, vmin, vmax;
+    Stats s = empty;
+    int k = 0;
+
+    for (int l = 0; l < LANES; l++) {
+        vmin[l] = INFINITY;
+        vmax[l] = -INFINITY;
+    }
+    for (; k + LANES <= n; k += LANES) {
+        Lanes v;
+        memcpy(&v, &x[k], sizeof(v)); // unaligned load
+        Lanes w = v * scale;
+        vs += v;
+        va += (Lanes)((Bits)v & INT64_MAX); // clear sign
+        vq += w * w;
+        vmin = SELECT(v < vmin, v, vmin);
+        vmax = SELECT(v > vmax, v, vmax);
+    }
+    for (; k < n; k++) {
+        double w = x[k] * scale;
+        s.at[STAT_SUM] += x[k];
+        s.at[STAT_ABS] += fabs(x[k]);
+        s.at[STAT_SQUARES] += w * w;
+        if (x[k] < s.at[STAT_MIN])
+            s.at[STAT_MIN] = x[k];
+        if (x[k] > s.at[STAT_MAX])
+            s.at[STAT_MAX] = x[k];
+    }
+
+    // Combine lanes
+    for (int l = 0; l < LANES; l++) {
+        s.at[STAT_SUM] += vs[l];
+        s.at[STAT_ABS] += va[l];
+        s.at[STAT_SQUARES] += vq[l];
+        if (vmin[l] < s.at[STAT_MIN])
+            s.at[STAT_MIN] = vmin[l];
+        if (vmax[l] > s.at[STAT_MAX])
+            s.at[STAT_MAX] = vmax[l];
+    }
+
+    // Resum while the row is still cached
+    if (precise)
+        s.at[STAT_SUM] = sumCompensated(x, n);
+
+    return s;
+}
+
+// Add a row elementwise into column accumulators
+CLONES static void accumulate(double *cols[STATS], const double *x, int n, double scale,
+                              int precise) {
+    if (cols[STAT_SUM]) {
+        double *sum = cols[STAT_SUM], *comp = cols[STAT_COMP];
+        if (precise) {
+            for (int j = 0; j < n; j++)
+                ACCUMULATE(sum[j], comp[j], x[j]);
+        } else {
+            for (int j = 0; j < n; j++)
+                sum[j] += x[j];
+        }
+    }
+    if (cols[STAT_MIN]) {
+        double *min = cols[STAT_MIN];
+        for (int j = 0; j < n; j++)
+            min[j] = (x[j] < min[j]) ? x[j] : min[j];
+    }
+    if (cols[STAT_MAX]) {
+        double *max = cols[STAT_MAX];
+        for (int j = 0; j < n; j++)
+            max[j] = (x[j] > max[j]) ? x[j] : max[j];
+    }
+    if (cols[STAT_ABS]) {
+        double *abs = cols[STAT_ABS];
+        for (int j = 0; j < n; j++)
+            abs[j] += fabs(x[j]);
+    }
+    if (cols[STAT_SQUARES]) {
+        double *squares = cols[STAT_SQUARES];
+        for (int j = 0; j < n; j++)
+            squares[j] += (x[j] * scale) * (x[j] * scale);
+    }
+}
+
+// Merge statistics of disjoint entries
+static void merge(Stats *into, const Stats *s) {
+    ACCUMULATE(into->at[STAT_SUM], into->at[STAT_COMP], s->at[STAT_SUM]);
+    into->at[STAT_COMP] += s->at[STAT_COMP];
+    into->at[STAT_ABS] += s->at[STAT_ABS];
+    into->at[STAT_SQUARES] += s->at[STAT_SQUARES];
+    if (s->at[STAT_MIN] < into->at[STAT_MIN])
+        into->at[STAT_MIN] = s->at[STAT_MIN];
+    if (s->at[STAT_MAX] > into->at[STAT_MAX])
+        into->at[STAT_MAX] = s->at[STAT_MAX];
+}
+
+// Merge column accumulators of disjoint rows
+static void mergeColumns(double *into[STATS], double *const from[STATS], int n) {
+    if (into[STAT_SUM]) {
+        for (int j = 0; j < n; j++) {
+            ACCUMULATE(into[STAT_SUM][j], into[STAT_COMP][j], from[STAT_SUM][j]);
+            into[STAT_COMP][j] += from[STAT_COMP][j];
+        }
+    }
+    if (into[STAT_MIN]) {
+        for (int j = 0; j < n; j++) {
+            if (from[STAT_MIN][j] < into[STAT_MIN][j])
+                into[STAT_MIN][j] = from[STAT_MIN][j];
+        }
+    }
+    if (into[STAT_MAX]) {
+        for (int j = 0; j < n; j++) {
+            if (from[STAT_MAX][j] > into[STAT_MAX][j])
+                into[STAT_MAX][j] = from[STAT_MAX][j];
+        }
+    }
+    for (int s = STAT_ABS; s <= STAT_SQUARES; s++) {
+        for (int j = 0; into[s] && j < n; j++)
+            into[s][j] += from[s][j];
+    }
+}
+
+// -- Scanning --
+static void scanRows(void *arg, int begin, int end) {
+    Scan *scan = arg;
+    Partial *part = &scan->parts[begin / scan->grain];
+
+    // Skip remaining chunks once cancelled
+    if (isCancelled())
+        return;
+
+    for (int i = begin; i < end; i++) {
+        const double *x = scan->A.data[i];
+        Stats s = rowStats(x, scan->A.n, scan->scale, scan->precise);
+
+        if (scan->rows)
+            scan->rows[i] = s;
+        merge(&part->total, &s);
+        if (s.at[STAT_ABS] > part->widest)
+            part->widest = s.at[STAT_ABS];
+        if (scan->cols)
+            accumulate(part->cols, x, scan->A.n, scan->scale, scan->precise);
+    }
+}
+
+// Release accumulators of a scan
+static void endScan(Scan *scan) {
+    int chunks = (scan->A.m + scan->grain - 1) / scan->grain;
+    for (int c = 0; scan->parts && c < chunks; c++) {
+        for (int s = 0; s < STATS; s++)
+            maceFree(scan->parts[c].cols[s]);
+    }
+    maceFree(scan->parts);
+    maceFree(scan->rows);
+    scan->parts = NULL;
+    scan->rows = NULL;
+}
+
+// Scan a matrix, combining accumulators into those of the first chunk
+static int runScan(Scan *scan) {
+    Matrix A = scan->A;
+    int n = A.n;
+    scan->grain = (GRAIN / n > 0) ? GRAIN / n : 1;
+    int chunks = (A.m + scan->grain - 1) / scan->grain;
+
+    // Column accumulators start from statistics of no entries
+    scan->parts = maceAlloc(chunks * sizeof(Partial));
+    for (int c = 0; c < chunks; c++) {
+        Partial *part = &scan->parts[c];
+        *part = (Partial){.total = empty};
+        for (int s = 0; s < STATS; s++) {
+            if (!(scan->cols & (1u << s)))
+                continue;
+            part->cols[s] = maceAlloc(n * sizeof(double));
+            for (int j = 0; j < n; j++)
+                part->cols[s][j] = empty.at[s];
+        }
+    }
+
+    Probe probe = beginProbe();
+    parallelFor(currentPool(), A.m, scan->grain, scanRows, scan);
+
+    // Combine chunks in order
+    Partial *first = &scan->parts[0];
+    for (int c = 1; c < chunks; c++) {
+        Partial *part = &scan->parts[c];
+        merge(&first->total, &part->total);
+        if (part->widest > first->widest)
+            first->widest = part->widest;
+        mergeColumns(first->cols, part->cols, n);
+    }
+    endProbe(&probe, KERNEL_REDUCE, (uint64_t)A.m * n);
+
+    return isCancelled() ? -1 : 0;
+}
+
+// Find the statistics of a row or column, or of every entry
+static Stats vectorStats(const Scan *scan, Axis axis, int i) {
+    if (axis == AXIS_ROWS)
+        return scan->rows[i];
+    if (axis == AXIS_ALL)
+        return scan->parts[0].total;
+
+    Stats s = empty;
+    for (int k = 0; k < STATS; k++) {
+        if (scan->parts[0].cols[k])
+            s.at[k] = scan->parts[0].cols[k][i];
+    }
+    return s;
+}
+
+// Allocate a result holding count outputs
+static Matrix emptyResult(Matrix A, Axis axis, int count) {
+    if (axis == AXIS_ROWS)
+        return emptyMat(A.m, count);
+    if (axis == AXIS_COLS)
+        return emptyMat(count, A.n);
+    return emptyMat(1, count);
+}
+
+// Find output k of a row or column
+static double *slot(Matrix C, Axis axis, int i, int k) {
+    return (axis == AXIS_COLS) ? &C.data[k][i] : &C.data[i][k];
+}
+
+// Begin a scan for outputs needing the given statistics
+static Scan newScan(Matrix A, Axis axis, unsigned cols) {
+    Scan scan = {};
+    scan.A = A;
+    scan.cols = cols;
+    scan.scale = 1;
+    scan.precise = isPrecise();
+    scan.grain = 1;
+    if (axis == AXIS_ROWS)
+        scan.rows = maceAlloc(A.m * sizeof(Stats));
+
+    // Sums need their rounding error
+    if (scan.cols & (1u << STAT_SUM))
+        scan.cols |= 1u << STAT_COMP;
+
+    return scan;
+}
+
+// -- Reductions --
+static double reduction(const Stats *s, Reduction r, int length) {
+    double sum = s->at[STAT_SUM] + s->at[STAT_COMP];
+
+    switch (r) {
+        case REDUCE_SUM:
+            return sum;
+        case REDUCE_MEAN:
+            return sum / length;
+        case REDUCE_MIN:
+            return s->at[STAT_MIN];
+        default:
+            return s->at[STAT_MAX];
+    }
+}
+
+Matrix reduceMat(Matrix A, Axis axis, unsigned mask) {
+    mask &= (1u << REDUCTIONS) - 1;
+
+    // Return early on null matrix or nothing to reduce
+    if (isNull(A) || !mask)
+        return NULL_MATRIX;
+
+    unsigned cols = 0;
+    for (int r = 0; r < REDUCTIONS; r++) {
+        if (mask & (1u << r))
+            cols |= needs[r];
+    }
+    Scan scan = newScan(A, axis, (axis == AXIS_COLS) ? cols : 0);
+
+    Matrix C = NULL_MATRIX;
+    if (!runScan(&scan)) {
+        int vectors = (axis == AXIS_ROWS) ? A.m : (axis == AXIS_COLS) ? A.n : 1;
+        int length = (axis == AXIS_ROWS) ? A.n : (axis == AXIS_COLS) ? A.m : A.m * A.n;
+
+        C = emptyResult(A, axis, __builtin_popcount(mask));
+        for (int i = 0; !isNull(C) && i < vectors; i++) {
+            Stats s = vectorStats(&scan, axis, i);
+            int k = 0;
+            for (int r = 0; r < REDUCTIONS; r++) {
+                if (mask & (1u << r))
+                    *slot(C, axis, i, k++) = reduction(&s, r, length);
+            }
+        }
+    }
+    endScan(&scan);
+
+    return C;
+}
+
+// -- Norms --
+// Whether squares of entries overflow, or underflow losing precision
+static int lostRange(const Stats *s) {
+    double largest = fmax(-s->at[STAT_MIN], s->at[STAT_MAX]);
+    double squares = s->at[STAT_SQUARES];
+    if (!isfinite(largest) || largest == 0 || isnan(squares))
+        return 0;
+    return !isfinite(squares) || squares < DBL_MIN / DBL_EPSILON;
+}
+
+// Norm row or column i with a scaled sum of squares, as dnrm2 does
+static double scaledNorm(Matrix A, Axis axis, int i) {
+    int length = (axis == AXIS_ROWS) ? A.n : A.m;
+    double scale = 0, squares = 1;
+    for (int k = 0; k < length; k++) {
+        double x = fabs((axis == AXIS_ROWS) ? A.data[i][k] : A.data[k][i]);
+        if (x > scale) {
+            squares = 1 + squares * (scale / x) * (scale / x);
+            scale = x;
+        } else if (x > 0) {
+            squares += (x / scale) * (x / scale);
+        }
+    }
+    return scale * sqrt(squares);
+}
+
+// Norm row or column i as a vector, or every entry
+static double norm(const Scan *scan, const Stats *s, Axis axis, int i, Norm type) {
+    // Matrix norms sum along the other axis
+    if (axis == AXIS_ALL && type == NORM_ONE) {
+        double widest = 0;
+        const double *abs = scan->parts[0].cols[STAT_ABS];
+        for (int j = 0; j < scan->A.n; j++) {
+            if (abs[j] > widest)
+                widest = abs[j];
+        }
+        return widest;
+    }
+    if (axis == AXIS_ALL && type == NORM_INF)
+        return scan->parts[0].widest;
+
+    switch (type) {
+        case NORM_ONE:
+            return s->at[STAT_ABS];
+        case NORM_FRO:
+            // Rows and columns are rescaled alone where squares lose range
+            if (axis != AXIS_ALL && lostRange(s))
+                return scaledNorm(scan->A, axis, i);
+            return sqrt(s->at[STAT_SQUARES]) / scan->scale;
+        default:
+            return fmax(-s->at[STAT_MIN], s->at[STAT_MAX]);
+    }
+}
+
+// Choose a power of two bringing the largest entry near one
+static double rescale(const Scan *scan) {
+    const Stats *total = &scan->parts[0].total;
+    if (!lostRange(total))
+        return 1;
+
+    double largest = fmax(-total->at[STAT_MIN], total->at[STAT_MAX]);
+    int exp = -ilogb(largest);
+    return ldexp(1, (exp > DBL_MAX_EXP - 1) ? DBL_MAX_EXP - 1 : exp);
+}
+
+Matrix normsMat(Matrix A, Axis axis, unsigned mask) {
+    mask &= (1u << NORMS) - 1;
+
+    // Return early on null matrix or nothing to reduce
+    if (isNull(A) || !mask)
+        return NULL_MATRIX;
+
+    unsigned cols = 0;
+    for (int r = 0; r < NORMS; r++) {
+        if (mask & (1u << r))
+            cols |= normNeeds[r];
+    }
+    if (axis == AXIS_ALL)
+        cols = (mask & (1u << NORM_ONE)) ? 1u << STAT_ABS : 0;
+    else if (axis == AXIS_ROWS)
+        cols = 0;
+    Scan scan = newScan(A, axis, cols);
+
+    Matrix C = NULL_MATRIX;
+    int failed = runScan(&scan);
+
+    // Rescan scaled entries where the sum of every square loses range
+    int fro = mask & (1u << NORM_FRO);
+    double scale = (!failed && fro && axis == AXIS_ALL) ? rescale(&scan) : 1;
+    if (scale != 1) {
+        endScan(&scan);
+        scan = newScan(A, axis, cols);
+        scan.scale = scale;
+        failed = runScan(&scan);
+    }
+
+    if (!failed) {
+        int vectors = (axis == AXIS_ROWS) ? A.m : (axis == AXIS_COLS) ? A.n : 1;
+
+        C = emptyResult(A, axis, __builtin_popcount(mask));
+        for (int i = 0; !isNull(C) && i < vectors; i++) {
+            Stats s = vectorStats(&scan, axis, i);
+            int k = 0;
+            for (int r = 0; r < NORMS; r++) {
+                if (mask & (1u << r))
+                    *slot(C, axis, i, k++) = norm(&scan, &s, axis, i, r);
+            }
+        }
+    }
+    endScan(&scan);
+
+    return C;
+}
+
+double normMat(Matrix A, Norm type) {
+    Matrix C = normsMat(A, AXIS_ALL, 1u << type);
+
+    // Return early on null or cancelled
+    if (isNull(C))
+        return 0;
+
+    double normA = C.data[0][0];
+    deleteMat(&C);
+    return normA;
+}
@@ -0,0 +1,206 @@
+// File:        runtime.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _DEFAULT_SOURCE
+
+#include "mace/runtime.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "mace/pool.h"
+
+// Every block is prefixed with a header recording the allocator it came
+// from, so memory may be freed on any thread, whatever runtime is bound.
+// Blocks are reference counted, so snapshots may share them without
+// copying. The header keeps the 16 byte alignment of the underlying
+// allocator, and the budget the block is counted against.
+//
+// The default allocator maps blocks of a huge page or more directly,
+// aligned to the huge page size, and advises the kernel to back them with
+// huge pages, so large matrices need fewer TLB entries. Mapped pages are
+// zeroed on first touch, rather than up front.
+
+#define HUGE_PAGE (2 << 20) // bytes, the usual huge page size
+
+// Declare allocation header structure
+typedef struct header {
+    _Alignas(16) const Allocator *allocator;
+    Budget *budget;
+    size_t size;
+    atomic_size_t refs;
+} Header;
+
+static void *defaultAlloc(void *user, size_t size) {
+    (void)user;
+    if (size < HUGE_PAGE)
+        return calloc(1, size);
+
+    // Map with room to align to a huge page, then trim either side
+    size_t padded = size + HUGE_PAGE;
+    char *addr = mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+        return NULL;
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    char *start = (char *)(((uintptr_t)addr + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1));
+    char *end = (char *)(((uintptr_t)start + size + page - 1) & ~(page - 1));
+    if (start > addr)
+        munmap(addr, start - addr);
+    if (addr + padded > end)
+        munmap(end, addr + padded - end);
+
+    madvise(start, size, MADV_HUGEPAGE);
+    return start;
+}
+
+static void defaultFree(void *user, void *ptr, size_t size) {
+    (void)user;
+    if (size < HUGE_PAGE)
+        free(ptr);
+    else
+        munmap(ptr, size);
+}
+
+static const Allocator defaultAllocator = {defaultAlloc, defaultFree, NULL};
+static const Runtime defaultRuntime = {
+    &defaultAllocator, NULL, NULL, PRECISION_FAST, PLACEMENT_LOCAL, NULL, NULL,
+};
+
+// Runtime bound to the calling thread
+static _Thread_local const Runtime *bound;
+
+// Whether the calling thread was refused an allocation
+static _Thread_local int refused;
+
+const Runtime *useRuntime(const Runtime *runtime) {
+    const Runtime *previous = bound;
+    bound = runtime;
+    return previous;
+}
+
+const Runtime *currentRuntime(void) {
+    return bound ? bound : &defaultRuntime;
+}
+
+int isCancelled(void) {
+    const atomic_int *cancel = currentRuntime()->cancel;
+    return cancel && atomic_load_explicit(cancel, memory_order_relaxed);
+}
+
+Precision currentPrecision(void) {
+    return currentRuntime()->precision;
+}
+
+Placement currentPlacement(void) {
+    return currentRuntime()->placement;
+}
+
+Pool *currentPool(void) {
+    Pool *pool = currentRuntime()->pool;
+    return pool ? pool : defaultPool();
+}
+
+// -- Allocation --
+// Count a block against a budget, failing if strict and over the limit
+static int charge(Budget *budget, size_t size, int strict) {
+    if (!budget)
+        return 0;
+
+    size_t used = atomic_fetch_add(&budget->used, size) + size;
+    if (strict && budget->limit && used > budget->limit) {
+        atomic_fetch_sub(&budget->used, size);
+        return -1;
+    }
+
+    // Raise peak to match
+    size_t peak = atomic_load(&budget->peak);
+    while (used > peak && !atomic_compare_exchange_weak(&budget->peak, &peak, used))
+        ;
+    return 0;
+}
+
+static void *allocate(size_t size, int strict) {
+    const Runtime *runtime = currentRuntime();
+    const Allocator *allocator = runtime->allocator;
+    if (!allocator)
+        allocator = &defaultAllocator;
+
+    // Return early once over budget
+    size_t total = sizeof(Header) + size;
+    if (charge(runtime->budget, total, strict)) {
+        refused = 1;
+        return NULL;
+    }
+    Header *header = allocator->alloc(allocator->user, total);
+    if (!header) {
+        if (runtime->budget)
+            atomic_fetch_sub(&runtime->budget->used, total);
+        refused = 1;
+        return NULL;
+    }
+
+    // Place pages before they are first touched
+    if (total >= HUGE_PAGE)
+        placeMemory(header, total, runtime->placement);
+
+    // Record origin for maceFree
+    header->allocator = allocator;
+    header->budget = runtime->budget;
+    header->size = size;
+    atomic_init(&header->refs, 1);
+
+    return header + 1;
+}
+
+void *maceAlloc(size_t size) {
+    return allocate(size, 0);
+}
+
+void *maceTryAlloc(size_t size) {
+    return allocate(size, 1);
+}
+
+int maceRefused(void) {
+    // Report, and forget, any refusal since last asked
+    int was = refused;
+    refused = 0;
+    return was;
+}
+
+int isRefused(void) {
+    // Report any refusal since last asked, without forgetting it
+    return refused;
+}
+
+void *maceRetain(void *ptr) {
+    if (ptr)
+        atomic_fetch_add_explicit(&((Header *)ptr - 1)->refs, 1, memory_order_relaxed);
+    return ptr;
+}
+
+int maceShared(const void *ptr) {
+    // Blocks referenced elsewhere must be copied before writing
+    return ptr && atomic_load_explicit(&((const Header *)ptr - 1)->refs, memory_order_acquire) > 1;
+}
+
+size_t maceBlockSize(const void *ptr) {
+    return ptr ? ((const Header *)ptr - 1)->size : 0;
+}
+
+void maceFree(void *ptr) {
+    if (!ptr)
+        return;
+
+    // Last reference frees the block
+    Header *header = (Header *)ptr - 1;
+    if (atomic_fetch_sub_explicit(&header->refs, 1, memory_order_acq_rel) > 1)
+        return;
+    if (header->budget)
+        atomic_fetch_sub(&header->budget->used, sizeof(Header) + header->size);
+    header->allocator->free(header->allocator->user, header, sizeof(Header) + header->size);
+}
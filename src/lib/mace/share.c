@@ -0,0 +1,127 @@
+// File:        share.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "mace/share.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mace/runtime.h"
+
+#define SHARE_MAGIC 0x314d48534543414dULL // "MACESHM1"
+#define HEADER_SIZE 64                    // keeps data cache line aligned
+
+// Declare segment header structure
+typedef struct header {
+    uint64_t magic;
+    int32_t m, n;
+} Header;
+
+// Build segment name, returning nonzero on invalid names
+static int segmentName(const char *name, char path[]) {
+    size_t len = strlen(name);
+    if (len == 0 || len > SHARE_NAME_MAX)
+        return -1;
+    for (size_t i = 0; i < len; i++) {
+        if (!isalnum((unsigned char)name[i]) && !strchr("_-.", name[i]))
+            return -1;
+    }
+
+    // Namespace segments to avoid clashing with other programs
+    sprintf(path, "/mace.%s", name);
+    return 0;
+}
+
+int shareMat(Matrix A, const char *name) {
+    char path[SHARE_NAME_MAX + 8];
+    if (isNull(A) || segmentName(name, path))
+        return -1;
+
+    // Create segment, failing if name is taken
+    int fd = shm_open(path, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return -1;
+    size_t size = HEADER_SIZE + (size_t)A.m * A.n * sizeof(double);
+    void *addr = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+        addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        shm_unlink(path);
+        return -1;
+    }
+
+    // Write header, and rows in order
+    *(Header *)addr = (Header){SHARE_MAGIC, A.m, A.n};
+    double *data = (double *)((char *)addr + HEADER_SIZE);
+    for (int i = 0; i < A.m; i++)
+        memcpy(data + (size_t)i * A.n, A.data[i], A.n * sizeof(double));
+
+    munmap(addr, size);
+    return 0;
+}
+
+Matrix attachMat(const char *name, Mapping *map) {
+    char path[SHARE_NAME_MAX + 8];
+    if (segmentName(name, path))
+        return NULL_MATRIX;
+
+    // Map segment privately, so writes never reach other readers
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL_MATRIX;
+    struct stat info;
+    void *addr = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= HEADER_SIZE)
+        addr = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return NULL_MATRIX;
+
+    // Validate header against segment size
+    Header *header = addr;
+    size_t size = info.st_size;
+    if (header->magic != SHARE_MAGIC || header->m < 1 || header->n < 1 ||
+        size != HEADER_SIZE + (size_t)header->m * header->n * sizeof(double)) {
+        munmap(addr, size);
+        return NULL_MATRIX;
+    }
+
+    // Point rows into segment
+    Matrix A = {header->m, header->n, maceAlloc(header->m * sizeof(double *))};
+    if (!A.data) {
+        munmap(addr, size);
+        return NULL_MATRIX;
+    }
+    double *data = (double *)((char *)addr + HEADER_SIZE);
+    for (int i = 0; i < A.m; i++)
+        A.data[i] = data + (size_t)i * A.n;
+
+    *map = (Mapping){addr, size};
+    return A;
+}
+
+int unshareMat(const char *name) {
+    char path[SHARE_NAME_MAX + 8];
+    if (segmentName(name, path))
+        return -1;
+
+    // Existing attachments remain valid until unmapped
+    return shm_unlink(path);
+}
+
+void unmapMat(Mapping *map) {
+    if (map->addr)
+        munmap(map->addr, map->size);
+    *map = (Mapping){};
+}
@@ -0,0 +1,225 @@
+// File:        small.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include "mace/small.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "mace/matrix.h"
+
+// Kernels specialized for each dimension up to SMALL_MAX. Loops with a
+// constant trip count are fully unrolled by the compiler; determinants and
+// inverses are written out by hand to avoid any allocation.
+
+#define MUL_SMALL(N)                                                   \
+    static void mul##N(const Small *A, const Small *B, Small *C) {     \
+        for (int i = 0; i < N; i++) {                                  \
+            for (int j = 0; j < N; j++) {                              \
+                double sum = 0;                                        \
+                for (int k = 0; k < N; k++)                            \
+                    sum += A->data[i][k] * B->data[k][j];              \
+                C->data[i][j] = sum;                                   \
+            }                                                          \
+        }                                                              \
+    }
+
+MUL_SMALL(1)
+MUL_SMALL(2)
+MUL_SMALL(3)
+MUL_SMALL(4)
+
+static double det3(const double a[][SMALL_MAX]) {
+    return a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) -
+           a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+           a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+}
+
+// 2x2 sub-determinants of the top (s) and bottom (c) row pairs
+#define SUBDET4(a)                                            \
+    double s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];        \
+    double s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];        \
+    double s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];        \
+    double s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];        \
+    double s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];        \
+    double s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];        \
+    double c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];        \
+    double c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];        \
+    double c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];        \
+    double c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];        \
+    double c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];        \
+    double c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];        \
+    double det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+static double det4(const double a[][SMALL_MAX]) {
+    SUBDET4(a)
+    return det;
+}
+
+static int inv2(const double a[][SMALL_MAX], double b[][SMALL_MAX]) {
+    double det = a[0][0] * a[1][1] - a[0][1] * a[1][0];
+    if (!det)
+        return 0;
+
+    double r = 1 / det;
+    b[0][0] = a[1][1] * r;
+    b[0][1] = -a[0][1] * r;
+    b[1][0] = -a[1][0] * r;
+    b[1][1] = a[0][0] * r;
+    return 1;
+}
+
+static int inv3(const double a[][SMALL_MAX], double b[][SMALL_MAX]) {
+    double det = det3(a);
+    if (!det)
+        return 0;
+
+    double r = 1 / det;
+    b[0][0] = (a[1][1] * a[2][2] - a[1][2] * a[2][1]) * r;
+    b[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * r;
+    b[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * r;
+    b[1][0] = (a[1][2] * a[2][0] - a[1][0] * a[2][2]) * r;
+    b[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * r;
+    b[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * r;
+    b[2][0] = (a[1][0] * a[2][1] - a[1][1] * a[2][0]) * r;
+    b[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * r;
+    b[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * r;
+    return 1;
+}
+
+static int inv4(const double a[][SMALL_MAX], double b[][SMALL_MAX]) {
+    SUBDET4(a)
+    if (!det)
+        return 0;
+
+    double r = 1 / det;
+    b[0][0] = (a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * r;
+    b[0][1] = (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * r;
+    b[0][2] = (a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * r;
+    b[0][3] = (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * r;
+    b[1][0] = (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * r;
+    b[1][1] = (a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * r;
+    b[1][2] = (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * r;
+    b[1][3] = (a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * r;
+    b[2][0] = (a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * r;
+    b[2][1] = (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * r;
+    b[2][2] = (a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * r;
+    b[2][3] = (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * r;
+    b[3][0] = (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * r;
+    b[3][1] = (a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * r;
+    b[3][2] = (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * r;
+    b[3][3] = (a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * r;
+    return 1;
+}
+
+int isSmall(Matrix A) {
+    return (A.m >= 1) && (A.m <= SMALL_MAX) && (A.n >= 1) && (A.n <= SMALL_MAX);
+}
+
+Small toSmall(Matrix A) {
+    Small S;
+    S.m = A.m;
+    S.n = A.n;
+
+    // Copy rows into stack storage
+    for (int i = 0; i < A.m; i++)
+        memcpy(S.data[i], A.data[i], A.n * sizeof(double));
+
+    return S;
+}
+
+void fromSmall(const Small *S, Matrix A) {
+    // Copy rows into preallocated matrix of matching dimensions
+    for (int i = 0; i < S->m; i++)
+        memcpy(A.data[i], S->data[i], S->n * sizeof(double));
+}
+
+// -- Fixed-size kernels --
+void trnspSmall(const Small *A, Small *B) {
+    B->m = A->n;
+    B->n = A->m;
+
+    for (int i = 0; i < A->m; i++) {
+        for (int j = 0; j < A->n; j++) {
+            B->data[j][i] = A->data[i][j];
+        }
+    }
+}
+
+static double normSmall(const Small *A) {
+    double norm = 0;
+    for (int j = 0; j < A->n; j++) {
+        double sum = 0;
+        for (int i = 0; i < A->m; i++)
+            sum += fabs(A->data[i][j]);
+        norm = fmax(norm, sum);
+    }
+    return norm;
+}
+
+int invSmall(const Small *A, Small *B) {
+    B->m = A->m;
+    B->n = A->n;
+
+    // Return 0 on non-invertible matrices
+    int ok;
+    switch (A->m) {
+        case 1:
+            ok = A->data[0][0] != 0;
+            if (ok)
+                B->data[0][0] = 1 / A->data[0][0];
+            break;
+        case 2:
+            ok = inv2(A->data, B->data);
+            break;
+        case 3:
+            ok = inv3(A->data, B->data);
+            break;
+        case 4:
+            ok = inv4(A->data, B->data);
+            break;
+        default:
+            return 0;
+    }
+
+    // Reject matrices singular to working precision, as the LU path does
+    return ok && 1 / (normSmall(A) * normSmall(B)) >= RCOND_MIN;
+}
+
+void mulSmall(const Small *A, const Small *B, Small *C) {
+    C->m = A->m;
+    C->n = B->n;
+
+    // Operands are square with matching dimension
+    switch (A->m) {
+        case 1:
+            mul1(A, B, C);
+            break;
+        case 2:
+            mul2(A, B, C);
+            break;
+        case 3:
+            mul3(A, B, C);
+            break;
+        case 4:
+            mul4(A, B, C);
+            break;
+    }
+}
+
+double detSmall(const Small *A) {
+    switch (A->m) {
+        case 1: // Determinant of 1x1 is itself
+            return A->data[0][0];
+        case 2: // Determinant of 2x2 is "ad - bc"
+            return A->data[0][0] * A->data[1][1] - A->data[0][1] * A->data[1][0];
+        case 3:
+            return det3(A->data);
+        case 4:
+            return det4(A->data);
+        default:
+            return 0;
+    }
+}
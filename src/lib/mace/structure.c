@@ -0,0 +1,440 @@
+// File:        structure.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include "mace/structure.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "mace/pool.h"
+#include "mace/profile.h"
+#include "mace/runtime.h"
+#include "mace/small.h"
+#include "mace/sum.h"
+#include "mace/target.h"
+
+// Matrices are stored densely whatever their structure, so structure is
+// found by scanning each row for nonzero entries outside the band found so
+// far, which stops at once on dense rows. Kernels then skip entries outside
+// the band: products stay within the bands of both operands, and
+// factorizations within the band and its fill. Symmetric positive definite
+// matrices are factorized without pivoting, updating only their upper
+// triangle, and lower triangular matrices are their own factors.
+// Substitution skips the leading and trailing zeros of each row of the
+// factors, and of each right-hand side, so solves and inverses benefit
+// whichever way the factors were found.
+
+#define GRAIN 16384 // entries per chunk
+
+static int isPrecise(void) {
+    return currentPrecision() == PRECISION_COMPENSATED;
+}
+
+static int min(int a, int b) {
+    return (a < b) ? a : b;
+}
+
+static int max(int a, int b) {
+    return (a > b) ? a : b;
+}
+
+Structure findStructure(Matrix A) {
+    Structure s = {};
+
+    for (int i = 0; i < A.m; i++) {
+        const double *row = A.data[i];
+
+        // Widen bands to nonzero entries outside them
+        for (int j = 0; j < min(i - s.lower, A.n); j++) {
+            if (row[j]) {
+                s.lower = i - j;
+                break;
+            }
+        }
+        for (int j = A.n - 1; j > i + s.upper; j--) {
+            if (row[j]) {
+                s.upper = j - i;
+                break;
+            }
+        }
+    }
+
+    // Compare entries within the band with their reflection
+    s.symmetric = isSquare(A) && s.lower == s.upper;
+    for (int i = 0; s.symmetric && i < A.m; i++) {
+        for (int j = i + 1; j <= min(i + s.upper, A.n - 1); j++) {
+            if (A.data[i][j] != A.data[j][i]) {
+                s.symmetric = 0;
+                break;
+            }
+        }
+    }
+
+    return s;
+}
+
+int isBanded(Structure s, Matrix A) {
+    return s.lower < A.m - 1 || s.upper < A.n - 1;
+}
+
+int isTriangular(Structure s) {
+    return !s.lower || !s.upper;
+}
+
+// -- Propagation --
+Structure transposeStructure(Structure a) {
+    return (Structure){a.upper, a.lower, a.symmetric};
+}
+
+Structure inverseStructure(Structure a, Matrix A) {
+    // Inverses of triangular matrices are triangular, but otherwise dense
+    return (Structure){a.lower ? A.m - 1 : 0, a.upper ? A.n - 1 : 0, a.symmetric};
+}
+
+Structure sumStructure(Structure a, Structure b) {
+    return (Structure){max(a.lower, b.lower), max(a.upper, b.upper), a.symmetric && b.symmetric};
+}
+
+Structure productStructure(Structure a, Structure b, Matrix C) {
+    Structure s = {min(a.lower + b.lower, C.m - 1), min(a.upper + b.upper, C.n - 1)};
+
+    // Only diagonal products are known to be symmetric
+    s.symmetric = isSquare(C) && !s.lower && !s.upper;
+    return s;
+}
+
+// -- Products --
+// Declare product arguments structure
+typedef struct product {
+    Matrix A, B, C;
+    Structure a, b;
+} Product;
+
+static void mulRows(void *arg, int begin, int end) {
+    Product *p = arg;
+
+    // Stop at cancellation point
+    if (isCancelled())
+        return;
+
+    // Accumulate rows of B within the band of each row of A
+    for (int i = begin; i < end; i++) {
+        double *c = p->C.data[i];
+        for (int k = max(0, i - p->a.lower); k <= min(p->A.n - 1, i + p->a.upper); k++) {
+            double x = p->A.data[i][k];
+            if (!x)
+                continue;
+
+            const double *row = p->B.data[k];
+            for (int j = max(0, k - p->b.lower); j <= min(p->B.n - 1, k + p->b.upper); j++)
+                c[j] += x * row[j];
+        }
+    }
+}
+
+CLONES static Matrix bandMulKernel(Matrix A, Structure a, Matrix B, Structure b) {
+    Product p = {A, B, emptyMat(A.m, B.n), a, b};
+    if (isNull(p.C))
+        return p.C;
+
+    // Split rows into chunks of about GRAIN multiplications
+    uint64_t width = (uint64_t)min(a.lower + a.upper + 1, A.n) * min(b.lower + b.upper + 1, B.n);
+    int grain = 1 + GRAIN / width;
+    parallelFor(currentPool(), A.m, grain, mulRows, &p);
+
+    // Never return partial results
+    if (isCancelled())
+        deleteMat(&p.C);
+    return p.C;
+}
+
+Matrix structuredMul(Matrix A, Structure a, Matrix B, Structure b) {
+    // Return early on mismatched dimensions
+    if (A.n != B.m)
+        return NULL_MATRIX;
+
+    // Dense, small and compensated products use the general kernel
+    if ((!isBanded(a, A) && !isBanded(b, B)) || (isSmall(A) && isSmall(B)) || isPrecise())
+        return mulMat(A, B);
+
+    Probe probe = beginProbe();
+    Matrix C = bandMulKernel(A, a, B, b);
+    uint64_t width = (uint64_t)min(a.lower + a.upper + 1, A.n) * min(b.lower + b.upper + 1, B.n);
+    endProbe(&probe, KERNEL_MUL, 2 * (uint64_t)A.m * width);
+    return C;
+}
+
+// -- Factorizations --
+// Eliminate without pivoting, updating only the upper triangle, and filling
+// in multipliers from it. Fails on the first pivot which is not positive,
+// as the matrix is then not positive definite.
+static int symmetricElim(Matrix LU, int band) {
+    int n = LU.m;
+
+    for (int k = 0; k < n; k++) {
+        double pivot = LU.data[k][k];
+        if (!(pivot > 0) || isCancelled())
+            return -1;
+
+        int end = min(n - 1, k + band);
+        for (int i = k + 1; i <= end; i++) {
+            double factor = LU.data[k][i] / pivot;
+            for (int j = i; j <= end; j++)
+                LU.data[i][j] -= factor * LU.data[k][j];
+        }
+        for (int i = k + 1; i <= end; i++)
+            LU.data[i][k] = LU.data[k][i] / pivot;
+    }
+
+    return 0;
+}
+
+CLONES static Matrix bandDecompKernel(Matrix A, Structure s, int perm[], int *sign) {
+    int n = A.m;
+    Matrix LU = copyMat(A);
+    *sign = 1;
+    if (isNull(LU))
+        return LU;
+
+    // Start from the identity permutation
+    for (int i = 0; i < n; i++)
+        perm[i] = i;
+
+    // Lower triangular matrices are their own factors, once scaled
+    if (!s.upper) {
+        for (int k = 0; k < n; k++) {
+            if (!LU.data[k][k]) {
+                *sign = 0;
+                continue;
+            }
+            for (int i = k + 1; i <= min(n - 1, k + s.lower); i++)
+                LU.data[i][k] /= LU.data[k][k];
+        }
+        return LU;
+    }
+
+    // Try symmetric elimination, starting over with pivoting on failure
+    if (s.symmetric && !isPrecise()) {
+        if (!symmetricElim(LU, s.upper))
+            return LU;
+        deleteMat(&LU);
+        LU = copyMat(A);
+        if (isNull(LU))
+            return LU;
+    }
+
+    for (int k = 0; k < n; k++) {
+        // Stop at cancellation point
+        if (isCancelled()) {
+            deleteMat(&LU);
+            return NULL_MATRIX;
+        }
+
+        // Partial pivoting: select largest magnitude in column, within band
+        int bottom = min(n - 1, k + s.lower);
+        int pivot = k;
+        for (int i = k + 1; i <= bottom; i++) {
+            if (fabs(LU.data[i][k]) > fabs(LU.data[pivot][k]))
+                pivot = i;
+        }
+
+        // Swap rows by exchanging row pointers
+        if (pivot != k) {
+            double *row = LU.data[k];
+            LU.data[k] = LU.data[pivot];
+            LU.data[pivot] = row;
+
+            int index = perm[k];
+            perm[k] = perm[pivot];
+            perm[pivot] = index;
+
+            *sign = -*sign;
+        }
+
+        // Skip elimination on singular column
+        if (!LU.data[k][k]) {
+            *sign = 0;
+            continue;
+        }
+
+        // Eliminate within band, which pivoting widens above the diagonal
+        int right = min(n - 1, k + s.lower + s.upper);
+        for (int i = k + 1; i <= bottom; i++) {
+            double factor = LU.data[i][k] /= LU.data[k][k];
+            for (int j = k + 1; factor && j <= right; j++)
+                LU.data[i][j] -= factor * LU.data[k][j];
+        }
+    }
+
+    return LU; // must be freed
+}
+
+Matrix structuredDecomp(Matrix A, Structure s, int perm[], int *sign) {
+    // Return early on bad dimensions
+    if (isNull(A) || !isSquare(A))
+        return NULL_MATRIX;
+
+    // Dense matrices use the general kernel, as do banded ones in
+    // compensated precision, which needs long compensated sums
+    if (isPrecise() ? !isTriangular(s) : !isBanded(s, A) && !s.symmetric)
+        return luDecomp(A, perm, sign);
+
+    Probe probe = beginProbe();
+    Matrix LU = bandDecompKernel(A, s, perm, sign);
+    endProbe(&probe, KERNEL_LU, 2 * (uint64_t)A.m * s.lower * (s.lower + s.upper + 1));
+    return LU;
+}
+
+// -- Substitution --
+// Subtract a dot product from b, in the current precision
+static double residual(double b, const double *x, const double *y, int n) {
+    if (isPrecise())
+        return b - dotCompensated(x, y, n);
+
+    for (int k = 0; k < n; k++)
+        b -= x[k] * y[k];
+    return b;
+}
+
+// Find the first and last nonzero entry of each row of the factors,
+// returning how many entries lie between them
+static uint64_t extents(Matrix LU, int first[], int last[]) {
+    uint64_t entries = 0;
+
+    for (int i = 0; i < LU.m; i++) {
+        for (first[i] = 0; first[i] < i && !LU.data[i][first[i]]; first[i]++)
+            ;
+        for (last[i] = LU.n - 1; last[i] > i && !LU.data[i][last[i]]; last[i]--)
+            ;
+        entries += last[i] - first[i] + 1;
+    }
+
+    return entries;
+}
+
+// Solve A x = b from the factors of PA, within the extents of each row.
+// Back substitution stops at row stop, leaving the entries above unsolved.
+static void substitute(Matrix LU, const int perm[], const int first[], const int last[],
+                       const double b[], double x[], int stop) {
+    int n = LU.n;
+
+    // Forward substitution from the first nonzero of Pb
+    int start = 0;
+    while (start < n && !b[perm[start]])
+        x[start++] = 0;
+    for (int i = start; i < n; i++) {
+        int k = max(first[i], start);
+        x[i] = residual(b[perm[i]], &LU.data[i][k], &x[k], i - k);
+    }
+
+    // Back substitution from the last nonzero
+    int end = n - 1;
+    while (end >= stop && !x[end])
+        end--;
+    for (int i = end; i >= stop; i--) {
+        int right = min(last[i], end);
+        x[i] = residual(x[i], &LU.data[i][i + 1], &x[i + 1], right - i) / LU.data[i][i];
+    }
+}
+
+// Declare column solve arguments structure
+typedef struct columns {
+    Matrix LU;
+    const int *perm, *first, *last;
+    Matrix B; // right-hand sides, or null for the identity
+    Matrix X;
+    int symmetric; // whether X is, so only its lower triangle is solved
+    atomic_int failed;
+} Columns;
+
+static void solveColumns(void *arg, int begin, int end) {
+    Columns *c = arg;
+    int n = c->LU.n;
+
+    // Stop at cancellation point
+    if (isCancelled())
+        return;
+
+    double *b = maceAlloc(n * sizeof(double));
+    double *x = maceAlloc(n * sizeof(double));
+    if (!b || !x)
+        atomic_store(&c->failed, 1);
+    for (int j = begin; b && x && j < end; j++) {
+        // Gather right-hand side
+        if (isNull(c->B)) {
+            b[j] = 1;
+        } else {
+            for (int i = 0; i < n; i++)
+                b[i] = c->B.data[i][j];
+        }
+
+        int stop = c->symmetric ? j : 0;
+        substitute(c->LU, c->perm, c->first, c->last, b, x, stop);
+        if (isNull(c->B))
+            b[j] = 0;
+
+        // Scatter solution, reflecting it if symmetric
+        for (int i = stop; i < n; i++) {
+            c->X.data[i][j] = x[i];
+            if (c->symmetric)
+                c->X.data[j][i] = x[i];
+        }
+    }
+
+    maceFree(b);
+    maceFree(x);
+}
+
+// Solve for every column of the result, about GRAIN entries per chunk
+static Matrix solveKernel(Matrix LU, const int perm[], Matrix B, int symmetric,
+                          uint64_t *entries) {
+    int n = LU.n, cols = isNull(B) ? n : B.n;
+    int *first = maceAlloc(n * sizeof(int));
+    int *last = maceAlloc(n * sizeof(int));
+    if (!first || !last) {
+        maceFree(first);
+        maceFree(last);
+        *entries = 0;
+        return NULL_MATRIX;
+    }
+    *entries = extents(LU, first, last);
+
+    Columns c = {LU, perm, first, last, B, emptyMat(n, cols), symmetric};
+    if (!isNull(c.X))
+        parallelFor(currentPool(), cols, 1 + GRAIN / *entries, solveColumns, &c);
+
+    maceFree(first);
+    maceFree(last);
+
+    // Never return partial results
+    if (isCancelled() || atomic_load(&c.failed))
+        deleteMat(&c.X);
+    return c.X;
+}
+
+Matrix structuredInverse(Matrix LU, int perm[], Structure s) {
+    // Dense factors of unsymmetric matrices use the general kernel
+    if (!isBanded(s, LU) && !s.symmetric)
+        return luInverse(LU, perm);
+
+    Probe probe = beginProbe();
+    uint64_t entries;
+    Matrix inverseA = solveKernel(LU, perm, NULL_MATRIX, s.symmetric, &entries);
+    endProbe(&probe, KERNEL_LUINV, 2 * entries * LU.n / (s.symmetric ? 2 : 1));
+    return inverseA;
+}
+
+Matrix structuredSolve(Matrix LU, int perm[], Matrix B) {
+    // Return early on mismatched dimensions
+    if (isNull(LU) || LU.n != B.m)
+        return NULL_MATRIX;
+
+    Probe probe = beginProbe();
+    uint64_t entries;
+    Matrix X = solveKernel(LU, perm, B, 0, &entries);
+    endProbe(&probe, KERNEL_SOLVE, 2 * entries * B.n);
+    return X;
+}
@@ -0,0 +1,60 @@
+// File:        sum.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include "mace/sum.h"
+
+#include <string.h>
+
+#include "mace/target.h"
+
+// Sums are accumulated in independent lanes, each carrying the rounding
+// error of its additions (Knuth's branch-free TwoSum), so the loop runs in
+// vector registers. Products are rounded once before being summed, which
+// bounds the error by the conditioning of the sum rather than its length.
+
+// Combine lanes with a remainder, compensating the final additions
+static double combine(const Lanes *vs, const Lanes *vc, double s, double c) {
+    for (int l = 0; l < LANES; l++) {
+        ACCUMULATE(s, c, (*vs)[l]);
+        c += (*vc)[l];
+    }
+    return s + c;
+}
+
+CLONES double sumCompensated(const double *x, int n) {
+    Lanes vs = {}, vc = {};
+    double s = 0, c = 0;
+    int k = 0;
+
+    for (; k + LANES <= n; k += LANES) {
+        Lanes vx;
+        memcpy(&vx, &x[k], sizeof(vx)); // unaligned load
+        ACCUMULATE(vs, vc, vx);
+    }
+    for (; k < n; k++)
+        ACCUMULATE(s, c, x[k]);
+
+    return combine(&vs, &vc, s, c);
+}
+
+CLONES double dotCompensated(const double *x, const double *y, int n) {
+    Lanes vs = {}, vc = {};
+    double s = 0, c = 0;
+    int k = 0;
+
+    for (; k + LANES <= n; k += LANES) {
+        Lanes vx, vy;
+        memcpy(&vx, &x[k], sizeof(vx)); // unaligned loads
+        memcpy(&vy, &y[k], sizeof(vy));
+        Lanes vp = vx * vy;
+        ACCUMULATE(vs, vc, vp);
+    }
+    for (; k < n; k++) {
+        double p = x[k] * y[k];
+        ACCUMULATE(s, c, p);
+    }
+
+    return combine(&vs, &vc, s, c);
+}
@@ -0,0 +1,178 @@
+// File:        tensor.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include "mace/tensor.h"
+
+#include <limits.h>
+#include <stdint.h>
+
+#include "mace/map.h"
+#include "mace/pool.h"
+#include "mace/profile.h"
+#include "mace/runtime.h"
+#include "mace/target.h"
+
+// Kronecker products are written a row at a time, each row being scaled
+// copies of a single row of the right operand, which stays in cache while
+// it is reused. Rows are split across the current thread pool in chunks of
+// about GRAIN entries. Outer products are those of a column and a row, and
+// Hadamard products are maps.
+//
+// Kronecker products times a matrix are found without forming the product,
+// using (A (x) B) x = vec(A X B^T), where X holds x row by row as an
+// A.n by B.n matrix. For A m by n and B p by q, this takes O(mq(n + p))
+// time per column of x, rather than O(mnpq), and memory of the order of
+// the operands only.
+
+#define GRAIN 16384 // entries per chunk
+
+#define NULL_MATRIX \
+    (Matrix) {      \
+        0, 0, 0     \
+    }
+
+// Declare row product structure
+typedef struct rows {
+    Matrix A, B, C;
+} Rows;
+
+// Number of entries in a vector, or zero if not a vector
+static int length(Matrix A) {
+    return (A.m == 1 || A.n == 1) ? A.m * A.n : 0;
+}
+
+// -- Kernels --
+CLONES static void kronRows(void *arg, int begin, int end) {
+    const Rows *r = arg;
+    Matrix A = r->A, B = r->B, C = r->C;
+
+    // Skip remaining chunks once cancelled
+    if (isCancelled())
+        return;
+
+    // Row i * B.m + k of C holds A(i,j) B(k,:) for each j
+    for (int row = begin; row < end; row++) {
+        const double *a = A.data[row / B.m], *b = B.data[row % B.m];
+        for (int j = 0; j < A.n; j++) {
+            double *c = C.data[row] + (size_t)j * B.n;
+            for (int l = 0; l < B.n; l++)
+                c[l] = a[j] * b[l];
+        }
+    }
+}
+
+static Matrix kronKernel(Matrix A, Matrix B) {
+    // Return early on products too large to index
+    if ((int64_t)A.m * B.m > INT_MAX || (int64_t)A.n * B.n > INT_MAX)
+        return NULL_MATRIX;
+
+    Rows r = {A, B, emptyMat(A.m * B.m, A.n * B.n)};
+    if (isNull(r.C))
+        return r.C;
+    parallelFor(currentPool(), r.C.m, 1 + GRAIN / r.C.n, kronRows, &r);
+
+    // Never return a partial result
+    if (isCancelled())
+        deleteMat(&r.C);
+
+    return r.C; // must be freed
+}
+
+static Matrix kronMulKernel(Matrix A, Matrix B, Matrix X) {
+    // Return early on mismatched dimensions
+    if ((int64_t)A.n * B.n != X.m || (int64_t)A.m * B.m > INT_MAX)
+        return NULL_MATRIX;
+
+    Matrix Y = emptyMat(A.m * B.m, X.n);
+    Matrix Xs = emptyMat(A.n, B.n), transpB = transpose(B);
+    for (int s = 0; s < X.n && !isNull(Y); s++) {
+        if (isNull(Xs) || isNull(transpB)) {
+            deleteMat(&Y);
+            break;
+        }
+
+        // Fold column s of X into an A.n by B.n matrix, row by row
+        for (int k = 0; k < X.m; k++)
+            Xs.data[k / B.n][k % B.n] = X.data[k][s];
+
+        // Unfold A Xs B^T into column s of the result
+        Matrix T = mulMat(A, Xs);
+        Matrix Ys = isNull(T) ? NULL_MATRIX : mulMat(T, transpB);
+        if (isNull(Ys)) {
+            deleteMat(&Y);
+        } else {
+            for (int k = 0; k < Y.m; k++)
+                Y.data[k][s] = Ys.data[k / B.m][k % B.m];
+            deleteMat(&Ys);
+        }
+        if (!isNull(T))
+            deleteMat(&T);
+    }
+
+    if (!isNull(Xs))
+        deleteMat(&Xs);
+    if (!isNull(transpB))
+        deleteMat(&transpB);
+    return Y; // must be freed
+}
+
+static Matrix hadamardKernel(Matrix A, Matrix B) {
+    // Return early on mismatched dimensions, which maps would broadcast
+    if ((A.m != B.m) || (A.n != B.n))
+        return NULL_MATRIX;
+
+    Map map = {};
+    mapLoad(&map, 0);
+    mapLoad(&map, 1);
+    mapOp(&map, OP_MUL);
+
+    return evalMap(&map, (Matrix[]){A, B}); // must be freed
+}
+
+static Matrix outerKernel(Matrix u, Matrix v) {
+    // Return early on operands that are not vectors
+    if (!length(u) || !length(v))
+        return NULL_MATRIX;
+
+    // Orient u as a column and v as a row
+    Matrix column = (u.n == 1) ? u : transpose(u);
+    Matrix row = (v.m == 1) ? v : transpose(v);
+    Matrix C = (isNull(column) || isNull(row)) ? NULL_MATRIX : kronKernel(column, row);
+
+    if (column.data != u.data && !isNull(column))
+        deleteMat(&column);
+    if (row.data != v.data && !isNull(row))
+        deleteMat(&row);
+    return C; // must be freed
+}
+
+// -- Profiled kernels --
+Matrix kronMat(Matrix A, Matrix B) {
+    Probe probe = beginProbe();
+    Matrix C = kronKernel(A, B);
+    endProbe(&probe, KERNEL_KRON, (uint64_t)A.m * A.n * B.m * B.n);
+    return C;
+}
+
+Matrix kronMulMat(Matrix A, Matrix B, Matrix X) {
+    Probe probe = beginProbe();
+    Matrix Y = kronMulKernel(A, B, X);
+    endProbe(&probe, KERNEL_KRON, 2 * (uint64_t)X.n * A.m * B.n * (A.n + B.m));
+    return Y;
+}
+
+Matrix hadamardMat(Matrix A, Matrix B) {
+    Probe probe = beginProbe();
+    Matrix C = hadamardKernel(A, B);
+    endProbe(&probe, KERNEL_HADAMARD, (uint64_t)A.m * A.n);
+    return C;
+}
+
+Matrix outerMat(Matrix u, Matrix v) {
+    Probe probe = beginProbe();
+    Matrix C = outerKernel(u, v);
+    endProbe(&probe, KERNEL_KRON, (uint64_t)length(u) * length(v));
+    return C;
+}
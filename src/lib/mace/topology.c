@@ -0,0 +1,196 @@
+// File:        topology.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _GNU_SOURCE
+
+#include "mace/topology.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// The topology is read once, on first use. Threads of a pool are bound to
+// nodes in contiguous blocks, and pinned to every processor of their node,
+// so the scheduler may still balance within it. Other threads find their
+// node from the processor they are running on. Memory interleaving binds
+// pages with mbind directly, as the kernel has no libc wrapper for it.
+
+#define MPOL_INTERLEAVE 3 // from linux/mempolicy.h
+
+static Topology topology;
+
+// Node of the calling thread, offset by one so zero is unbound
+static _Thread_local int bound;
+
+static _Atomic uint64_t localChunks[NODE_MAX], stolenChunks[NODE_MAX];
+
+static int onlineCpus(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus < 1) ? 1 : (cpus > CPU_MAX) ? CPU_MAX : cpus;
+}
+
+// Split processors evenly between simulated nodes
+static int simulate(const char *spec) {
+    int nodes, per = 0;
+    if (sscanf(spec, "%d x %d", &nodes, &per) < 1 || nodes < 1 || nodes > NODE_MAX || per < 0)
+        return -1;
+
+    int cpus = per ? nodes * per : onlineCpus();
+    topology.cpus = (cpus < nodes) ? nodes : (cpus > CPU_MAX) ? CPU_MAX : cpus;
+    topology.nodes = nodes;
+    topology.simulated = 1;
+    for (int k = 0; k < nodes; k++)
+        topology.id[k] = k;
+    for (int c = 0; c < topology.cpus; c++)
+        topology.node[c] = (long)c * nodes / topology.cpus;
+    return 0;
+}
+
+// Assign the processors of a list such as 0-3,8-11 to a node
+static void readCpus(int node, int id) {
+    char path[64], list[4096];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return;
+    if (!fgets(list, sizeof(list), file))
+        list[0] = '\0';
+    fclose(file);
+
+    for (char *s = list; *s >= '0' && *s <= '9';) {
+        int first = strtol(s, &s, 10), last = first;
+        if (*s == '-')
+            last = strtol(s + 1, &s, 10);
+        for (int c = first; c <= last && c < CPU_MAX; c++) {
+            topology.node[c] = node;
+            if (c >= topology.cpus)
+                topology.cpus = c + 1;
+        }
+        if (*s == ',')
+            s++;
+    }
+}
+
+// Read nodes from sysfs, in order of their identifiers
+static void discover(void) {
+    DIR *dir = opendir("/sys/devices/system/node");
+    struct dirent *entry;
+    while (dir && (entry = readdir(dir)) && topology.nodes < NODE_MAX) {
+        int id, end;
+        if (sscanf(entry->d_name, "node%d%n", &id, &end) != 1 || entry->d_name[end])
+            continue;
+
+        int k = topology.nodes++;
+        for (; k > 0 && topology.id[k - 1] > id; k--)
+            topology.id[k] = topology.id[k - 1];
+        topology.id[k] = id;
+    }
+    if (dir)
+        closedir(dir);
+
+    for (int k = 0; k < topology.nodes; k++)
+        readCpus(k, topology.id[k]);
+
+    // Fall back to a single node holding every processor
+    if (topology.nodes < 2 || !topology.cpus) {
+        memset(&topology, 0, sizeof(topology));
+        topology.nodes = 1;
+        topology.cpus = onlineCpus();
+    }
+}
+
+static void initTopology(void) {
+    const char *spec = getenv("MACE_NUMA");
+    if (!spec || simulate(spec))
+        discover();
+}
+
+const Topology *currentTopology(void) {
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+    // Lazily read topology
+    pthread_once(&once, initTopology);
+
+    return &topology;
+}
+
+int workerNode(int worker, int workers) {
+    const Topology *t = currentTopology();
+    return (workers < 1) ? 0 : (long)worker * t->nodes / workers;
+}
+
+void bindNode(int node) {
+    const Topology *t = currentTopology();
+    bound = node + 1;
+
+    // Pin to every processor of the node
+    if (t->simulated || t->nodes < 2)
+        return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c = 0; c < t->cpus; c++) {
+        if (t->node[c] == node)
+            CPU_SET(c, &set);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+int currentNode(void) {
+    const Topology *t = currentTopology();
+    if (bound)
+        return bound - 1;
+    if (t->simulated || t->nodes < 2)
+        return 0;
+
+    int cpu = sched_getcpu();
+    return (cpu >= 0 && cpu < t->cpus) ? t->node[cpu] : 0;
+}
+
+// -- Memory --
+void placeMemory(void *addr, size_t size, Placement placement) {
+    const Topology *t = currentTopology();
+    if (placement != PLACEMENT_INTERLEAVE || t->simulated || t->nodes < 2)
+        return;
+
+#ifdef SYS_mbind
+    // Bind whole pages only, leaving neighbouring blocks alone
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t)addr + page - 1) & ~(page - 1);
+    uintptr_t end = ((uintptr_t)addr + size) & ~(page - 1);
+    if (end <= start)
+        return;
+
+    unsigned long mask[NODE_MAX / 64 + 1] = {};
+    for (int k = 0; k < t->nodes; k++)
+        mask[t->id[k] / 64] |= 1UL << (t->id[k] % 64);
+    syscall(SYS_mbind, start, end - start, MPOL_INTERLEAVE, mask, sizeof(mask) * 8, 0);
+#endif
+}
+
+// -- Counters --
+void countChunk(int node, int stolen) {
+    atomic_fetch_add_explicit(stolen ? &stolenChunks[node] : &localChunks[node], 1,
+                              memory_order_relaxed);
+}
+
+void readPlaced(Placed placed[NODE_MAX]) {
+    for (int k = 0; k < NODE_MAX; k++) {
+        placed[k].local = atomic_load_explicit(&localChunks[k], memory_order_relaxed);
+        placed[k].stolen = atomic_load_explicit(&stolenChunks[k], memory_order_relaxed);
+    }
+}
+
+void resetPlaced(void) {
+    for (int k = 0; k < NODE_MAX; k++) {
+        atomic_store(&localChunks[k], 0);
+        atomic_store(&stolenChunks[k], 0);
+    }
+}
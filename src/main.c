@@ -3,8 +3,45 @@
 // Created:     21 Jun 2020
 // SPDX-License-Identifier: NONE
 
-#include "mace/mace.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "command.h"
+#include "job.h"
+#include "journal.h"
+#include "repl.h"
+#include "script.h"
+#include "server.h"
+
+int main(int argc, char *argv[]) {
+    // Run as a server when given a socket
+    if (argc == 3 && strcmp(argv[1], "--serve") == 0)
+        return serve(argv[2]);
+    // Replay journal headlessly when given one
+    if (argc == 3 && strcmp(argv[1], "--replay") == 0) {
+        registerBuiltins();
+        Context *ctx = newContext(NULL, NULL);
+        int status = replayJournal(ctx, argv[2]);
+        if (status)
+            fprintf(stderr, "Error: could not open %s.\n", argv[2]);
+        stopJobs(ctx);
+        deleteContext(ctx);
+        return status ? 1 : 0;
+    }
+    if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+        fprintf(stderr, "usage: %s [--serve path | --replay journal | script]\n", argv[0]);
+        return 1;
+    }
+
+    // Run script when given a file
+    if (argc == 2) {
+        registerBuiltins();
+        Context *ctx = newContext(NULL, NULL);
+        int status = runScript(ctx, argv[1]);
+        stopJobs(ctx);
+        deleteContext(ctx);
+        return status;
+    }
 
-int main(void) {
     mace();
 }
@@ -0,0 +1,1426 @@
+// File:        repl.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     25 Apr 2019
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "repl.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "command.h"
+#include "expr.h"
+#include "job.h"
+#include "journal.h"
+#include "mace/mace.h"
+
+// Output stream bound to the calling thread
+static _Thread_local FILE *bound;
+
+// TODO: Prompt for invalid user function inputs
+
+void mace(void) {
+    printf("---------------------------------------------------------------\n");
+    printf("Welcome to the Matrix Arithmetic C-language Environment (Mace).\n");
+    printf("Copyright © 2019 Zakhary Kaplan. All rights reserved.\n");
+    printf("---------------------------------------------------------------\n\n");
+    printf("Mace is a matrix arithmetic environment programmed in C.\n"
+           "It uses bash-like syntax to perform matrix operations.\n\n");
+    printf("Type \"help\" to see a list of commands.\n");
+
+    // Create context holding the workspace
+    registerBuiltins();
+    Context *ctx = newContext(NULL, NULL);
+
+    // Begin running program
+    while (1) {
+        printf(">>> ");
+
+        // Get user input, quitting at end of input
+        char userInput[MAX] = {};
+        if (!fgets(userInput, MAX, stdin))
+            break;
+
+        // Run command
+        if (execute(ctx, userInput))
+            break; // quit program
+    }
+
+    // Delete workspace, and any running jobs
+    stopRecording(ctx);
+    stopJobs(ctx);
+    deleteContext(ctx);
+}
+
+// -- Secondary functions --
+FILE *useOutput(FILE *stream) {
+    FILE *previous = bound;
+    bound = stream;
+    return previous;
+}
+
+FILE *currentOutput(void) {
+    return bound ? bound : stdout;
+}
+
+void output(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(currentOutput(), format, args);
+    va_end(args);
+}
+
+void printMat(Matrix A) {
+    // Iterate through rows and columns
+    for (int i = 0; i < A.m; i++) {
+        for (int j = 0; j < A.n; j++) {
+            output("% 6.3g", A.data[i][j]);
+
+            if (j + 1 < A.n)
+                output(" ");
+        }
+        output("\n");
+    }
+}
+
+void printEntry(Context *ctx, int index) {
+    Matrix A;
+    maceGet(ctx, index, &A);
+
+    output("\n");
+    output("Mat%c (%dx%d) = \n", index + 'A', A.m, A.n);
+    printMat(A);
+    output("\n");
+}
+
+void printAns(Context *ctx) {
+    Matrix ans;
+    maceGet(ctx, ANS, &ans);
+
+    output("\n");
+    output("MatAns (%dx%d) = \n", ans.m, ans.n);
+    printMat(ans);
+    output("\n");
+}
+
+void printError(Status status) {
+    switch (status) {
+        case MACE_EDIM:
+            output("Error: incompatible operands. Try again with matricies of "
+                   "valid dimensions to perform this operation.\n");
+            break;
+
+        case MACE_EFULL:
+            output("Error: could not save new object to workspace. Clear the "
+                   "workspace with clr and try again.\n");
+            break;
+
+        case MACE_ENOANS:
+            output("Error: perform an operation before attempting to use "
+                   "ans.\n");
+            break;
+
+        case MACE_EILLCOND:
+            output("Error: matrix is too ill-conditioned to invert accurately. "
+                   "Check its condition number with cond.\n");
+            break;
+
+        case MACE_ENOMEM:
+            output("Error: memory budget exceeded. Free matrices with clr, or "
+                   "raise the budget with mem limit.\n");
+            break;
+
+        default:
+            output("Error: %s.\n", maceStrerror(status));
+            break;
+    }
+}
+
+// Report the result of an operation replacing ans
+static int answer(Context *ctx, Status status) {
+    if (status)
+        printError(status);
+    else
+        printAns(ctx);
+
+    return 0;
+}
+
+// Report the result of an operation adding to the workspace
+static int store(Context *ctx, Status status, int slot) {
+    if (status)
+        printError(status);
+    else
+        printEntry(ctx, slot);
+
+    return 0;
+}
+
+// Report the result of an operation updating a matrix in place
+static int updated(Status status) {
+    if (status == MACE_EARG)
+        output("Error: index out of range. Try again with indices within the "
+               "dimensions of the matrix.\n");
+    else if (status)
+        printError(status);
+
+    return 0;
+}
+
+// -- Commands --
+static int help(Context *ctx, int argc, Arg argv[]) {
+    // Print general help menu
+    if (argc == 0) {
+        output("\nQuick Help Menu:\n");
+
+        for (int i = 0; i < numCommands(); i++) {
+            const Command *cmd = getCommand(i);
+            output("%s\t- %s\n", cmd->name, cmd->summary);
+        }
+
+        output("\n");
+        return 0;
+    }
+
+    // Look up command
+    const Command *cmd = findCommand(argv[0].word);
+    if (!cmd) {
+        output("\nNo help entry found for: %s\n", argv[0].word);
+        output("Use \"help\" to see a list of available commands.\n\n");
+        return 0;
+    }
+
+    output("\nHelp menu: %s\n\n", cmd->name);
+    output("Description: %s\n", cmd->description);
+
+    if (cmd->parameters)
+        output("Parameters: %s\n", cmd->parameters);
+
+    // Explain identifiers for commands taking matrices
+    if (strchr(cmd->signature, 'm')) {
+        output("Note: Identifiers are the letter associated with "
+               "a matrix in the workspace.\n");
+        output("\t- They can be written in either capital, or "
+               "lowercase,\n");
+        output("\t  and may be proceeded by Mat (e.g. MatA).\n");
+        output("\t- The ans matrix can be written as MatAns, or ans.\n");
+    }
+
+    // Print each example on its own line
+    if (cmd->examples) {
+        output("Examples:\n");
+        for (const char *line = cmd->examples; *line;) {
+            int len = strcspn(line, "\n");
+            output("\t>>> %.*s\n", len, line);
+            line += len + (line[len] == '\n');
+        }
+    }
+
+    output("\n");
+    return 0;
+}
+
+static int bye(Context *ctx, int argc, Arg argv[]) {
+    return 1; // quit program
+}
+
+static int print(Context *ctx, int argc, Arg argv[]) {
+    int size = maceSize(ctx);
+    Matrix ans;
+    int hasAns = (maceGet(ctx, ANS, &ans) == MACE_OK);
+
+    // Count parameters
+    if (argc == 0) {               // Print entire workspace
+        if (size > 0 || hasAns) { // Check if workspace is empty
+            output("\nWorkspace (%d/%d):\n", size, WORKSPACE_SIZE);
+
+            for (int i = 0; i < size; i++) {
+                printEntry(ctx, i); // iteratively print each item
+            }
+
+            if (hasAns)
+                printAns(ctx);
+        } else { // If empty, alert user
+            output("\nWorkspace is empty.\n\n");
+        }
+    } else {
+        // Print each operand
+        for (int i = 0; i < argc; i++) {
+            Matrix operand;
+            Status status = maceGet(ctx, argv[i].id, &operand);
+
+            // Print non null operands
+            if (!status) {
+                // Determine whether operand is in workspace, or is ans
+                if (argv[i].id == ANS) {
+                    printAns(ctx);
+                } else {
+                    printEntry(ctx, argv[i].id);
+                }
+            } else if (status == MACE_ENOANS) { // Check if ans was used while null
+                printError(status);
+            } else { // Display error message for null operands
+                output("Error: operand #%d not recognized.\n", i + 1);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int clr(Context *ctx, int argc, Arg argv[]) {
+    maceClear(ctx);
+    return 0;
+}
+
+static int mat(Context *ctx, int argc, Arg argv[]) {
+    char *input = argv[0].word;
+
+    // Use ans matrix as input
+    int slot;
+    if (strcmp(input, "ans") == 0) {
+        Status status = maceCopy(ctx, ANS, &slot);
+        return store(ctx, status, slot);
+    }
+
+    // On mismatch, alert user
+    Status status = maceParse(ctx, input, strlen(input), &slot);
+    if (status == MACE_EARG) {
+        output("Error: could not infer dimensions from data.\n");
+        return 0;
+    }
+
+    return store(ctx, status, slot);
+}
+
+static int load(Context *ctx, int argc, Arg argv[]) {
+    int slot;
+    Status status = maceLoad(ctx, argv[0].word, &slot);
+    if (status == MACE_EIO) {
+        output("Error: could not read %s.\n", argv[0].word);
+        return 0;
+    } else if (status == MACE_EARG) {
+        output("Error: could not infer dimensions from data in %s.\n", argv[0].word);
+        return 0;
+    }
+
+    return store(ctx, status, slot);
+}
+
+static int share(Context *ctx, int argc, Arg argv[]) {
+    Status status = maceShare(ctx, argv[0].id, argv[1].word);
+    if (status == MACE_ESHARED)
+        output("Error: could not share matrix as %s. Names may only contain "
+               "letters, digits, and _-. and must not already be shared.\n",
+               argv[1].word);
+    else if (status)
+        printError(status);
+
+    return 0;
+}
+
+static int attach(Context *ctx, int argc, Arg argv[]) {
+    int slot;
+    Status status = maceAttach(ctx, argv[0].word, &slot);
+    if (status == MACE_ESHARED) {
+        output("Error: no shared matrix named %s.\n", argv[0].word);
+        return 0;
+    }
+
+    return store(ctx, status, slot);
+}
+
+static int unshare(Context *ctx, int argc, Arg argv[]) {
+    if (maceUnshare(ctx, argv[0].word))
+        output("Error: no shared matrix named %s.\n", argv[0].word);
+
+    return 0;
+}
+
+static int checkpoint(Context *ctx, int argc, Arg argv[]) {
+    // Compress only when asked
+    int compress = 0;
+    if (argc == 2) {
+        if (strcmp(argv[1].word, "compress") != 0) {
+            output("Error: option %s not recognized. Try compress.\n", argv[1].word);
+            return 0;
+        }
+        compress = 1;
+    }
+
+    Status status = maceCheckpoint(ctx, argv[0].word, compress);
+    if (status == MACE_EIO)
+        output("Error: could not write checkpoint %s.\n", argv[0].word);
+    else if (status)
+        printError(status);
+
+    return 0;
+}
+
+static int restore(Context *ctx, int argc, Arg argv[]) {
+    Status status = maceRestore(ctx, argv[0].word);
+    if (status == MACE_EIO)
+        output("Error: could not read checkpoint %s. The workspace was left "
+               "unchanged.\n",
+               argv[0].word);
+    else if (status)
+        printError(status);
+
+    return 0;
+}
+
+static int structure(Context *ctx, int argc, Arg argv[]) {
+    Structure s;
+    Matrix A;
+    Status status = maceStructure(ctx, argv[0].id, &s);
+    if (status) {
+        printError(status);
+        return 0;
+    }
+    maceGet(ctx, argv[0].id, &A);
+
+    // Name the narrowest kind of band
+    const char *kind = "dense";
+    if (!s.lower && !s.upper)
+        kind = "diagonal";
+    else if (!s.lower)
+        kind = "upper triangular";
+    else if (!s.upper)
+        kind = "lower triangular";
+    else if (s.lower == 1 && s.upper == 1)
+        kind = "tridiagonal";
+    else if (s.lower < A.m - 1 || s.upper < A.n - 1)
+        kind = "banded";
+
+    output("\n");
+    if (argv[0].id == ANS)
+        output("MatAns");
+    else
+        output("Mat%c", argv[0].id + 'A');
+    output(" (%dx%d) is %s%s, with bandwidths %d (lower) and %d (upper).\n\n", A.m, A.n,
+           s.symmetric ? "symmetric " : "", kind, s.lower, s.upper);
+
+    return 0;
+}
+
+static int ident(Context *ctx, int argc, Arg argv[]) {
+    int slot;
+    Status status = maceIdent(ctx, argv[0].count, &slot);
+
+    // Check if output is null
+    if (status == MACE_EARG) {
+        output("Error: invalid dimensions. Try again with a positive "
+               "integer.\n");
+        return 0;
+    }
+
+    return store(ctx, status, slot);
+}
+
+static int zeros(Context *ctx, int argc, Arg argv[]) {
+    int slot;
+    Status status = maceZeros(ctx, argv[0].count, argv[1].count, &slot);
+
+    // Check if output is null
+    if (status == MACE_EARG) {
+        output("Error: invalid dimensions. Try again with two positive "
+               "integers.\n");
+        return 0;
+    }
+
+    return store(ctx, status, slot);
+}
+
+static int set(Context *ctx, int argc, Arg argv[]) {
+    // Indices start from one
+    Status status = maceSet(ctx, argv[0].id, argv[1].count - 1, argv[2].count - 1, argv[3].num);
+    return updated(status);
+}
+
+static int setrow(Context *ctx, int argc, Arg argv[]) {
+    return updated(maceSetRow(ctx, argv[0].id, argv[1].count - 1, argv[2].id));
+}
+
+static int setcol(Context *ctx, int argc, Arg argv[]) {
+    return updated(maceSetCol(ctx, argv[0].id, argv[1].count - 1, argv[2].id));
+}
+
+static int update(Context *ctx, int argc, Arg argv[]) {
+    return updated(maceUpdate(ctx, argv[0].id, argv[1].id, argv[2].id));
+}
+
+static int add(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceAdd(ctx, argv[0].id, argv[1].id));
+}
+
+static int sub(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceSub(ctx, argv[0].id, argv[1].id));
+}
+
+static int map(Context *ctx, int argc, Arg argv[]) {
+    Expr expr;
+    const char *error = parseExpr(argv[0].word, &expr);
+    if (error) {
+        output("Error: %s.\n", error);
+        return 0;
+    }
+
+    return answer(ctx, maceMap(ctx, &expr.map, expr.ids));
+}
+
+static int mul(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceMul(ctx, argv[0].id, argv[1].id));
+}
+
+static int kron(Context *ctx, int argc, Arg argv[]) {
+    if (argc == 3)
+        return answer(ctx, maceKronMul(ctx, argv[0].id, argv[1].id, argv[2].id));
+    return answer(ctx, maceKron(ctx, argv[0].id, argv[1].id));
+}
+
+static int hadamard(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceHadamard(ctx, argv[0].id, argv[1].id));
+}
+
+static int outer(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceOuter(ctx, argv[0].id, argv[1].id));
+}
+
+static int scl(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceScl(ctx, argv[0].num, argv[1].id));
+}
+
+static int trnsp(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceTrnsp(ctx, argv[0].id));
+}
+
+static int inv(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceInv(ctx, argv[0].id));
+}
+
+static int solve(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceSolve(ctx, argv[0].id, argv[1].id));
+}
+
+// Parse an option of the form key=value, returning 0 on success
+static int parseOption(Iteration *it, Method method, char option[]) {
+    static const char *const preconditioners[] = {
+        [PRECONDITIONER_NONE] = "none",
+        [PRECONDITIONER_JACOBI] = "jacobi",
+        [PRECONDITIONER_ILU] = "ilu",
+    };
+
+    char *value = strchr(option, '='), *end;
+    if (!value)
+        return -1;
+    *value++ = '\0';
+
+    if (strcmp(option, "tol") == 0) {
+        it->tolerance = strtod(value, &end);
+    } else if (strcmp(option, "iter") == 0) {
+        it->limit = strtol(value, &end, 10);
+    } else if (strcmp(option, "restart") == 0 && method == METHOD_GMRES) {
+        it->restart = strtol(value, &end, 10);
+    } else if (strcmp(option, "pre") == 0) {
+        for (size_t i = 0; i < sizeof(preconditioners) / sizeof(*preconditioners); i++) {
+            if (strcmp(value, preconditioners[i]) == 0) {
+                it->preconditioner = (Preconditioner)i;
+                return 0;
+            }
+        }
+        return -1;
+    } else {
+        return -1;
+    }
+
+    // Reject partially converted numbers
+    return (end == value || *end) ? -1 : 0;
+}
+
+// Solve iteratively, then report iterations and time taken
+static int iterate(Context *ctx, Method method, int argc, Arg argv[]) {
+    Iteration it = {.tolerance = 1e-8, .limit = 1000, .restart = 30};
+    for (int i = 2; i < argc; i++) {
+        if (parseOption(&it, method, argv[i].word)) {
+            output("Error: parameter #%d is not a valid option.\n", i + 1);
+            return 0;
+        }
+    }
+
+    // Catch the most likely misuse of cg early
+    Matrix A;
+    Structure s;
+    if (method == METHOD_CG && !maceGet(ctx, argv[0].id, &A) && isSquare(A) &&
+        !maceStructure(ctx, argv[0].id, &s) && !s.symmetric) {
+        output("Error: cg needs a symmetric positive definite matrix. Try gmres "
+               "instead.\n");
+        return 0;
+    }
+
+    Status status = maceIterate(ctx, method, argv[0].id, argv[1].id, &it);
+    if (status == MACE_ESINGULAR) {
+        output("Error: preconditioner has a zero pivot. Try another with pre=.\n");
+        return 0;
+    } else if (status == MACE_EILLCOND) {
+        output("Error: iteration broke down after %d iteration%s. Try another "
+               "preconditioner with pre=, or solve directly with solve.\n",
+               it.iterations, (it.iterations == 1) ? "" : "s");
+        return 0;
+    } else if (status) {
+        return answer(ctx, status);
+    }
+
+    if (it.residual <= it.tolerance)
+        output("Converged in %d iteration%s to residual %.3g, in %.3f ms.\n", it.iterations,
+               (it.iterations == 1) ? "" : "s", it.residual, it.seconds * 1e3);
+    else
+        output("Stopped after %d iteration%s at residual %.3g, above tolerance, in %.3f ms.\n",
+               it.iterations, (it.iterations == 1) ? "" : "s", it.residual, it.seconds * 1e3);
+    return answer(ctx, status);
+}
+
+static int cg(Context *ctx, int argc, Arg argv[]) {
+    return iterate(ctx, METHOD_CG, argc, argv);
+}
+
+static int gmres(Context *ctx, int argc, Arg argv[]) {
+    return iterate(ctx, METHOD_GMRES, argc, argv);
+}
+
+static int det(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceDet(ctx, argv[0].id));
+}
+
+static int trc(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceTrc(ctx, argv[0].id));
+}
+
+static int cond(Context *ctx, int argc, Arg argv[]) {
+    return answer(ctx, maceCond(ctx, argv[0].id));
+}
+
+// Parse words naming outputs, and an axis, following the operand
+static int parseOutputs(int argc, Arg argv[], const char *const names[], int count,
+                        unsigned *mask, Axis *axis) {
+    static const char *const axes[] = {
+        [AXIS_ALL] = "all",
+        [AXIS_ROWS] = "rows",
+        [AXIS_COLS] = "cols",
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *word = argv[i].word;
+        int found = 0;
+        for (int k = 0; k < count && !found; k++) {
+            if ((found = (strcmp(word, names[k]) == 0)))
+                *mask |= 1u << k;
+        }
+        for (int k = AXIS_ALL; k <= AXIS_COLS && !found; k++) {
+            if ((found = (strcmp(word, axes[k]) == 0)))
+                *axis = (Axis)k;
+        }
+        if (!found) {
+            output("Error: unknown %s: %s\n", count ? "output or axis" : "axis", word);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int reduceBy(Context *ctx, Reduction r, int argc, Arg argv[]) {
+    unsigned mask = 1u << r;
+    Axis axis = AXIS_ALL;
+    if (parseOutputs(argc, argv, NULL, 0, &mask, &axis))
+        return 0;
+
+    return answer(ctx, maceReduce(ctx, mask, axis, argv[0].id));
+}
+
+static int sum(Context *ctx, int argc, Arg argv[]) {
+    return reduceBy(ctx, REDUCE_SUM, argc, argv);
+}
+
+static int mean(Context *ctx, int argc, Arg argv[]) {
+    return reduceBy(ctx, REDUCE_MEAN, argc, argv);
+}
+
+static int min(Context *ctx, int argc, Arg argv[]) {
+    return reduceBy(ctx, REDUCE_MIN, argc, argv);
+}
+
+static int max(Context *ctx, int argc, Arg argv[]) {
+    return reduceBy(ctx, REDUCE_MAX, argc, argv);
+}
+
+static int reduce(Context *ctx, int argc, Arg argv[]) {
+    static const char *const names[] = {
+        [REDUCE_SUM] = "sum",
+        [REDUCE_MEAN] = "mean",
+        [REDUCE_MIN] = "min",
+        [REDUCE_MAX] = "max",
+    };
+
+    // Default to every reduction
+    unsigned mask = 0;
+    Axis axis = AXIS_ALL;
+    if (parseOutputs(argc, argv, names, REDUCTIONS, &mask, &axis))
+        return 0;
+
+    return answer(ctx, maceReduce(ctx, mask ? mask : (1u << REDUCTIONS) - 1, axis, argv[0].id));
+}
+
+static int norm(Context *ctx, int argc, Arg argv[]) {
+    static const char *const names[] = {
+        [NORM_ONE] = "1",
+        [NORM_INF] = "inf",
+        [NORM_FRO] = "fro",
+        [NORM_MAX] = "max",
+    };
+
+    // Default to the Frobenius norm
+    unsigned mask = 0;
+    Axis axis = AXIS_ALL;
+    if (parseOutputs(argc, argv, names, NORMS, &mask, &axis))
+        return 0;
+
+    return answer(ctx, maceNorm(ctx, mask ? mask : 1u << NORM_FRO, axis, argv[0].id));
+}
+
+static int batch(Context *ctx, int argc, Arg argv[]) {
+    // Get operation from first input
+    const char *op = argv[0].word;
+    BatchOp type;
+    if (strcmp(op, "mul") == 0) {
+        type = BATCH_MUL;
+    } else if (strcmp(op, "inv") == 0) {
+        type = BATCH_INV;
+    } else if (strcmp(op, "det") == 0) {
+        type = BATCH_DET;
+    } else {
+        output("Error: unknown batch operation: %s\n", op);
+        return 0;
+    }
+
+    // Count parameters
+    int arity = (type == BATCH_MUL) ? 3 : 2;
+    if (argc != arity) {
+        output("Error: incorrect number of parameters. (%d/%d)\n", argc, arity);
+        return 0;
+    }
+
+    Status status = maceBatch(ctx, type, argv[1].id, (arity == 3) ? argv[2].id : ANS);
+    if (status == MACE_EARG) {
+        output("Error: operand is not a stack of square matrices.\n");
+    } else if (status == MACE_EDIM) {
+        output("Error: incompatible operands. Try again with stacks of "
+               "equal size, and blocks no larger than 4x4 for inv and "
+               "det.\n");
+    } else {
+        answer(ctx, status);
+    }
+
+    return 0;
+}
+
+static int precision(Context *ctx, int argc, Arg argv[]) {
+    static const char *const modes[] = {
+        [PRECISION_FAST] = "fast",
+        [PRECISION_COMPENSATED] = "compensated",
+    };
+
+    // Report current mode without parameters
+    if (!argc) {
+        output("%s\n", modes[macePrecision(ctx)]);
+        return 0;
+    }
+
+    for (size_t i = 0; i < sizeof(modes) / sizeof(*modes); i++) {
+        if (strcmp(argv[0].word, modes[i]) == 0) {
+            maceSetPrecision(ctx, (Precision)i);
+            return 0;
+        }
+    }
+    output("Error: unknown precision: %s\n", argv[0].word);
+
+    return 0;
+}
+
+// Report the processors of a node as ranges
+static void printCpus(const Topology *t, int node) {
+    const char *separator = "";
+    for (int c = 0; c < t->cpus; c++) {
+        if (t->node[c] != node)
+            continue;
+        int last = c;
+        while (last + 1 < t->cpus && t->node[last + 1] == node)
+            last++;
+        output(last > c ? "%s%d-%d" : "%s%d", separator, c, last);
+        separator = ",";
+        c = last;
+    }
+}
+
+static int numa(Context *ctx, int argc, Arg argv[]) {
+    static const char *const policies[] = {
+        [PLACEMENT_LOCAL] = "local",
+        [PLACEMENT_INTERLEAVE] = "interleave",
+    };
+
+    // Report topology and chunks placed without parameters
+    if (!argc) {
+        const Topology *t = currentTopology();
+        Placed placed[NODE_MAX];
+        readPlaced(placed);
+        output("%d node%s%s, placement %s.\n", t->nodes, (t->nodes == 1) ? "" : "s",
+               t->simulated ? " (simulated)" : "", policies[macePlacement(ctx)]);
+        for (int k = 0; k < t->nodes; k++) {
+            output("\tnode %d: processors ", t->id[k]);
+            printCpus(t, k);
+            output(", %llu chunks local, %llu stolen\n", (unsigned long long)placed[k].local,
+                   (unsigned long long)placed[k].stolen);
+        }
+        return 0;
+    }
+
+    if (strcmp(argv[0].word, "reset") == 0) {
+        resetPlaced();
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof(policies) / sizeof(*policies); i++) {
+        if (strcmp(argv[0].word, policies[i]) == 0) {
+            maceSetPlacement(ctx, (Placement)i);
+            return 0;
+        }
+    }
+    output("Error: unknown placement: %s\n", argv[0].word);
+
+    return 0;
+}
+
+// Report counters recorded by the profile
+static void printProfile(Profile *profile) {
+    Counters counters[KERNEL_COUNT];
+    readProfile(profile, counters);
+    int hardware = hasCounters();
+
+    output("%-6s %7s %10s %9s %12s %6s %12s %10s\n", "kernel", "calls", "time (ms)",
+           "GFLOP/s", "cycles", "IPC", "LLC misses", "miss/kflop");
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        Counters *c = &counters[k];
+        if (!c->calls)
+            continue;
+
+        double ms = c->nanoseconds * 1e-6;
+        double gflops = c->nanoseconds ? (double)c->flops / c->nanoseconds : 0;
+        output("%-6s %7llu %10.3f %9.3f", kernelName(k), (unsigned long long)c->calls, ms,
+               gflops);
+        if (hardware && c->cycles) {
+            output(" %12llu %6.2f %12llu", (unsigned long long)c->cycles,
+                   (double)c->instructions / c->cycles, (unsigned long long)c->cacheMisses);
+            if (c->flops)
+                output(" %10.3f\n", 1e3 * c->cacheMisses / c->flops);
+            else
+                output(" %10s\n", "-");
+        } else {
+            output(" %12s %6s %12s %10s\n", "-", "-", "-", "-");
+        }
+    }
+
+    if (!hardware)
+        output("Hardware counters are unavailable; showing time and operation counts "
+               "only.\n");
+}
+
+static int profile(Context *ctx, int argc, Arg argv[]) {
+    // Report without parameters
+    if (!argc) {
+        if (!isProfiling(maceProfile(ctx)))
+            output("Profiling is off.\n");
+        if (maceProfile(ctx))
+            printProfile(maceProfile(ctx));
+        return 0;
+    }
+
+    const char *mode = argv[0].word;
+    if (strcmp(mode, "on") == 0) {
+        if (maceSetProfiling(ctx, 1))
+            output("Error: could not start profiling.\n");
+    } else if (strcmp(mode, "off") == 0) {
+        maceSetProfiling(ctx, 0);
+    } else if (strcmp(mode, "reset") == 0) {
+        if (maceProfile(ctx))
+            resetProfile(maceProfile(ctx));
+    } else {
+        output("Error: unknown profile mode: %s\n", mode);
+    }
+
+    return 0;
+}
+
+// Format a byte count in binary units
+static const char *formatBytes(size_t bytes, char buffer[16]) {
+    static const char *const units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    double size = bytes;
+    int unit = 0;
+    for (; size >= 1024 && unit < 4; unit++)
+        size /= 1024;
+    snprintf(buffer, 16, unit ? "%.1f %s" : "%.0f %s", size, units[unit]);
+    return buffer;
+}
+
+// Parse a byte count with an optional binary suffix, or none for no limit
+static int parseBytes(const char *word, size_t *bytes) {
+    if (strcmp(word, "none") == 0) {
+        *bytes = 0;
+        return 0;
+    }
+
+    char *end;
+    double size = strtod(word, &end);
+    const char *suffixes = "KMGT", *suffix = *end ? strchr(suffixes, toupper(*end)) : NULL;
+    if (end == word || size < 0 || (*end && (!suffix || end[1])))
+        return -1;
+    for (int i = suffix ? suffix - suffixes + 1 : 0; i > 0; i--)
+        size *= 1024;
+    *bytes = size;
+    return 0;
+}
+
+// Report the memory held by an entry
+static void printFootprint(Context *ctx, int id) {
+    Footprint f;
+    if (maceFootprint(ctx, id, &f))
+        return;
+
+    char matrix[16], cache[16], extra[16];
+    if (id == ANS)
+        output("\tMatAns %10s", formatBytes(f.matrix, matrix));
+    else
+        output("\tMat%c   %10s", id + 'A', formatBytes(f.matrix, matrix));
+    output("  cache %10s", formatBytes(f.cache, cache));
+    if (f.mapped)
+        output("  mapped %s", formatBytes(f.mapped, extra));
+    if (f.packed)
+        output("  packed %s", formatBytes(f.packed, extra));
+    if (f.shared)
+        output("  shared");
+    output("\n");
+}
+
+static int mem(Context *ctx, int argc, Arg argv[]) {
+    // Set budget with parameters
+    if (argc) {
+        size_t limit;
+        if (argc != 2 || strcmp(argv[0].word, "limit") != 0)
+            output("Error: unknown memory mode. Try mem limit <size>.\n");
+        else if (parseBytes(argv[1].word, &limit))
+            output("Error: invalid size: %s\n", argv[1].word);
+        else
+            maceSetBudget(ctx, limit);
+        return 0;
+    }
+
+    // Report every entry, then totals
+    size_t used, peak, limit;
+    char buffers[3][16];
+    maceMemory(ctx, &used, &peak, &limit);
+    output("\n");
+    for (int i = 0; i < maceSize(ctx); i++)
+        printFootprint(ctx, i);
+    printFootprint(ctx, ANS);
+    output("Used %s, peak %s, budget %s.\n\n", formatBytes(used, buffers[0]),
+           formatBytes(peak, buffers[1]), limit ? formatBytes(limit, buffers[2]) : "none");
+
+    return 0;
+}
+
+static int record(Context *ctx, int argc, Arg argv[]) {
+    // Stop without parameters
+    const char *path = recordingPath(ctx);
+    if (!argc) {
+        if (stopRecording(ctx))
+            output("Error: not recording.\n");
+        return 0;
+    }
+
+    if (path)
+        output("Error: already recording to %s.\n", path);
+    else if (startRecording(ctx, argv[0].word))
+        output("Error: could not open %s.\n", argv[0].word);
+
+    return 0;
+}
+
+static int replay(Context *ctx, int argc, Arg argv[]) {
+    if (replayJournal(ctx, argv[0].word))
+        output("Error: could not open %s.\n", argv[0].word);
+
+    return 0;
+}
+
+static int jobs(Context *ctx, int argc, Arg argv[]) {
+    listJobs(ctx);
+    return 0;
+}
+
+static int wait(Context *ctx, int argc, Arg argv[]) {
+    if (waitJob(ctx, argc ? argv[0].count : 0))
+        output("Error: no job with id %d.\n", argv[0].count);
+
+    return 0;
+}
+
+static int cancel(Context *ctx, int argc, Arg argv[]) {
+    if (cancelJob(ctx, argv[0].count))
+        output("Error: no job with id %d.\n", argv[0].count);
+
+    return 0;
+}
+
+// -- Registry --
+// clang-format off
+static const Command builtins[] = {
+    {"help", help, "w?",
+     "Get help using Mace.",
+     "Display help menu for Mace commands.\n"
+     "\t- Call without parameters for quick help menu.\n"
+     "\t- Command name parameters specify individual command help menu.",
+     "string command (optional)",
+     "help mat",
+     EFFECT_PRINT},
+    {"bye", bye, "",
+     "Quit program.",
+     "Quit the current Mace session. Closes program.",
+     NULL,
+     NULL},
+    {"print", print, "m*",
+     "Print a matrix in the workspace.",
+     "Print all or some matricies from the workspace.",
+     "string matrix identifier(s) (optional)",
+     "print A B\n"
+     "print c ans",
+     EFFECT_PRINT},
+    {"clr", clr, "",
+     "Clear the workspace.",
+     "Clear all saved variables (including ans) from the workspace.",
+     NULL,
+     NULL,
+     EFFECT_CLEAR},
+    {"mat", mat, "s",
+     "Make a new matrix.",
+     "Save a matrix to the workspace.\n"
+     "\t- Dimensions are inferred from data.\n"
+     "\t- Individual items sepeerated by space, semicolons as row-terminators.\n"
+     "\t- Save the most recent output with parameter ans.",
+     "decimal data (or ans)",
+     "mat 1 2; 3 4\n"
+     "mat ans",
+     EFFECT_CREATE},
+    {"load", load, "w",
+     "Load a matrix from a file.",
+     "Save a matrix read from a text file to the workspace.\n"
+     "\t- Rows are separated by newlines or semicolons, and items by spaces, "
+     "tabs or commas.\n"
+     "\t- Blank lines are skipped, and dimensions are inferred from data.",
+     "string file path",
+     "load data.txt",
+     EFFECT_CREATE},
+    {"share", share, "mw",
+     "Share a matrix with other sessions.",
+     "Publish a matrix from the workspace under a name in shared memory.\n"
+     "\t- Other sessions and processes can attach it without copying.\n"
+     "\t- Names may only contain letters, digits, and _-.",
+     "string matrix identifier, string name",
+     "share A weights"},
+    {"attach", attach, "w",
+     "Attach a shared matrix.",
+     "Save a shared matrix to the workspace without copying it.\n"
+     "\t- Pages are copy-on-write: changes are never seen by other sessions.",
+     "string name",
+     "attach weights",
+     EFFECT_CREATE},
+    {"unshare", unshare, "w",
+     "Remove a shared matrix name.",
+     "Remove a name published with share.\n"
+     "\t- Sessions that already attached the matrix keep their copy.",
+     "string name",
+     "unshare weights"},
+    {"checkpoint", checkpoint, "ww?",
+     "Save the workspace to a file.",
+     "Write every matrix in the workspace, and ans, to a checkpoint file.\n"
+     "\t- Pass compress to pack matrices, which suits sparse or repetitive data.\n"
+     "\t- The file is replaced only once it is complete.",
+     "string file, string compress (optional)",
+     "checkpoint session.ckpt\n"
+     "checkpoint session.ckpt compress"},
+    {"restore", restore, "w",
+     "Restore the workspace from a file.",
+     "Replace the workspace, and ans, with those saved by checkpoint.\n"
+     "\t- Matrices are mapped from the file, and only read when used.\n"
+     "\t- Compressed matrices are unpacked on first use.",
+     "string file",
+     "restore session.ckpt"},
+    {"struct", structure, "m",
+     "Describe the structure of a matrix.",
+     "Report whether a matrix is diagonal, triangular, banded or dense, and "
+     "whether it is symmetric.\n"
+     "\t- Bandwidths count the diagonals holding nonzero entries below and "
+     "above the main diagonal.\n"
+     "\t- Operations use structure to skip entries known to be zero.",
+     "string matrix identifier",
+     "struct A",
+     EFFECT_PRINT},
+    {"ident", ident, "i",
+     "Make an identity matrix.",
+     "Save the identity matrix sized nxn to the workspace.",
+     "integer n",
+     "ident 3",
+     EFFECT_CREATE},
+    {"zeros", zeros, "ii",
+     "Make an empty matrix of zeros.",
+     "Save an empty matrix of zeros sized mxn to the workspace.",
+     "integer m, n",
+     "zeros 3 4",
+     EFFECT_CREATE},
+    {"set", set, "miin",
+     "Set an element of a matrix.",
+     "Overwrite the element at row i, column j of a matrix in place.\n"
+     "\t- Rows and columns are numbered from 1.\n"
+     "\t- Cached factors, inverse and determinant are updated rather than "
+     "recomputed.",
+     "string matrix identifier, integer i, j, decimal value",
+     "set A 2 1 5\n"
+     "set ans 1 1 0"},
+    {"setrow", setrow, "mim",
+     "Set a row of a matrix.",
+     "Overwrite row i of a matrix in place with the entries of a vector.\n"
+     "\t- Rows are numbered from 1.\n"
+     "\t- Cached factors, inverse and determinant are updated rather than "
+     "recomputed.",
+     "string matrix identifier, integer i, string vector identifier",
+     "setrow A 2 B"},
+    {"setcol", setcol, "mim",
+     "Set a column of a matrix.",
+     "Overwrite column j of a matrix in place with the entries of a vector.\n"
+     "\t- Columns are numbered from 1.\n"
+     "\t- Cached factors, inverse and determinant are updated rather than "
+     "recomputed.",
+     "string matrix identifier, integer j, string vector identifier",
+     "setcol A 3 C"},
+    {"update", update, "mmm",
+     "Add an outer product to a matrix.",
+     "Add the outer product of vectors u and v to a matrix in place (A = A + uv').\n"
+     "\t- Cached factors, inverse and determinant are updated rather than "
+     "recomputed.",
+     "string matrix identifier, 2 string vector identifiers",
+     "update A B C"},
+    {"add", add, "mm",
+     "Add two matricies.",
+     "Perform matrix addition on two matricies from the workspace.",
+     "2 string matrix identifiers",
+     "add MatA MatB\n"
+     "add ans C",
+     EFFECT_ANS},
+    {"sub", sub, "mm",
+     "Subtract two matricies.",
+     "Perform matrix subtraction on two matricies from the workspace.",
+     "2 string matrix identifiers",
+     "sub d e\n"
+     "sub MatF MatAns",
+     EFFECT_ANS},
+    {"map", map, "e",
+     "Evaluate an elementwise expression.",
+     "Evaluate an expression on matrices entry by entry, in a single pass.\n"
+     "\t- Operators: + - * / (elementwise), and < > == (1 where true, "
+     "else 0).\n"
+     "\t- Functions: abs, exp, log, sqrt, min(x, y), max(x, y).\n"
+     "\t- Matrices with a single row or column are repeated to match the "
+     "others, and 1x1 matrices act as numbers.",
+     "expression of numbers and string matrix identifiers",
+     "map a * b + 1\n"
+     "map exp(-abs(a)) / (a > 0)\n"
+     "map (a - b) / c",
+     EFFECT_ANS},
+    {"mul", mul, "mm",
+     "Multiply two matricies.",
+     "Perform matrix multiplication on two matricies from the workspace.",
+     "2 string matrix identifiers",
+     "mul a b\n"
+     "mul C ans",
+     EFFECT_ANS},
+    {"kron", kron, "mmm?",
+     "Find the Kronecker product of two matricies.",
+     "Replace each entry of the first matrix with that entry times the "
+     "second matrix.\n"
+     "\t- A third matrix is multiplied by the product, without forming "
+     "it. Its rows must number the product's columns.",
+     "2 string matrix identifiers, string matrix identifier (optional)",
+     "kron a b\n"
+     "kron a b x",
+     EFFECT_ANS},
+    {"hadamard", hadamard, "mm",
+     "Multiply two matricies elementwise.",
+     "Find the Hadamard product of two matricies of the same dimensions.",
+     "2 string matrix identifiers",
+     "hadamard a b",
+     EFFECT_ANS},
+    {"outer", outer, "mm",
+     "Find the outer product of two vectors.",
+     "Multiply each entry of the first vector by every entry of the second, "
+     "as rows and columns of the result.\n"
+     "\t- Vectors may be rows or columns.",
+     "2 string matrix identifiers",
+     "outer u v",
+     EFFECT_ANS},
+    {"scl", scl, "nm",
+     "Multiply a matrix by a scalar coefficient.",
+     "Perform scalar multiplication on a matrix the workspace.",
+     "double scalar, string matrix identifier",
+     "scl -1.2 MatB\n"
+     "scl 5 ans",
+     EFFECT_ANS},
+    {"trnsp", trnsp, "m",
+     "Find the transpose of a matrix.",
+     "Calculate the trnspose of a matrix from the workspace.",
+     "string matrix identifier",
+     "trnsp c\n"
+     "trnsp ans",
+     EFFECT_ANS},
+    {"inv", inv, "m",
+     "Find the inverse of a matrix.",
+     "Calculate the inverse of a matrix from the workspace.",
+     "string matrix identifier",
+     "inv D\n"
+     "inv ans",
+     EFFECT_ANS},
+    {"solve", solve, "mm",
+     "Solve a linear system.",
+     "Find X such that AX = B, for a square matrix A from the workspace.\n"
+     "\t- Factors of A are cached, so solving again with A is cheaper.\n"
+     "\t- Diagonal, triangular, banded and symmetric matrices are solved "
+     "within their structure.",
+     "2 string matrix identifiers",
+     "solve A B\n"
+     "solve A ans",
+     EFFECT_ANS},
+    {"cg", cg, "mmw*",
+     "Solve a symmetric positive definite system iteratively.",
+     "Find X such that AX = B by conjugate gradients, for a symmetric "
+     "positive definite matrix A, and report the iterations and time "
+     "taken.\n"
+     "\t- tol=: relative residual to stop at (default 1e-8).\n"
+     "\t- iter=: iteration limit per column of B (default 1000).\n"
+     "\t- pre=: preconditioner, one of none (default), jacobi or ilu.\n"
+     "\t- Only the band of A is used, so banded systems solve quickly.",
+     "2 string matrix identifiers, string options (optional)",
+     "cg A b\n"
+     "cg A b tol=1e-12 pre=jacobi",
+     EFFECT_ANS},
+    {"gmres", gmres, "mmw*",
+     "Solve a linear system iteratively.",
+     "Find X such that AX = B by restarted GMRES, for any square matrix A, "
+     "and report the iterations and time taken.\n"
+     "\t- tol=, iter= and pre= are as for cg.\n"
+     "\t- restart=: iterations between restarts (default 30). More "
+     "converge in fewer iterations, but use more memory.",
+     "2 string matrix identifiers, string options (optional)",
+     "gmres A b\n"
+     "gmres A b restart=50 pre=ilu",
+     EFFECT_ANS},
+    {"det", det, "m",
+     "Find the determinant of a matrix.",
+     "Calculate the determinant of a matrix from the workspace.",
+     "string matrix identifier",
+     "det A\n"
+     "det ans",
+     EFFECT_ANS},
+    {"trc", trc, "m",
+     "Find the trace of a matrix.",
+     "Calculate the trace of a matrix from the workspace.",
+     "string matrix identifier",
+     "trc b\n"
+     "trc ans",
+     EFFECT_ANS},
+    {"cond", cond, "m",
+     "Estimate condition number.",
+     "Estimate the condition number of a matrix in the 1-norm.\n"
+     "\t- Estimated from its LU factors, without computing the inverse.\n"
+     "\t- Matrices with condition near 1/eps (4.5e15) or above cannot be "
+     "inverted.",
+     "string matrix identifier",
+     "cond a",
+     EFFECT_ANS},
+    {"sum", sum, "mw?",
+     "Sum entries.",
+     "Sum the entries of a matrix from the workspace.\n"
+     "\t- rows: sum each row, to a column.\n"
+     "\t- cols: sum each column, to a row.\n"
+     "\t- all: sum every entry (default).",
+     "string matrix identifier, string axis (optional)",
+     "sum a\n"
+     "sum a cols",
+     EFFECT_ANS},
+    {"mean", mean, "mw?",
+     "Average entries.",
+     "Find the mean of the entries of a matrix from the workspace.\n"
+     "\t- Takes an optional axis, as for sum.",
+     "string matrix identifier, string axis (optional)",
+     "mean a\n"
+     "mean a rows",
+     EFFECT_ANS},
+    {"min", min, "mw?",
+     "Find smallest entry.",
+     "Find the smallest entry of a matrix from the workspace.\n"
+     "\t- Takes an optional axis, as for sum.\n"
+     "\t- NaN entries are ignored.",
+     "string matrix identifier, string axis (optional)",
+     "min a\n"
+     "min a cols",
+     EFFECT_ANS},
+    {"max", max, "mw?",
+     "Find largest entry.",
+     "Find the largest entry of a matrix from the workspace.\n"
+     "\t- Takes an optional axis, as for sum.\n"
+     "\t- NaN entries are ignored.",
+     "string matrix identifier, string axis (optional)",
+     "max a\n"
+     "max a rows",
+     EFFECT_ANS},
+    {"reduce", reduce, "mw*",
+     "Find several reductions at once.",
+     "Find any of sum, mean, min and max of a matrix in a single pass.\n"
+     "\t- Results hold one reduction per column, in that order, or per "
+     "row when reducing columns.\n"
+     "\t- Takes an optional axis, as for sum.\n"
+     "\t- Call without reductions to find all of them.",
+     "string matrix identifier, string reduction(s) and axis (optional)",
+     "reduce a\n"
+     "reduce a min max cols",
+     EFFECT_ANS},
+    {"norm", norm, "mw*",
+     "Find matrix norms.",
+     "Find any of the 1, inf, fro (Frobenius) and max norms of a matrix in "
+     "a single pass.\n"
+     "\t- Results hold one norm per column, in that order.\n"
+     "\t- With an axis, each row or column is normed as a vector, one per "
+     "row or column of the result.\n"
+     "\t- Call without norms to find the Frobenius norm.",
+     "string matrix identifier, string norm(s) and axis (optional)",
+     "norm a\n"
+     "norm a 1 inf\n"
+     "norm a fro rows",
+     EFFECT_ANS},
+    {"batch", batch, "wmm?",
+     "Operate on a stack of matrices.",
+     "Perform an operation on every matrix in a stack.\n"
+     "\t- A stack is a matrix of square blocks stacked vertically,\n"
+     "\t  loaded like any other matrix (e.g. with mat).\n"
+     "\t- Operations: mul (pairwise product), inv, det.\n"
+     "\t- Blocks singular to working precision are inverted to NaN.",
+     "string operation, string matrix identifier(s)",
+     "batch mul A B\n"
+     "batch det ans",
+     EFFECT_ANS},
+    {"precision", precision, "w?",
+     "Set arithmetic precision.",
+     "Choose how sums and factorizations are computed.\n"
+     "\t- fast: accumulate sums directly (default).\n"
+     "\t- compensated: track rounding error in sums and dot products, and "
+     "factorize with pivoting in place of cofactor expansion. Slower, but "
+     "accurate on ill-conditioned data.\n"
+     "\t- Call without parameters to show the current precision.",
+     "string mode (optional)",
+     "precision compensated\n"
+     "precision"},
+    {"numa", numa, "w?",
+     "Place memory and work on NUMA nodes.",
+     "Choose how large matrices are placed across the nodes of the "
+     "machine. Work on their rows is split between nodes in the same way.\n"
+     "\t- local: place rows on the node that first touches them, which "
+     "processes them later (default).\n"
+     "\t- interleave: spread pages across every node in turn.\n"
+     "\t- reset: discard counts of chunks run on each node.\n"
+     "\t- Call without parameters to show the topology, and how many chunks "
+     "each node ran of its own, or took from others once idle.\n"
+     "\t- Set MACE_NUMA to a node count, or nodes x processors per node, "
+     "to simulate a topology.",
+     "string mode (optional)",
+     "numa interleave\n"
+     "numa"},
+    {"profile", profile, "w?",
+     "Profile kernels.",
+     "Record time, operation counts and hardware counters for the kernels "
+     "run by each command.\n"
+     "\t- on, off: start or stop recording.\n"
+     "\t- reset: discard recorded counters.\n"
+     "\t- Call without parameters to report counters per kernel. Kernels "
+     "include the kernels they call.\n"
+     "\t- Few flops per cycle, and many LLC misses per kflop, indicate a "
+     "memory-bound kernel.",
+     "string mode (optional)",
+     "profile on\n"
+     "mul a a\n"
+     "profile"},
+    {"mem", mem, "w*",
+     "Report memory use.",
+     "List the memory held by each matrix and its cached results, and the "
+     "memory used by the workspace against its budget.\n"
+     "\t- limit: set the budget, in bytes with an optional K, M, G or T "
+     "suffix, or none. Defaults to physical memory.\n"
+     "\t- Operations whose results would exceed the budget fail, leaving "
+     "the workspace unchanged.\n"
+     "\t- Mapped matrices live in shared segments or checkpoints, packed "
+     "ones are compressed until used, and shared ones are also held by jobs.",
+     "string limit, string size (optional)",
+     "mem limit 512M\n"
+     "mem"},
+    {"record", record, "w?",
+     "Record commands to a journal.",
+     "Append every command run from now on to a journal, with when it "
+     "started and how long it took.\n"
+     "\t- Call without parameters to stop recording.\n"
+     "\t- Journals are scripts, and may be run like any other.",
+     "string file path (optional)",
+     "record session.mace\n"
+     "record"},
+    {"replay", replay, "w",
+     "Replay a journal.",
+     "Run the commands of a journal one at a time, discarding their output, "
+     "and report how long they took.\n"
+     "\t- Commands furthest over their recorded time are listed.\n"
+     "\t- Jobs started by the journal are waited for.",
+     "string file path",
+     "replay session.mace"},
+    {"jobs", jobs, "",
+     "List background jobs.",
+     "List jobs started by ending a command with &.\n"
+     "\t- Jobs operate on a snapshot of the workspace taken when started.\n"
+     "\t- The result of a finished job replaces ans when it is reported.",
+     NULL,
+     "inv A &\n"
+     "jobs"},
+    {"wait", wait, "i?",
+     "Wait for background jobs.",
+     "Wait for a job to finish, and report its output.\n"
+     "\t- Call without parameters to wait for every job.",
+     "integer job id (optional)",
+     "wait 1\n"
+     "wait"},
+    {"cancel", cancel, "i",
+     "Cancel a background job.",
+     "Stop a running job. Its result is discarded.",
+     "integer job id",
+     "cancel 1"},
+};
+// clang-format on
+
+void registerBuiltins(void) {
+    for (size_t i = 0; i < sizeof(builtins) / sizeof(Command); i++)
+        registerCommand(&builtins[i]);
+}
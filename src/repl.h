@@ -0,0 +1,27 @@
+// File:        repl.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     25 Apr 2019
+// SPDX-License-Identifier: NONE
+
+#ifndef REPL_H
+#define REPL_H
+
+#include <stdio.h>
+
+#include "mace/mace.h"
+
+#define MAX 100
+
+// Function prototypes
+void mace(void);
+void registerBuiltins(void);
+// Secondary functions
+FILE *useOutput(FILE *);
+FILE *currentOutput(void);
+void output(const char *, ...);
+void printMat(Matrix);
+void printEntry(Context *, int);
+void printAns(Context *);
+void printError(Status);
+
+#endif
@@ -0,0 +1,520 @@
+// File:        script.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "script.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "command.h"
+#include "mace/mace.h"
+#include "repl.h"
+
+// Scripts are split into one node per line, and each node waits only on
+// the nodes whose matrices it reads, or whose reads its new matrix would
+// change. Every replacement of ans is renamed to a version held by the node
+// producing it, so commands replacing ans never wait on each other.
+//
+// Nodes run on forks of the workspace, scheduled on per-worker deques with
+// work stealing. Matrices they create are adopted in script order, and
+// their output is printed in script order. Commands with unknown effects
+// run alone, directly on the workspace.
+
+// Declare line structure
+typedef struct line {
+    char text[MAX];
+    int number;  // in the script, from one
+    int tooLong; // whether the text was dropped
+} Line;
+
+// Declare node structure
+typedef struct node {
+    char input[MAX];
+    const Line *line;
+    int effects;
+    int readsAns;
+    int version;  // node holding ans read (or -1 for the workspace)
+    int *next;    // successors
+    int count, capacity;
+    atomic_int waiting; // unfinished predecessors
+    Context *fork;      // holds ans produced by the node
+    atomic_int holds;   // self, final ans, and each reader
+    int released;       // whether final hold was released
+    int answered;       // whether ans was replaced
+    int done;
+    char *output; // captured output
+    size_t size;
+} Node;
+
+// Declare deque structure
+typedef struct deque {
+    pthread_mutex_t lock;
+    int *items;
+    int top, bottom;
+} Deque;
+
+// Declare script structure
+typedef struct script {
+    Context *ctx;
+    Node *nodes;
+    int count;
+    Deque *deques;
+    int workers;
+    atomic_int joined; // workers started
+    atomic_int refs;   // caller and helpers
+    atomic_int ready;  // nodes waiting in deques
+    atomic_int stop;   // last line to run
+    atomic_int quit;   // whether stopped by a command
+    pthread_mutex_t lock; // guards ctx, remaining, and printing
+    pthread_cond_t wake;
+    int remaining;
+    int printed; // nodes printed so far
+    int current; // version of ans after printed nodes
+    FILE *out;
+} Script;
+
+// -- Dependency graph --
+static void addEdge(Script *script, int from, int to) {
+    if (from < 0 || from == to)
+        return;
+
+    Node *node = &script->nodes[from];
+    if (node->count == node->capacity) {
+        node->capacity = node->capacity ? 2 * node->capacity : 4;
+        node->next = realloc(node->next, node->capacity * sizeof(int));
+    }
+    node->next[node->count++] = to;
+    atomic_fetch_add(&script->nodes[to].waiting, 1);
+}
+
+// Append an index to a list
+static void push(int **list, int *len, int index) {
+    *list = realloc(*list, (*len + 1) * sizeof(int));
+    (*list)[(*len)++] = index;
+}
+
+static void analyze(Script *script) {
+    // Node creating each slot, while the workspace size is known
+    int creator[WORKSPACE_SIZE];
+    for (int k = 0; k < WORKSPACE_SIZE; k++)
+        creator[k] = -1;
+    int size = maceSize(script->ctx), sized = 1;
+
+    int barrier = -1, resized = -1, version = -1, reader = -1;
+    int *since = NULL, nsince = 0;     // nodes since last barrier
+    int *creates = NULL, ncreates = 0; // creates since last barrier
+    int *readers = NULL, nreaders = 0; // reads of missing matrices since last create
+    int *writers = NULL, nwriters = 0; // replacements of ans since last read
+
+    for (int i = 0; i < script->count; i++) {
+        Node *node = &script->nodes[i];
+
+        // Classify command
+        char copy[MAX], *save;
+        strcpy(copy, node->input);
+        char *name = strtok_r(copy, " \n", &save);
+        char *args = strtok_r(NULL, "\n", &save);
+        const Command *cmd = name ? findCommand(name) : NULL;
+        int ids[MAX_ARGS], nids = 0;
+        if (!cmd) {
+            node->effects = EFFECT_PRINT; // blank or invalid
+        } else if (args && strchr(args, '&')) {
+            node->effects = EFFECT_ANY; // starts a job
+        } else {
+            node->effects = cmd->effects;
+            nids = operands(cmd, args, ids);
+        }
+        int alone = (node->effects == EFFECT_ANY || node->effects == EFFECT_CLEAR);
+        node->version = version;
+
+        // Reading ans waits on every replacement since the last read, as
+        // failed replacements leave an earlier version in place
+        int readsAns = alone || (nids < 0);
+        for (int n = 0; n < nids; n++)
+            readsAns |= (ids[n] == ANS);
+        if (readsAns) {
+            node->readsAns = 1;
+            for (int j = 0; j < nwriters; j++)
+                addEdge(script, writers[j], i);
+            addEdge(script, reader, i);
+            nwriters = 0;
+            reader = i;
+        }
+
+        // Run after every earlier node, and before every later one
+        addEdge(script, barrier, i);
+        if (alone) {
+            for (int j = 0; j < nsince; j++)
+                addEdge(script, since[j], i);
+
+            barrier = resized = i;
+            version = reader = -1;
+            nsince = ncreates = nreaders = 0;
+            sized = (node->effects == EFFECT_CLEAR);
+            size = 0;
+            for (int k = 0; k < WORKSPACE_SIZE; k++)
+                creator[k] = -1;
+            continue;
+        }
+
+        // Wait on creators of every matrix read
+        int missing = (nids < 0) || !sized;
+        for (int n = 0; n < ((nids < 0) ? size : nids); n++) {
+            int id = (nids < 0) ? n : ids[n];
+            if (id == ANS)
+                continue;
+            if (sized && id < size)
+                addEdge(script, creator[id], i);
+            missing |= (id >= size);
+        }
+        if (!sized) {
+            for (int j = 0; j < ncreates; j++)
+                addEdge(script, creates[j], i);
+        }
+
+        // Reads of missing matrices must not observe later creates
+        if (missing)
+            push(&readers, &nreaders, i);
+
+        // Creates are ordered, and wait on reads of missing matrices
+        if (node->effects == EFFECT_CREATE) {
+            addEdge(script, resized, i);
+            for (int j = 0; j < nreaders; j++)
+                addEdge(script, readers[j], i);
+            nreaders = 0;
+            resized = i;
+            if (sized && size < WORKSPACE_SIZE)
+                creator[size++] = i;
+            push(&creates, &ncreates, i);
+        } else if (node->effects == EFFECT_ANS) {
+            version = i; // rename ans
+            push(&writers, &nwriters, i);
+        }
+
+        push(&since, &nsince, i);
+    }
+
+    free(since);
+    free(creates);
+    free(readers);
+    free(writers);
+}
+
+// -- Ans versions --
+static void releaseHold(Script *script, int index) {
+    if (index < 0)
+        return;
+
+    // Last hold deletes the fork holding the version
+    Node *node = &script->nodes[index];
+    if (atomic_fetch_sub(&node->holds, 1) == 1 && node->fork) {
+        deleteContext(node->fork);
+        node->fork = NULL;
+    }
+}
+
+// Resolve the version of ans a node reads, skipping failed replacements
+static int resolve(Script *script, int version) {
+    while (version >= 0 && !script->nodes[version].answered)
+        version = script->nodes[version].version;
+    return version;
+}
+
+static void releaseFinal(Script *script, int index) {
+    if (index >= 0 && !script->nodes[index].released) {
+        script->nodes[index].released = 1;
+        releaseHold(script, index);
+    }
+}
+
+// Print finished nodes in order, with the script lock held
+static void flush(Script *script) {
+    while (script->printed < script->count && script->printed <= atomic_load(&script->stop)) {
+        int index = script->printed;
+        Node *node = &script->nodes[index];
+        if (!node->done)
+            break;
+
+        if (node->output)
+            fwrite(node->output, 1, node->size, script->out);
+
+        // Versions superseded in order are no longer needed for the end
+        if (node->effects == EFFECT_ANS && node->answered) {
+            releaseFinal(script, script->current);
+            script->current = index;
+        } else if (node->effects == EFFECT_ANS) {
+            releaseFinal(script, index);
+        } else if (node->effects == EFFECT_ANY || node->effects == EFFECT_CLEAR) {
+            releaseFinal(script, script->current);
+            script->current = -1;
+        }
+        script->printed++;
+    }
+}
+
+// -- Scheduler --
+static void pushNode(Script *script, int worker, int index) {
+    Deque *deque = &script->deques[worker];
+    pthread_mutex_lock(&deque->lock);
+    deque->items[deque->bottom++] = index;
+    pthread_mutex_unlock(&deque->lock);
+
+    atomic_fetch_add(&script->ready, 1);
+}
+
+// Take newest node from own deque, or oldest from another worker's
+static int takeNode(Script *script, int worker) {
+    for (int n = 0; n < script->workers; n++) {
+        Deque *deque = &script->deques[(worker + n) % script->workers];
+        int index = -1;
+
+        pthread_mutex_lock(&deque->lock);
+        if (deque->bottom > deque->top)
+            index = (n == 0) ? deque->items[--deque->bottom] : deque->items[deque->top++];
+        pthread_mutex_unlock(&deque->lock);
+
+        if (index >= 0) {
+            atomic_fetch_sub(&script->ready, 1);
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+static void runNode(Script *script, int worker, int index) {
+    Node *node = &script->nodes[index];
+    int skip = (index > atomic_load(&script->stop));
+    int alone = (node->effects == EFFECT_ANY || node->effects == EFFECT_CLEAR);
+    Context *ctx = NULL;
+
+    // Start from the version of ans read
+    int version = node->readsAns ? resolve(script, node->version) : -1;
+    if (!skip && alone) {
+        ctx = script->ctx; // every other node is finished
+        if (version >= 0)
+            maceBorrowAns(ctx, script->nodes[version].fork);
+    } else if (!skip) {
+        pthread_mutex_lock(&script->lock);
+        ctx = maceFork(script->ctx);
+        pthread_mutex_unlock(&script->lock);
+        if (ctx && version >= 0)
+            maceBorrowAns(ctx, script->nodes[version].fork);
+    }
+    if (node->readsAns)
+        releaseHold(script, node->version);
+
+    if (ctx) {
+        char input[MAX];
+        strcpy(input, node->input); // execute splits its input in place
+
+        // Capture output of command
+        FILE *out = open_memstream(&node->output, &node->size);
+        FILE *previous = useOutput(out);
+        int size = maceSize(ctx);
+        Matrix before = NULL_MATRIX, after = NULL_MATRIX;
+        maceGet(ctx, ANS, &before);
+        int quit = 0;
+        if (node->line->tooLong)
+            output("Error: line %d is too long.\n", node->line->number);
+        else
+            quit = execute(ctx, input);
+        maceGet(ctx, ANS, &after);
+        node->answered = (after.data != before.data);
+
+        useOutput(previous);
+        if (out)
+            fclose(out);
+
+        // Stop once a create fails, as later identifiers would shift, and
+        // rerun the rest of the script from there
+        int failed = (node->effects == EFFECT_CREATE && maceSize(ctx) != size + 1);
+        if (quit)
+            atomic_store(&script->quit, 1);
+        if (failed || quit) {
+            int stop = atomic_load(&script->stop);
+            while (index < stop && !atomic_compare_exchange_weak(&script->stop, &stop, index))
+                ;
+        }
+
+        // Keep quantities derived by every fork, such as factors
+        if (!alone) {
+            pthread_mutex_lock(&script->lock);
+            if (node->effects == EFFECT_CREATE && !failed)
+                maceAdopt(script->ctx, ctx); // matrix keeps its slot
+            else
+                maceAdoptCaches(script->ctx, ctx);
+            pthread_mutex_unlock(&script->lock);
+        }
+        if (node->effects == EFFECT_ANS) {
+            node->fork = ctx; // keep version of ans
+        } else if (!alone) {
+            deleteContext(ctx);
+        }
+    }
+    releaseHold(script, index); // self
+
+    // Print in order, and release successors
+    pthread_mutex_lock(&script->lock);
+    node->done = 1;
+    flush(script);
+    for (int n = 0; n < node->count; n++) {
+        if (atomic_fetch_sub(&script->nodes[node->next[n]].waiting, 1) == 1)
+            pushNode(script, worker, node->next[n]);
+    }
+    if (--script->remaining == 0 || node->count)
+        pthread_cond_broadcast(&script->wake);
+    pthread_mutex_unlock(&script->lock);
+}
+
+static void work(Script *script, int worker) {
+    while (1) {
+        int index = takeNode(script, worker);
+        if (index >= 0) {
+            runNode(script, worker, index);
+            continue;
+        }
+
+        // Sleep until nodes are ready, or the script is finished
+        pthread_mutex_lock(&script->lock);
+        while (!atomic_load(&script->ready) && script->remaining)
+            pthread_cond_wait(&script->wake, &script->lock);
+        int finished = !script->remaining;
+        pthread_mutex_unlock(&script->lock);
+
+        if (finished)
+            return;
+    }
+}
+
+static void releaseScript(Script *script) {
+    // Last reference frees the script
+    if (atomic_fetch_sub(&script->refs, 1) != 1)
+        return;
+
+    for (int i = 0; i < script->count; i++) {
+        free(script->nodes[i].next);
+        free(script->nodes[i].output);
+    }
+    for (int w = 0; w < script->workers; w++) {
+        pthread_mutex_destroy(&script->deques[w].lock);
+        free(script->deques[w].items);
+    }
+    pthread_cond_destroy(&script->wake);
+    pthread_mutex_destroy(&script->lock);
+    free(script->deques);
+    free(script->nodes);
+    free(script);
+}
+
+static void helper(void *arg) {
+    Script *script = arg;
+    work(script, atomic_fetch_add(&script->joined, 1));
+    releaseScript(script);
+}
+
+// -- Runner --
+// Run lines until one changes the meaning of those after it, returning the
+// number of lines run
+static int runLines(Context *ctx, const Line *lines, int count, int *quit) {
+    Script *script = calloc(1, sizeof(Script));
+    script->ctx = ctx;
+    script->count = count;
+    script->nodes = calloc(count, sizeof(Node));
+    for (int i = 0; i < count; i++) {
+        strcpy(script->nodes[i].input, lines[i].text);
+        script->nodes[i].line = &lines[i];
+    }
+
+    // Build dependency graph
+    analyze(script);
+    for (int i = 0; i < count; i++) {
+        Node *node = &script->nodes[i];
+        atomic_fetch_add(&node->holds, (node->effects == EFFECT_ANS) ? 2 : 1);
+        if (node->readsAns && node->version >= 0)
+            atomic_fetch_add(&script->nodes[node->version].holds, 1);
+    }
+
+    // Create a deque per worker, including the caller
+    Pool *pool = currentPool();
+    script->workers = poolSize(pool) + 1;
+    script->deques = calloc(script->workers, sizeof(Deque));
+    for (int w = 0; w < script->workers; w++) {
+        pthread_mutex_init(&script->deques[w].lock, NULL);
+        script->deques[w].items = malloc(count * sizeof(int));
+    }
+    pthread_mutex_init(&script->lock, NULL);
+    pthread_cond_init(&script->wake, NULL);
+    script->remaining = count;
+    script->current = -1;
+    script->out = currentOutput();
+    atomic_init(&script->stop, count - 1);
+    atomic_init(&script->joined, 1);
+    atomic_init(&script->refs, script->workers);
+
+    // Seed caller with nodes that are ready
+    for (int i = 0; i < count; i++) {
+        if (!atomic_load(&script->nodes[i].waiting))
+            pushNode(script, 0, i);
+    }
+
+    // Run on pool, with caller participating
+    for (int w = 1; w < script->workers; w++)
+        poolSubmit(pool, helper, script);
+    work(script, 0);
+
+    // Publish the version of ans where the script stopped
+    if (script->current >= 0)
+        maceBorrowAns(ctx, script->nodes[script->current].fork);
+    for (int i = 0; i < count; i++) {
+        if (script->nodes[i].effects == EFFECT_ANS)
+            releaseFinal(script, i);
+    }
+    fflush(script->out);
+
+    int run = atomic_load(&script->stop) + 1;
+    *quit = atomic_load(&script->quit);
+    releaseScript(script);
+    return run;
+}
+
+int runScript(Context *ctx, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: could not open %s.\n", path);
+        return 1;
+    }
+
+    // Read lines
+    Line *lines = NULL;
+    int count = 0;
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t len;
+    while ((len = getline(&line, &capacity, file)) >= 0) {
+        lines = realloc(lines, (count + 1) * sizeof(*lines));
+
+        // Flag overlong lines, which run as blank lines
+        lines[count] = (Line){.number = count + 1, .tooLong = (len >= MAX)};
+        if (!lines[count].tooLong)
+            strcpy(lines[count].text, line);
+        count++;
+    }
+    free(line);
+    fclose(file);
+
+    // Run until the end, or a command quits
+    int quit = 0;
+    for (int start = 0; start < count && !quit;)
+        start += runLines(ctx, lines + start, count - start, &quit);
+
+    free(lines);
+    return 0;
+}
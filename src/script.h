@@ -0,0 +1,14 @@
+// File:        script.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include "mace/mace.h"
+
+// Function prototypes
+int runScript(Context *, const char *);
+
+#endif
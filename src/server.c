@@ -0,0 +1,325 @@
+// File:        server.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "command.h"
+#include "job.h"
+#include "journal.h"
+#include "mace/mace.h"
+#include "repl.h"
+
+// Declare session structure
+typedef struct session {
+    int fd;
+    Context *ctx; // per-session workspace
+    pthread_mutex_t lock;
+    char buffer[BUFFER_SIZE]; // unprocessed input
+    size_t len;
+    int busy;   // commands running on the pool
+    int paused; // reading stopped while buffer is full
+    int skip;   // discarding the rest of an overlong line
+    int hungup; // connection dropped by event loop
+    struct session *prev, *next;
+} Session;
+
+// Event loop state
+static int epfd;
+static volatile sig_atomic_t running;
+static Session *sessions; // owned by event loop
+
+// Live session count, for draining at shutdown
+static pthread_mutex_t liveLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t drained = PTHREAD_COND_INITIALIZER;
+static int live;
+
+static void stop(int signum) {
+    running = 0;
+}
+
+static void deleteSession(Session *s) {
+    stopRecording(s->ctx);
+    stopJobs(s->ctx);
+    close(s->fd);
+    deleteContext(s->ctx);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+
+    pthread_mutex_lock(&liveLock);
+    if (--live == 0)
+        pthread_cond_signal(&drained);
+    pthread_mutex_unlock(&liveLock);
+}
+
+// Write an entire buffer, retrying short writes
+static int writeAll(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        data += n;
+        size -= n;
+    }
+    return 0;
+}
+
+// Run one line of input, returning nonzero if the session should quit
+static int respond(Session *s, char input[], size_t len) {
+    char *response;
+    size_t size;
+    FILE *out = open_memstream(&response, &size);
+    if (!out)
+        return 1;
+
+    // Capture command output
+    int quit = 0;
+    FILE *previous = useOutput(out);
+    if (len >= MAX)
+        output("Error: input too long. (max %d)\n", MAX - 1);
+    else
+        quit = execute(s->ctx, input);
+    useOutput(previous);
+    fclose(out);
+
+    // Send response, terminated by a NUL byte
+    if (writeAll(s->fd, response, size + 1))
+        quit = 1;
+    free(response);
+
+    return quit;
+}
+
+// Drain complete lines of a session on a pool thread
+static void runSession(void *arg) {
+    Session *s = arg;
+    char input[BUFFER_SIZE];
+
+    pthread_mutex_lock(&s->lock);
+    char *newline;
+    while (!s->hungup && (newline = memchr(s->buffer, '\n', s->len))) {
+        // Take line out of buffer
+        size_t len = newline - s->buffer;
+        memcpy(input, s->buffer, len);
+        input[len] = '\0';
+        s->len -= len + 1;
+        memmove(s->buffer, newline + 1, s->len);
+
+        // Resume reading once buffer has room
+        if (s->paused) {
+            struct epoll_event event = {.events = EPOLLIN, .data.ptr = s};
+            epoll_ctl(epfd, EPOLL_CTL_MOD, s->fd, &event);
+            s->paused = 0;
+        }
+        pthread_mutex_unlock(&s->lock);
+
+        // Run command without holding the lock
+        int quit = respond(s, input, len);
+
+        pthread_mutex_lock(&s->lock);
+        if (quit) {
+            shutdown(s->fd, SHUT_RDWR); // event loop sees hangup
+            break;
+        }
+    }
+
+    // Last one out deletes the session
+    s->busy = 0;
+    int release = s->hungup;
+    pthread_mutex_unlock(&s->lock);
+
+    if (release)
+        deleteSession(s);
+}
+
+static void hangup(Session *s) {
+    // Unlink from event loop
+    epoll_ctl(epfd, EPOLL_CTL_DEL, s->fd, NULL);
+    if (s->prev)
+        s->prev->next = s->next;
+    else
+        sessions = s->next;
+    if (s->next)
+        s->next->prev = s->prev;
+
+    // Delete now, unless a command is still running
+    pthread_mutex_lock(&s->lock);
+    s->hungup = 1;
+    int release = !s->busy;
+    pthread_mutex_unlock(&s->lock);
+
+    if (release)
+        deleteSession(s);
+}
+
+static void acceptSessions(int listener, Pool *pool) {
+    int fd;
+    while ((fd = accept(listener, NULL, NULL)) >= 0) {
+        // Create session with its own workspace
+        Session *s = calloc(1, sizeof(Session));
+        Context *ctx = s ? newContext(NULL, pool) : NULL;
+        if (!ctx) {
+            free(s);
+            close(fd);
+            continue;
+        }
+        s->fd = fd;
+        s->ctx = ctx;
+        pthread_mutex_init(&s->lock, NULL);
+
+        // Watch for input
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = s};
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event)) {
+            close(fd);
+            deleteContext(ctx);
+            free(s);
+            continue;
+        }
+
+        pthread_mutex_lock(&liveLock);
+        live++;
+        pthread_mutex_unlock(&liveLock);
+
+        // Link into event loop
+        s->next = sessions;
+        if (sessions)
+            sessions->prev = s;
+        sessions = s;
+    }
+}
+
+static void readSession(Session *s, Pool *pool) {
+    pthread_mutex_lock(&s->lock);
+    ssize_t n = read(s->fd, s->buffer + s->len, BUFFER_SIZE - s->len);
+    if (n <= 0) {
+        pthread_mutex_unlock(&s->lock);
+        if (n == 0 || errno != EINTR)
+            hangup(s);
+        return;
+    }
+    // Discard the tail of an overlong line
+    char *start = s->buffer + s->len;
+    if (s->skip) {
+        char *newline = memchr(start, '\n', n);
+        if (!newline) {
+            pthread_mutex_unlock(&s->lock);
+            return;
+        }
+        n -= newline - start;
+        memmove(start, newline, n);
+        s->skip = 0;
+    }
+    s->len += n;
+
+    int complete = memchr(s->buffer, '\n', s->len) != NULL;
+    if (s->len == BUFFER_SIZE) {
+        if (!complete) {
+            // Truncate overlong line, which is reported as too long
+            s->len = MAX;
+            s->skip = 1;
+        } else {
+            // Stop reading until pending lines are consumed
+            struct epoll_event event = {.events = 0, .data.ptr = s};
+            epoll_ctl(epfd, EPOLL_CTL_MOD, s->fd, &event);
+            s->paused = 1;
+        }
+    }
+
+    // Schedule session on the pool
+    if (complete && !s->busy) {
+        s->busy = 1;
+        poolSubmit(pool, runSession, s);
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+int serve(const char *path) {
+    // Validate socket path
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: socket path too long: %s\n", path);
+        return 1;
+    }
+    strcpy(addr.sun_path, path);
+
+    // Listen on socket
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path); // remove stale socket
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) ||
+        listen(listener, SOMAXCONN)) {
+        fprintf(stderr, "Error: could not listen on %s: %s\n", path, strerror(errno));
+        if (listener >= 0)
+            close(listener);
+        return 1;
+    }
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+
+    // Create event loop
+    epfd = epoll_create1(0);
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listener, &event);
+
+    // Stop on interrupt, and survive clients disconnecting mid-response
+    struct sigaction action = {.sa_handler = stop};
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    // Commands from all sessions share one pool
+    registerBuiltins();
+    Pool *pool = defaultPool();
+    printf("Serving on %s (%d threads).\n", path, poolSize(pool));
+    fflush(stdout);
+
+    // Begin running event loop
+    running = 1;
+    struct epoll_event events[MAX_EVENTS];
+    while (running) {
+        int n = epoll_wait(epfd, events, MAX_EVENTS, -1);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            break;
+
+        for (int i = 0; i < n; i++) {
+            Session *s = events[i].data.ptr;
+            if (!s)
+                acceptSessions(listener, pool);
+            else if (events[i].events & EPOLLIN)
+                readSession(s, pool);
+            else if (events[i].events & (EPOLLHUP | EPOLLERR))
+                hangup(s);
+        }
+    }
+
+    // Hang up all sessions, and wait for running commands
+    while (sessions)
+        hangup(sessions);
+    pthread_mutex_lock(&liveLock);
+    while (live > 0)
+        pthread_cond_wait(&drained, &liveLock);
+    pthread_mutex_unlock(&liveLock);
+
+    close(epfd);
+    close(listener);
+    unlink(path);
+    return 0;
+}
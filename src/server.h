@@ -0,0 +1,15 @@
+// File:        server.h
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#define BUFFER_SIZE 4096
+#define MAX_EVENTS 64
+
+// Function prototypes
+int serve(const char *);
+
+#endif
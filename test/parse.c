@@ -0,0 +1,128 @@
+// File:        parse.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mace/matrix.h"
+#include "mace/parse.h"
+
+// Numbers are converted by fast paths for short decimals and 19 digit
+// mantissas, falling back to strtod near ties. Every path must round
+// exactly as strtod does, to the bit.
+
+#define ROWS 256
+#define COLS 512
+#define TOKEN 40 // bytes of the longest token written
+
+static int failures;
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "failed: %s\n", what);
+        failures++;
+    }
+}
+
+// Numbers near the edges of each path, and of the range of doubles
+static const char *edges[] = {
+    "0",
+    "-0",
+    "1",
+    "0.1",
+    "1e22",
+    "1e23",
+    "9007199254740992",
+    "9007199254740993",
+    "9007199254740993.0000000001",
+    "18446744073709551615",
+    "18446744073709551616",
+    "2.2250738585072014e-308",
+    "2.2250738585072011e-308",
+    "4.9406564584124654e-324",
+    "2.4703282292062327e-324",
+    "2.4703282292062328e-324",
+    "1.7976931348623157e308",
+    "1.7976931348623158e308",
+    "1e-400",
+    "1e400",
+    "7.3177701707893310e+15",
+    "123456789012345678e-20",
+    "0.000000000000000000000000000001",
+    "+.5",
+    "5.",
+    "1E5",
+};
+
+// Advance a deterministic generator (splitmix64)
+static uint64_t next(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+}
+
+// Write a random decimal of up to 19 significant digits
+static void randomToken(uint64_t *state, char *out) {
+    int digits = next(state) % 19 + 1;
+    int point = next(state) % (digits + 1);
+    int exponent = (int)(next(state) % 651) - 340;
+    char *p = out;
+    if (next(state) % 2)
+        *p++ = '-';
+    for (int k = 0; k < digits; k++) {
+        if (k == point && k)
+            *p++ = '.';
+        *p++ = '0' + next(state) % 10;
+    }
+    if (next(state) % 4)
+        p += sprintf(p, "e%d", exponent);
+    *p = '\0';
+}
+
+// Parse tokens as one matrix, checking each entry against strtod
+static void checkTokens(char *tokens, int rows, int cols, const char *what) {
+    // Join tokens into rows of text
+    char *text = malloc((size_t)rows * cols * (TOKEN + 1)), *p = text;
+    for (int k = 0; k < rows * cols; k++) {
+        p += sprintf(p, "%s", &tokens[k * TOKEN]);
+        *p++ = ((k + 1) % cols) ? ' ' : '\n';
+    }
+
+    Matrix A = parseMat(text, p - text);
+    check(A.m == rows && A.n == cols, what);
+    for (int i = 0; !isNull(A) && i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            const char *token = &tokens[(i * cols + j) * TOKEN];
+            double x = strtod(token, NULL);
+            if (memcmp(&x, &A.data[i][j], sizeof(x))) {
+                fprintf(stderr, "%s: %.17g, not %.17g\n", token, A.data[i][j], x);
+                check(0, what);
+            }
+        }
+    }
+
+    if (!isNull(A))
+        deleteMat(&A);
+    free(text);
+}
+
+int main(void) {
+    int count = sizeof(edges) / sizeof(*edges);
+    char *tokens = malloc((size_t)ROWS * COLS * TOKEN);
+    for (int k = 0; k < count; k++)
+        snprintf(&tokens[k * TOKEN], TOKEN, "%s", edges[k]);
+    checkTokens(tokens, 1, count, "edge cases match strtod");
+
+    uint64_t state = 42;
+    for (int k = 0; k < ROWS * COLS; k++)
+        randomToken(&state, &tokens[k * TOKEN]);
+    checkTokens(tokens, ROWS, COLS, "random decimals match strtod");
+
+    free(tokens);
+    return failures ? 1 : 0;
+}
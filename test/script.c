@@ -0,0 +1,90 @@
+// File:        script.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../src/repl.h"
+#include "../src/script.h"
+#include "mace/mace.h"
+#include "mace/profile.h"
+
+// Scripts run each command on a fork of the workspace. Quantities a fork
+// derives from a matrix, such as its factors, are kept by the workspace, so
+// later commands reuse them, and rank-one updates refresh them in place.
+
+#define N 8 // large enough to factorize, rather than use fixed-size kernels
+
+static int failures;
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "failed: %s\n", what);
+        failures++;
+    }
+}
+
+// Write lines to a temporary file, returning its path
+static char *writeTemp(char *path, const char *text) {
+    int fd = mkstemp(path);
+    FILE *file = (fd < 0) ? NULL : fdopen(fd, "w");
+    if (!file)
+        return NULL;
+    fputs(text, file);
+    fclose(file);
+    return path;
+}
+
+int main(void) {
+    // Diagonally dominant, so every factorization succeeds
+    char data[N * N * 4] = "", *p = data;
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            int x = (i == j) ? 20 : (i * 3 + j * 5) % 7 - 3;
+            p += sprintf(p, "%d%c", x, (j < N - 1) ? ' ' : '\n');
+        }
+    }
+    char matPath[] = "/tmp/mace-test-XXXXXX";
+    if (!writeTemp(matPath, data))
+        return 1;
+
+    // Updates run alone, between commands deriving from the same matrix
+    char text[256];
+    snprintf(text, sizeof(text),
+             "load %s\n"
+             "inv a\n"
+             "set a 0 0 21\n"
+             "inv a\n"
+             "det a\n"
+             "cond a\n"
+             "set a 1 2 1\n"
+             "inv a\n",
+             matPath);
+    char scriptPath[] = "/tmp/mace-test-XXXXXX";
+    if (!writeTemp(scriptPath, text)) {
+        unlink(matPath);
+        return 1;
+    }
+
+    registerBuiltins();
+    Context *ctx = newContext(NULL, NULL);
+    maceSetProfiling(ctx, 1);
+    check(runScript(ctx, scriptPath) == 0, "script runs");
+
+    // Factorize and invert once, then update
+    Counters counters[KERNEL_COUNT];
+    readProfile(maceProfile(ctx), counters);
+    check(counters[KERNEL_LU].calls == 1, "factors are kept from forks");
+    check(counters[KERNEL_LUINV].calls == 1, "inverse is kept from forks");
+    check(counters[KERNEL_UPDATE].calls >= 2, "updates refresh kept factors");
+
+    deleteContext(ctx);
+    unlink(matPath);
+    unlink(scriptPath);
+    return failures ? 1 : 0;
+}
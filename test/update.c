@@ -0,0 +1,124 @@
+// File:        update.c
+// Author:      Zakhary Kaplan <https://zakhary.dev>
+// Created:     19 Oct 2026
+// SPDX-License-Identifier: NONE
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mace/mace.h"
+#include "mace/profile.h"
+
+// Setting elements, rows and columns of a matrix, or adding an outer product
+// to it, refreshes its cached factors and inverse with rank-one updates
+// rather than factorizing again. Results must match those of a fresh copy of
+// the updated matrix, which has nothing cached.
+
+#define N 12 // large enough to factorize, rather than use fixed-size kernels
+
+#define TOL 1e-9
+
+static int failures;
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "failed: %s\n", what);
+        failures++;
+    }
+}
+
+// Parse text into a new entry, returning its id
+static int parse(Context *ctx, const char *text) {
+    int id = -1;
+    check(maceParse(ctx, text, strlen(text), &id) == MACE_OK, "matrix parses");
+    return id;
+}
+
+// Copy the entries of ans, returning its size
+static int readAns(Context *ctx, double out[]) {
+    Matrix A;
+    if (maceGet(ctx, ANS, &A))
+        return 0;
+    for (int i = 0; i < A.m; i++) {
+        for (int j = 0; j < A.n; j++)
+            out[i * A.n + j] = A.data[i][j];
+    }
+    return A.m * A.n;
+}
+
+// Check that two arrays agree to within a tolerance relative to their size
+static void compare(const double x[], const double y[], int len, const char *what) {
+    double scale = 0, error = 0;
+    for (int k = 0; k < len; k++) {
+        scale = fmax(scale, fabs(y[k]));
+        error = fmax(error, fabs(x[k] - y[k]));
+    }
+    check(len > 0 && error <= TOL * fmax(scale, 1), what);
+}
+
+// Evaluate the inverse, determinant and solution of a system with a matrix
+static void evaluate(Context *ctx, int a, int b, double inv[], double *det, double x[]) {
+    check(maceInv(ctx, a) == MACE_OK && readAns(ctx, inv) == N * N, "inverse");
+    check(maceDet(ctx, a) == MACE_OK && readAns(ctx, det) == 1, "determinant");
+    check(maceSolve(ctx, a, b) == MACE_OK && readAns(ctx, x) == N, "solve");
+}
+
+int main(void) {
+    Context *ctx = newContext(NULL, NULL);
+    maceSetPrecision(ctx, PRECISION_FAST);
+    maceSetProfiling(ctx, 1);
+
+    // Diagonally dominant, so every factorization succeeds
+    char text[N * N * 32] = "", *p = text;
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            int x = (i == j) ? 30 : (i * 5 + j * 3) % 11 - 5;
+            p += sprintf(p, "%d%c", x, (j < N - 1) ? ' ' : '\n');
+        }
+    }
+    int a = parse(ctx, text);
+
+    // Operands of updates, and the right-hand side of systems
+    char row[N * 8] = "", col[N * 8] = "", *r = row, *c = col;
+    for (int k = 0; k < N; k++) {
+        r += sprintf(r, "%d ", k % 4 - 1);
+        c += sprintf(c, "%d\n", (k * 7) % 5 - 2);
+    }
+    int u = parse(ctx, col), v = parse(ctx, row), b = parse(ctx, col);
+
+    // Derive every quantity, then update it in place
+    double inv[N * N], det, x[N];
+    evaluate(ctx, a, b, inv, &det, x);
+    check(maceSet(ctx, a, 0, 0, 31) == MACE_OK, "set");
+    check(maceSet(ctx, a, 3, 7, 2.5) == MACE_OK, "set off diagonal");
+    check(maceSetRow(ctx, a, 5, v) == MACE_OK, "setrow");
+    check(maceSetCol(ctx, a, 9, u) == MACE_OK, "setcol");
+    check(maceUpdate(ctx, a, u, v) == MACE_OK, "update");
+    evaluate(ctx, a, b, inv, &det, x);
+
+    // Copy the updated matrix exactly, without its cache
+    Matrix A;
+    check(maceGet(ctx, a, &A) == MACE_OK, "updated matrix");
+    p = text;
+    for (int i = 0; i < A.m; i++) {
+        for (int j = 0; j < A.n; j++)
+            p += sprintf(p, "%.17g%c", A.data[i][j], (j < A.n - 1) ? ' ' : '\n');
+    }
+    int f = parse(ctx, text);
+
+    // Updates were applied, rather than factorizing again
+    Counters counters[KERNEL_COUNT];
+    readProfile(maceProfile(ctx), counters);
+    check(counters[KERNEL_LU].calls == 1, "factors are updated");
+    check(counters[KERNEL_UPDATE].calls >= 5, "every change is an update");
+
+    double freshInv[N * N], freshDet, freshX[N];
+    evaluate(ctx, f, b, freshInv, &freshDet, freshX);
+    compare(inv, freshInv, N * N, "updated inverse matches");
+    compare(&det, &freshDet, 1, "updated determinant matches");
+    compare(x, freshX, N, "updated solution matches");
+
+    deleteContext(ctx);
+    return failures ? 1 : 0;
+}